@@ -52,7 +52,7 @@ pushd "${MESON_SOURCE_ROOT}" &>/dev/null
 
 HAWCK_BIN=/usr/share/hawck/bin
 mkdir -p "$HAWCK_BIN"
-for src in src/scripts/*.sh src/scripts/*.awk; do
+for src in src/scripts/*.sh src/scripts/*.awk src/scripts/*.lua; do
     name=$(basename $src)
     echo "\$ install -m 755 '$src' '$HAWCK_BIN/$name'"
     install -m 755 "$src" "$HAWCK_BIN/$name"
@@ -78,6 +78,21 @@ KEYMAPS_DIR=/usr/share/hawck/keymaps
 [ -d $KEYMAPS_DIR ] && rm -r $KEYMAPS_DIR
 cp -r keymaps $KEYMAPS_DIR
 
+## Compute key name aliases for all installed keymaps, this has to be
+## redone when new keymaps are installed.
+LUA_PATH="$HAWCK_LLIB/?.lua;/usr/share/hawck/?.lua" \
+    lua5.3 "$HAWCK_BIN/gen-aliases.lua" "$KEYMAPS_DIR/aliases.idx" \
+    && ok "Generated keymap aliases"
+
+## Precompile LLib and the keymaps into a cache that every MacroD maps,
+## this also has to be redone when new keymaps are installed.
+mkdir -p /var/lib/hawck
+LUA_PATH="$HAWCK_LLIB/?.lua;/usr/share/hawck/?.lua" \
+    lua5.3 "$HAWCK_BIN/gen-cache.lua" /var/lib/hawck/module.cache \
+           "$HAWCK_LLIB" "$KEYMAPS_DIR" \
+    && chmod 644 /var/lib/hawck/module.cache \
+    && ok "Generated module cache"
+
 ICONS_DIR=/usr/share/hawck/icons
 [ -d $ICONS_DIR ] && rm -r $ICONS_DIR
 cp -r icons $ICONS_DIR
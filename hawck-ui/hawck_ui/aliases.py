@@ -0,0 +1,69 @@
+## ================================================================================
+## aliases.py is a part of hawck-ui, which is distributed under the
+## following license:
+##
+## Copyright (C) 2018 Jonas Møller (no) <jonasmo441@gmail.com>
+## All rights reserved.
+##
+## Redistribution and use in source and binary forms, with or without
+## modification, are permitted provided that the following conditions are met:
+##
+## 1. Redistributions of source code must retain the above copyright notice, this
+##    list of conditions and the following disclaimer.
+## 2. Redistributions in binary form must reproduce the above copyright notice,
+##    this list of conditions and the following disclaimer in the documentation
+##    and/or other materials provided with the distribution.
+##
+## THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+## ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+## WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+## DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+## FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+## DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+## SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+## CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+## OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+## OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+## SOFTWARE.
+## ================================================================================
+
+"""
+Reader for the keymap alias index written by gen-aliases.lua, see
+kbmap.readAliases in Keymap.lua for a description of the format.
+"""
+
+from typing import Dict, Optional, Tuple
+
+ALIAS_INDEX_MAGIC = b"HWKALIAS 1\n"
+
+class AliasIndex:
+    def __init__(self, path: str):
+        self.path = path
+        ## Maps keymap names to (offset, length) of their section.
+        self.index: Dict[str, Tuple[int, int]] = {}
+        with open(path, "rb") as f:
+            if f.readline() != ALIAS_INDEX_MAGIC:
+                raise ValueError(f"Not an alias index: {path}")
+            for line in iter(f.readline, b""):
+                if line == b"\n":
+                    break
+                lang, offset, length = line.decode("utf-8").split()
+                self.index[lang] = (int(offset), int(length))
+            self.data_start = f.tell()
+
+    def keymaps(self):
+        return self.index.keys()
+
+    def get(self, lang: str) -> Optional[Dict[str, str]]:
+        """Get the character to key name aliases of a keymap."""
+        if lang not in self.index:
+            return None
+        offset, length = self.index[lang]
+        with open(self.path, "rb") as f:
+            f.seek(self.data_start + offset)
+            data = f.read(length).decode("utf-8")
+        aliases = {}
+        for line in data.splitlines():
+            code, name = line.split("\t", 1)
+            aliases[chr(int(code, 16))] = name
+        return aliases
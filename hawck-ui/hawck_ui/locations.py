@@ -10,8 +10,11 @@ LOCATIONS = {
     "hawck_bin": "/usr/share/hawck/bin",
     "hawck_keys": "/var/lib/hawck-input/keys",
     "unsafe_mode_src": "/usr/share/hawck/keys/__UNSAFE_MODE.csv",
+    "alias_index": "/usr/share/hawck/keymaps/aliases.idx",
 }
-LOCATIONS["unsafe_mode_dst"] = os.path.join(LOCATIONS["hawck_keys"], "__UNSAFE_MODE.csv")
+## Passthrough keys of the current user, InputD only sends these to our MacroD
+LOCATIONS["user_keys"] = os.path.join(LOCATIONS["hawck_keys"], str(os.getuid()))
+LOCATIONS["unsafe_mode_dst"] = os.path.join(LOCATIONS["user_keys"], "__UNSAFE_MODE.csv")
 
 def resourcePath(*args):
     return os.path.join(os.path.dirname(__file__), *args)
@@ -2,9 +2,10 @@ from .privesc import getSudoMethod, SudoException
 su = getSudoMethod()
 
 @su.do("hawck-input")
-def copyKeys(src, script_name):
+def copyKeys(src, dst_dir, script_name):
     import shutil, os
-    dst = os.path.join("/", "var", "lib", "hawck-input", "keys", script_name + ".csv")
+    os.makedirs(dst_dir, mode=0o755, exist_ok=True)
+    dst = os.path.join(dst_dir, script_name + ".csv")
     shutil.copy(src, dst)
     os.chmod(dst, 0o644)
 
@@ -21,16 +22,16 @@ def killHawckInputD(sig):
     os.unlink("/var/lib/hawck-input/pid")
 
 @su.do("hawck-input")
-def setUnsafeMode(enabled):
+def setUnsafeMode(enabled, dst):
     from hawck_ui.locations import LOCATIONS
     import shutil, os, grp
     if enabled:
-        dst = LOCATIONS["unsafe_mode_dst"]
+        os.makedirs(os.path.dirname(dst), mode=0o755, exist_ok=True)
         shutil.copy(LOCATIONS["unsafe_mode_src"], dst)
         os.chown(dst, os.getuid(), grp.getgrnam("hawck-input-share").gr_gid)
         os.chmod(dst, 0o644)
     else:
-        os.unlink(LOCATIONS["unsafe_mode_dst"])
+        os.unlink(dst)
 
 @su.do("root")
 def setInputDSystemDAutostart(enabled):
@@ -52,6 +52,7 @@ from .cfgmsg import sendMacroD
 from .template_manager import TemplateManager
 from .log_retriever import LogRetriever
 from .locations import HAWCK_HOME, LOCATIONS, resourcePath
+from .aliases import AliasIndex
 from .privesc import SudoException
 
 pprint = PrettyPrinter(indent = 4).pprint
@@ -185,13 +186,23 @@ def makeListTextRow(text):
 
 class KeymapsList:
     def __init__(self):
+        self.lookup = {}
+        self.aliases = None
+        self.alias_cache = {}
+        ## The alias index lists every keymap that MacroD can use, this avoids
+        ## searching through the keymaps directory on startup.
+        try:
+            self.aliases = AliasIndex(LOCATIONS["alias_index"])
+            self.lookup = {lang: lang for lang in self.aliases.keymaps()}
+            return
+        except (OSError, ValueError):
+            pass
         keymaps_dir = list(filter(os.path.exists, ("/usr/share/kbd/keymaps", "/usr/share/keymaps")))
         if not keymaps_dir:
             raise OSError("Unable to find keymaps")
         paths = Popen(["find", keymaps_dir[0], "-name", "*map.gz"],
                       stdout=PIPE)
         map_rx = re.compile(r".*/([^/]+)\.k?map\.gz$")
-        self.lookup = {}
         for line in paths.stdout.readlines():
             path = line.strip().decode("utf-8")
             m = map_rx.match(path)
@@ -204,6 +215,15 @@ class KeymapsList:
     def get(self, lang):
         return self.lookup[lang]
 
+    def getAliases(self, lang):
+        """Get the character to key name aliases of a keymap, these are
+        the names that MacroD uses for characters typed with the keymap."""
+        if not self.aliases or not lang:
+            return {}
+        if lang not in self.alias_cache:
+            self.alias_cache[lang] = self.aliases.get(lang) or {}
+        return self.alias_cache[lang]
+
     def candidates(self, text):
         ## A dumb slow search where we prioritize items that start with `text`.
         return list(sorted((lang for lang, _ in self.lookup.items()
@@ -220,6 +240,7 @@ class Settings(Pluggable):
         self.cfg_path = os.path.expandvars("$HOME/.local/share/hawck/lua-comm.fifo")
         self.keymaps = KeymapsList()
         self.keymap_search_results = []
+        self.keymap = None
 
         ## Set up checkboxes
         try:
@@ -237,8 +258,9 @@ class Settings(Pluggable):
                     return on
                 handler.__name__ = handler_name
                 setattr(self.__class__, handler_name, handler)
+            self.keymap = sendMacroD(f"return config.keymap")[0]
             keymap_label = self.builder.get_object("keymap_name_label")
-            keymap_label.set_text(sendMacroD(f"return config.keymap")[0])
+            keymap_label.set_text(self.keymap)
         except OSError:
             print("Unable to set up options")
 
@@ -272,7 +294,7 @@ class Settings(Pluggable):
 
     @switchHandler
     def on_set_unsafe_mode(self, on: bool):
-        priv_actions.setUnsafeMode(on)
+        priv_actions.setUnsafeMode(on, LOCATIONS["unsafe_mode_dst"])
         self.setUnsafeModeText(on)
 
     def on_keymap_search_entry_search_changed(self, entry):
@@ -289,6 +311,7 @@ class Settings(Pluggable):
         listbox.unselect_row(row)
         popover.popdown()
         sendMacroD(f"config.keymap = {row.text!r}")
+        self.keymap = row.text
         label = self.builder.get_object("keymap_name_label")
         label.set_text(row.text)
 
@@ -541,7 +564,8 @@ class HawckMainWindow(MainWindow):
             [
                 os.path.join(LOCATIONS["hawck_bin"],
                              "install-hwk-script.sh"),
-                path
+                path,
+                str(os.getuid())
             ], stdout=PIPE, stderr=PIPE)
         out = p.stdout.read()
         ret = p.wait()
@@ -551,7 +575,8 @@ class HawckMainWindow(MainWindow):
             ## If unsafe mode is enabled we don't need to install any keys.
             if not self.settings.unsafe_mode:
                 try:
-                    priv_actions.copyKeys(out.strip(), self.getCurrentScriptName())
+                    priv_actions.copyKeys(out.strip(), LOCATIONS["user_keys"],
+                                          self.getCurrentScriptName())
                 except SudoException as e:
                     print(f"Unable to copy keys: {e}")
         ## Handle error
@@ -828,7 +853,10 @@ class HawckMainWindow(MainWindow):
             self.keycap_done = True
 
     def setKeyCaptureLabel(self, names):
-        fmt = " - ".join(names)
+        ## Show which key in the current keymap a typed character is.
+        aliases = self.settings.keymaps.getAliases(self.settings.keymap)
+        fmt = " - ".join(f"{n} ({aliases[n]})" if n in aliases else n
+                         for n in names)
         label = self.builder.get_object("key_capture_display")
         label.set_text(fmt)
 
@@ -1,7 +1,7 @@
 -- Aliases from unicode keys to names given in the
 -- keymap files.
--- Incomplete, see the scripts/kalias.py and scripts/get_aliases.lua
--- experiments to extend this list.
+-- Incomplete, used as a fallback for the per-keymap aliases
+-- generated by scripts/gen-aliases.lua.
 return {
   ["<"] = "less",
   ["\n"] = "Return",
@@ -0,0 +1,203 @@
+/* =====================================================================================
+ * Performance black box.
+ *
+ * Copyright (C) 2018 Jonas Møller (no) <jonasmo441@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * =====================================================================================
+ */
+
+#include "Blackbox.hpp"
+#include "SystemError.hpp"
+
+#include <algorithm>
+
+extern "C" {
+    #include <fcntl.h>
+    #include <string.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <time.h>
+    #include <unistd.h>
+}
+
+using namespace std;
+
+static constexpr char blackbox_magic[8] = {'H', 'W', 'K', 'B', 'B', 'O', 'X', '1'};
+
+struct Blackbox::Header {
+    char magic[8];
+    uint32_t record_size;
+    uint32_t capacity;
+    /** Number of records ever written, the next one goes into
+     *  records[num_written % capacity]. */
+    atomic<uint64_t> num_written;
+};
+
+static_assert(sizeof(BlackboxRecord) % 8 == 0, "BlackboxRecord must be padded");
+static_assert(sizeof(Blackbox::Header) % 8 == 0, "Blackbox::Header must be padded");
+
+static inline size_t ringSize(size_t capacity) noexcept {
+    return sizeof(Blackbox::Header) + capacity * sizeof(BlackboxRecord);
+}
+
+static inline bool validHeader(const Blackbox::Header *hdr, size_t len) noexcept {
+    return len >= sizeof(*hdr) &&
+           !memcmp(hdr->magic, blackbox_magic, sizeof(blackbox_magic)) &&
+           hdr->record_size == sizeof(BlackboxRecord) &&
+           hdr->capacity > 0 &&
+           len >= ringSize(hdr->capacity);
+}
+
+Blackbox::~Blackbox() {
+    if (hdr)
+        munmap(hdr, map_len);
+}
+
+void Blackbox::open(const string &path, size_t capacity) {
+    if (hdr)
+        return;
+    int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (fd == -1)
+        throw SystemError("Unable to open " + path + ": ", errno);
+
+    struct stat st;
+    alignas(Header) char buf[sizeof(Header)];
+    const Header *old = (const Header *) buf;
+    size_t len = ringSize(capacity);
+    bool keep = fstat(fd, &st) != -1 &&
+                pread(fd, buf, sizeof(buf), 0) == sizeof(buf) &&
+                validHeader(old, st.st_size) &&
+                old->capacity == capacity;
+
+    // New file, or one written with another layout. The file is left
+    // sparse, so only the records that are written take up space.
+    if (!keep && (ftruncate(fd, 0) == -1 || ftruncate(fd, len) == -1)) {
+        int err = errno;
+        close(fd);
+        throw SystemError("Unable to resize " + path + ": ", err);
+    }
+
+    void *map = mmap(nullptr, len, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    int err = errno;
+    close(fd);
+    if (map == MAP_FAILED)
+        throw SystemError("Unable to mmap " + path + ": ", err);
+
+    Header *h = (Header *) map;
+    if (!keep) {
+        memcpy(h->magic, blackbox_magic, sizeof(blackbox_magic));
+        h->record_size = sizeof(BlackboxRecord);
+        h->capacity = capacity;
+        h->num_written.store(0, memory_order_release);
+    }
+
+    hdr = h;
+    records = (BlackboxRecord *) ((char *) map + sizeof(Header));
+    map_len = len;
+    cur_sec = ::time(nullptr);
+}
+
+void Blackbox::commit() {
+    BlackboxRecord rec = {};
+    rec.time = cur_sec;
+    rec.num_events = counters[EVENTS].exchange(0, memory_order_relaxed);
+    rec.num_timeouts = counters[TIMEOUTS].exchange(0, memory_order_relaxed);
+    rec.num_stalls = counters[STALLS].exchange(0, memory_order_relaxed);
+    rec.num_hotplug = counters[HOTPLUG].exchange(0, memory_order_relaxed);
+    rec.num_reloads = counters[RELOADS].exchange(0, memory_order_relaxed);
+    rec.reload_us = counters[RELOAD_US].exchange(0, memory_order_relaxed);
+    rec.num_dropped = counters[DROPPED].exchange(0, memory_order_relaxed);
+    rec.max_queue = gauges[QUEUE];
+    rec.lua_kib = gauges[LUA_KIB];
+    if (lat.total()) {
+        // The quantiles are bucket bounds, which may exceed the maximum.
+        rec.lat_max_us = lat.max();
+        rec.lat_p50_us = min<uint64_t>(lat.quantile(0.50), rec.lat_max_us);
+        rec.lat_p99_us = min<uint64_t>(lat.quantile(0.99), rec.lat_max_us);
+    }
+    lat.reset();
+    for (auto &g : gauges)
+        g = 0;
+
+    // Nothing happened, keep the ring for seconds where something did.
+    if (!rec.num_events && !rec.num_timeouts && !rec.num_stalls &&
+        !rec.num_hotplug && !rec.num_reloads && !rec.num_dropped)
+        return;
+
+    // The time is written last, so a record that was cut short by a
+    // crash is left with a zero time and skipped by read().
+    uint64_t n = hdr->num_written.load(memory_order_relaxed);
+    BlackboxRecord *slot = &records[n % hdr->capacity];
+    __atomic_store_n(&slot->time, 0, __ATOMIC_RELEASE);
+    int64_t time = rec.time;
+    rec.time = 0;
+    *slot = rec;
+    __atomic_store_n(&slot->time, time, __ATOMIC_RELEASE);
+    hdr->num_written.store(n + 1, memory_order_release);
+}
+
+bool Blackbox::tick(int64_t now) {
+    if (!hdr)
+        return false;
+    if (now == cur_sec)
+        return false;
+    commit();
+    cur_sec = now;
+    return true;
+}
+
+vector<BlackboxRecord> Blackbox::read(const string &path) {
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd == -1)
+        throw SystemError("Unable to open " + path + ": ", errno);
+    struct stat st;
+    if (fstat(fd, &st) == -1) {
+        int err = errno;
+        close(fd);
+        throw SystemError("Unable to stat " + path + ": ", err);
+    }
+    size_t len = st.st_size;
+    void *map = (len >= sizeof(Header))
+        ? mmap(nullptr, len, PROT_READ, MAP_SHARED, fd, 0)
+        : MAP_FAILED;
+    close(fd);
+    if (map == MAP_FAILED || !validHeader((const Header *) map, len)) {
+        if (map != MAP_FAILED)
+            munmap(map, len);
+        throw SystemError("Not a black box ring: " + path);
+    }
+
+    const Header *h = (const Header *) map;
+    const BlackboxRecord *recs = (const BlackboxRecord *) ((const char *) map + sizeof(Header));
+    uint64_t n = h->num_written.load(memory_order_acquire);
+    uint64_t start = (n > h->capacity) ? n - h->capacity : 0;
+    vector<BlackboxRecord> out;
+    out.reserve(n - start);
+    for (uint64_t i = start; i < n; i++) {
+        const BlackboxRecord &rec = recs[i % h->capacity];
+        if (__atomic_load_n(&rec.time, __ATOMIC_ACQUIRE) != 0)
+            out.push_back(rec);
+    }
+    munmap(map, len);
+    return out;
+}
@@ -0,0 +1,172 @@
+/* =====================================================================================
+ * Performance black box.
+ *
+ * Copyright (C) 2018 Jonas Møller (no) <jonasmo441@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * =====================================================================================
+ */
+
+/** @file Blackbox.hpp
+ *
+ * @brief Crash-persistent ring of per-second performance aggregates.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <string>
+#include <vector>
+
+extern "C" {
+    #include <stdint.h>
+    #include <time.h>
+}
+
+#include "LatencyHistogram.hpp"
+
+/** Aggregates for one second of activity.
+ *
+ * Only counts and timings are stored, never which keys were pressed.
+ */
+struct BlackboxRecord {
+    /** Unix time of the second, 0 while the record is being written. */
+    int64_t time;
+    /** Events handled. */
+    uint32_t num_events;
+    /** Latency of handling an event, in µs. */
+    uint32_t lat_p50_us;
+    uint32_t lat_p99_us;
+    uint32_t lat_max_us;
+    /** Deepest the event queue got. */
+    uint32_t max_queue;
+    /** Timeouts and lost connections. */
+    uint32_t num_timeouts;
+    /** Event loop stalls caught by the watchdog. */
+    uint32_t num_stalls;
+    /** Input devices that were added or removed. */
+    uint32_t num_hotplug;
+    /** Scripts that were loaded or reloaded, and the total time it took. */
+    uint32_t num_reloads;
+    uint32_t reload_us;
+    /** Events dropped by rate limits or shedding. */
+    uint32_t num_dropped;
+    /** Memory used by the Lua states, in KiB. */
+    uint32_t lua_kib;
+};
+
+/** Ring of BlackboxRecords in a memory mapped file.
+ *
+ * The file is mapped shared, so the records written before a crash are
+ * still there when the daemon starts again, or when the file is read
+ * by hawck-blackbox. Seconds without any activity are not recorded.
+ *
+ * Counters may be updated from any thread, latencies, gauges and
+ * tick() must only be used from the event loop. All methods do nothing
+ * until open() has succeeded.
+ */
+class Blackbox {
+public:
+    enum Counter {
+        EVENTS,
+        TIMEOUTS,
+        STALLS,
+        HOTPLUG,
+        RELOADS,
+        RELOAD_US,
+        DROPPED,
+        NUM_COUNTERS
+    };
+
+    enum Gauge {
+        QUEUE,
+        LUA_KIB,
+        NUM_GAUGES
+    };
+
+    struct Header;
+
+private:
+    Header *hdr = nullptr;
+    BlackboxRecord *records = nullptr;
+    size_t map_len = 0;
+    int64_t cur_sec = 0;
+    LatencyHistogram lat;
+    std::atomic<uint32_t> counters[NUM_COUNTERS] = {};
+    /** Highest value of each gauge during the current second. */
+    uint32_t gauges[NUM_GAUGES] = {};
+
+    /** Write the aggregates of the current second and reset them. */
+    void commit();
+
+public:
+    Blackbox() = default;
+
+    ~Blackbox();
+
+    Blackbox(const Blackbox&) = delete;
+    Blackbox& operator=(const Blackbox&) = delete;
+
+    /** Map the ring at `path`, creating it if needed. A ring with a
+     *  different layout is cleared.
+     *
+     * @param capacity Number of seconds to keep.
+     * @throws SystemError if the file cannot be opened or mapped.
+     */
+    void open(const std::string &path, size_t capacity = 24 * 3600);
+
+    inline bool isOpen() const noexcept {
+        return hdr != nullptr;
+    }
+
+    inline void add(Counter c, uint32_t n = 1) noexcept {
+        if (hdr)
+            counters[c].fetch_add(n, std::memory_order_relaxed);
+    }
+
+    inline void latency(uint64_t us) noexcept {
+        if (hdr)
+            lat.add(us);
+    }
+
+    inline void gauge(Gauge g, uint32_t value) noexcept {
+        if (hdr && value > gauges[g])
+            gauges[g] = value;
+    }
+
+    /** Write a record when a new second has started.
+     *
+     * @param now Unix time in seconds.
+     * @return True if a new second started.
+     */
+    bool tick(int64_t now);
+
+    inline bool tick() {
+        return tick(::time(nullptr));
+    }
+
+    /** Read the records in a ring file, oldest first.
+     *
+     * @throws SystemError if the file is not a black box ring.
+     */
+    static std::vector<BlackboxRecord> read(const std::string &path);
+};
@@ -0,0 +1,152 @@
+/* =====================================================================================
+ * Injectable clocks.
+ *
+ * Copyright (C) 2018 Jonas Møller (no) <jonasmo441@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * =====================================================================================
+ */
+
+/** @file Clock.hpp
+ *
+ * @brief Time and sleeping, with a simulated clock for tests.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <set>
+#include <thread>
+
+/** Source of time for code that reads the time or sleeps.
+ *
+ * Components take a Clock so that tests can replace the real one with
+ * a SimClock, and run through timeouts and retry delays without
+ * waiting for them. Waiting on file descriptors, e.g poll() timeouts,
+ * still happens in real time.
+ */
+class Clock {
+public:
+    using duration = std::chrono::steady_clock::duration;
+    using time_point = std::chrono::steady_clock::time_point;
+
+    virtual ~Clock() = default;
+
+    virtual time_point now() = 0;
+
+    virtual void sleepFor(duration d) = 0;
+
+    /** The real monotonic clock, shared by everything that has not
+     *  been given another clock. */
+    static Clock &system() noexcept;
+};
+
+/** Clock backed by std::chrono::steady_clock. */
+class SystemClock : public Clock {
+public:
+    inline time_point now() override {
+        return std::chrono::steady_clock::now();
+    }
+
+    inline void sleepFor(duration d) override {
+        std::this_thread::sleep_for(d);
+    }
+};
+
+inline Clock &Clock::system() noexcept {
+    static SystemClock clk;
+    return clk;
+}
+
+/** Clock that only moves when advance() is called.
+ *
+ * Threads that call sleepFor() block until the clock has been advanced
+ * past the end of their sleep. Tests use waitSleepers() to find out
+ * when the threads under test have gone back to sleep, i.e when they
+ * have finished reacting to the time that passed.
+ */
+class SimClock : public Clock {
+private:
+    std::mutex mtx;
+    std::condition_variable cv;
+    time_point t;
+    /** Wake-up times of the threads that are sleeping. */
+    std::multiset<time_point> deadlines;
+    bool released = false;
+
+public:
+    /** The default start time is not zero, so that code which uses a
+     *  zero time as a sentinel keeps working. */
+    explicit SimClock(time_point start = time_point(std::chrono::hours(1)))
+        : t(start) {}
+
+    inline time_point now() override {
+        std::lock_guard<std::mutex> lock(mtx);
+        return t;
+    }
+
+    inline void sleepFor(duration d) override {
+        std::unique_lock<std::mutex> lock(mtx);
+        if (d <= duration::zero() || released)
+            return;
+        time_point until = t + d;
+        deadlines.insert(until);
+        cv.notify_all();
+        cv.wait(lock, [&]() { return t >= until || released; });
+    }
+
+    /** Move the clock forward and wake up the threads whose sleep
+     *  has ended. */
+    inline void advance(duration d) {
+        std::lock_guard<std::mutex> lock(mtx);
+        t += d;
+        deadlines.erase(deadlines.begin(), deadlines.upper_bound(t));
+        cv.notify_all();
+    }
+
+    /** Block until at least `n` threads are sleeping on the clock. */
+    inline void waitSleepers(size_t n) {
+        std::unique_lock<std::mutex> lock(mtx);
+        cv.wait(lock, [&]() { return deadlines.size() >= n; });
+    }
+
+    /** Wake up all sleeping threads and make every later sleep return
+     *  at once, so that the threads under test can be stopped. */
+    inline void release() {
+        std::lock_guard<std::mutex> lock(mtx);
+        released = true;
+        deadlines.clear();
+        cv.notify_all();
+    }
+
+    /** Advance the clock in steps of `step` until `d` has passed,
+     *  waiting for `n` threads to go back to sleep after every step. */
+    inline void run(duration d, duration step, size_t n) {
+        for (duration passed = duration::zero(); passed < d; passed += step) {
+            waitSleepers(n);
+            advance(step);
+        }
+        waitSleepers(n);
+    }
+};
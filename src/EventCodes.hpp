@@ -0,0 +1,89 @@
+/* =====================================================================================
+ * Event code names.
+ *
+ * Copyright (C) 2018 Jonas Møller (no) <jonasmo441@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * =====================================================================================
+ */
+
+/** @file EventCodes.hpp
+ *
+ * @brief Names of input event types and codes.
+ *
+ * The tables are generated at build time from linux/input-event-codes.h
+ * by tools/gen-event-codes.py, so new kernel key codes are picked up
+ * by recompiling. Names are looked up with a perfect hash, nothing is
+ * constructed at startup.
+ */
+
+#pragma once
+
+#include <string_view>
+
+#include "event_codes.hpp"
+
+namespace EventCodes {
+    /** Seeded FNV-1a, must match fnv1a() in gen-event-codes.py */
+    constexpr uint32_t hash(uint32_t seed, std::string_view s) noexcept {
+        uint32_t h = 2166136261u ^ seed;
+        for (char c : s) {
+            h ^= (uint8_t) c;
+            h *= 16777619u;
+        }
+        return h;
+    }
+
+    /** Look up a code by its full name, e.g "KEY_ESC" or "BTN_LEFT".
+     *
+     * @return Pointer to the entry, or nullptr if there is no such name.
+     */
+    constexpr const Entry *find(std::string_view name) noexcept {
+        uint32_t seed = hash_seeds[hash(0, name) % num_buckets];
+        const Entry *e = &entries[hash_slots[hash(seed, name) % num_entries]];
+        return (name == e->name) ? e : nullptr;
+    }
+
+    /** Get the name of an event type, e.g "EV_KEY".
+     *
+     * @return The name, or nullptr for unknown types.
+     */
+    constexpr const char *typeName(int type) noexcept {
+        if (type < 0 || (size_t) type >= num_types)
+            return nullptr;
+        return type_names[type];
+    }
+
+    /** Get the name of an event code, e.g "KEY_ESC" for (EV_KEY, 1).
+     *
+     * @return The name, or nullptr for unknown codes.
+     */
+    constexpr const char *codeName(int type, int code) noexcept {
+        if (type < 0 || (size_t) type >= num_types || code < 0 ||
+            (size_t) code >= num_codes[type])
+            return nullptr;
+        return code_names[type][code];
+    }
+
+    static_assert(find("KEY_ESC") && find("KEY_ESC")->code == 1,
+                  "Perfect hash does not match the generated tables");
+}
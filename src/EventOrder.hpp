@@ -0,0 +1,419 @@
+/* =====================================================================================
+ * Ordering of events passed through MacroD.
+ *
+ * Copyright (C) 2018 Jonas Møller (no) <jonasmo441@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * =====================================================================================
+ */
+
+/** @file EventOrder.hpp
+ *
+ * @brief Ordering of key events while MacroD is handling some of them.
+ *
+ * Passthrough keys are sent to MacroD and take a round trip before
+ * their results can be emitted, other keys could be emitted right
+ * away. Every event gets a slot in a queue when it has to wait, and
+ * slots are emitted in order once they are ready. Whether an event has
+ * to wait is decided by the dependency model in EventOrder::dependsOn.
+ *
+ * When MacroD falls behind, passthrough events are held back instead of
+ * being sent, and stale key repeats are shed, see EventOrder::shed.
+ *
+ * A reply can contain pauses, e.g from a macro played back with its
+ * original timing. The slot then emits its events a part at a time,
+ * see EventOrder::pause.
+ */
+
+#pragma once
+
+#include <deque>
+#include <vector>
+#include <chrono>
+#include <stdint.h>
+
+extern "C" {
+    #include <linux/input.h>
+}
+
+enum class OrderPolicy {
+    /** Every event waits for all earlier events, i.e total ordering. */
+    STRICT,
+    /** Events only wait for earlier events that they depend on. */
+    FASTLANE,
+};
+
+class EventOrder {
+    using SteadyClock = std::chrono::steady_clock;
+private:
+    struct Pause {
+        /** Position in Slot::out that the pause comes before. */
+        size_t pos;
+        std::chrono::microseconds duration;
+    };
+
+    struct Slot {
+        /** Event as it was read from the keyboard. */
+        struct input_event ev;
+        /** Modifiers held when the event was read. */
+        uint8_t mods;
+        /** Waiting for MacroD. */
+        bool pending;
+        /** Sent to MacroD, pending slots are held back while MacroD
+         *  is behind. */
+        bool sent;
+        /** Events to emit in place of ev when the slot is ready. */
+        std::vector<struct input_event> out;
+        /** When the event was sent to MacroD. */
+        SteadyClock::time_point sent_at;
+        /** Pauses in out, in order, see pause(). */
+        std::vector<Pause> pauses;
+        /** Number of events in out that have been emitted, only
+         *  the events before a pause are emitted early. */
+        size_t emitted;
+        /** Number of pauses that have been started. */
+        size_t num_paused;
+        /** Nothing more is emitted from the slot until then, zero when
+         *  the slot is not paused. */
+        SteadyClock::time_point resume_at;
+    };
+
+    OrderPolicy policy;
+    std::deque<Slot> slots;
+    /** Bitmask of modifiers currently held down, see modifierBit() */
+    uint8_t held_mods = 0;
+    /** Whether the last event that was pushed got a slot. */
+    bool last_queued = false;
+    /** MacroD is behind, see setLagging() */
+    bool lagging = false;
+    /** The last key event was shed, and the events following it are
+     *  shed too. */
+    bool shedding = false;
+    /** Number of repeats that were collapsed into an older repeat. */
+    uint64_t num_collapsed = 0;
+    /** Number of queued repeats removed because their key was released. */
+    uint64_t num_stale = 0;
+
+    /** Check whether an event has to wait for any slot. */
+    bool mustWait(const struct input_event &ev, uint8_t mods) const {
+        for (const auto &slot : slots)
+            if (dependsOn(ev, mods, slot))
+                return true;
+        return false;
+    }
+
+    /** Check if a slot holds a repeat of a key that can still be
+     *  removed, i.e it has not been sent to MacroD. */
+    static bool isQueuedRepeat(const Slot &slot, int code) {
+        return slot.ev.type == EV_KEY && slot.ev.code == code &&
+               slot.ev.value == 2 && !slot.sent;
+    }
+
+    void updateMods(const struct input_event &ev) {
+        if (ev.type != EV_KEY)
+            return;
+        if (uint8_t bit = modifierBit(ev.code)) {
+            if (ev.value)
+                held_mods |= bit;
+            else
+                held_mods &= ~bit;
+        }
+    }
+
+public:
+    explicit EventOrder(OrderPolicy policy = OrderPolicy::STRICT) : policy(policy) {}
+
+    /** Get the bit used for a modifier key in modifier masks.
+     *
+     * @return The bit, or 0 if the key is not a modifier.
+     */
+    static constexpr uint8_t modifierBit(int code) {
+        switch (code) {
+            case KEY_LEFTCTRL:   return 1 << 0;
+            case KEY_RIGHTCTRL:  return 1 << 1;
+            case KEY_LEFTSHIFT:  return 1 << 2;
+            case KEY_RIGHTSHIFT: return 1 << 3;
+            case KEY_LEFTALT:    return 1 << 4;
+            case KEY_RIGHTALT:   return 1 << 5;
+            case KEY_LEFTMETA:   return 1 << 6;
+            case KEY_RIGHTMETA:  return 1 << 7;
+            default:             return 0;
+        }
+    }
+
+    /** Check if an event depends on an earlier slot.
+     *
+     * With the strict policy everything depends on everything. With the
+     * fast lane policy a key event depends on a slot when:
+     *
+     *  - They are events for the same key, so a press is never
+     *    overtaken by its own release. Codes are only compared for
+     *    events of the same type, MSC_SCAN is not KEY_3.
+     *  - Either of them is a modifier key, as it changes the meaning
+     *    of every other key.
+     *  - Both were read while modifiers were held, e.g ctrl+c typed
+     *    while the macro for ctrl+x is running.
+     *
+     * Other events, like SYN_REPORT, stay with the event they follow,
+     * see push().
+     *
+     * The strict policy is kept while MacroD is behind, only stale
+     * repeats are shed then.
+     */
+    bool dependsOn(const struct input_event &ev, uint8_t mods, const Slot &slot) const {
+        if (policy == OrderPolicy::STRICT)
+            return true;
+        bool slot_is_key = slot.ev.type == EV_KEY;
+        return (ev.type == slot.ev.type && ev.code == slot.ev.code) ||
+               modifierBit(ev.code) ||
+               (slot_is_key && modifierBit(slot.ev.code)) ||
+               (mods && slot.mods);
+    }
+
+    /** Add an event read from a keyboard.
+     *
+     * @param ev The event.
+     * @param passthrough Whether the event goes to MacroD, in which
+     *                    case it always gets a slot. It is sent when
+     *                    takeUnsent() returns it.
+     * @return True if the event did not get a slot, and should be
+     *         emitted right away.
+     */
+    bool push(const struct input_event &ev, bool passthrough) {
+        updateMods(ev);
+        bool wait;
+        if (passthrough)
+            wait = true;
+        else if (ev.type != EV_KEY)
+            wait = last_queued && !slots.empty();
+        else
+            wait = mustWait(ev, held_mods);
+
+        last_queued = wait;
+        if (!wait)
+            return true;
+
+        Slot slot = {ev, held_mods, passthrough, false, {}, SteadyClock::time_point(),
+                     {}, 0, 0, SteadyClock::time_point()};
+        if (!passthrough)
+            slot.out.push_back(ev);
+        slots.push_back(std::move(slot));
+        return false;
+    }
+
+    /** Drop events that have gone stale while MacroD is behind.
+     *
+     * A key repeat is dropped when an older repeat of the same key is
+     * still queued, along with the SYN/MSC events that follow it. A key
+     * release removes the queued repeats of its key. Presses and
+     * releases are never dropped.
+     *
+     * Does nothing unless setLagging(true) was called, must be called
+     * for every event before push().
+     *
+     * @return True if the event should be dropped.
+     */
+    bool shed(const struct input_event &ev) {
+        if (ev.type != EV_KEY)
+            return shedding;
+        shedding = false;
+        if (!lagging || ev.value == 1)
+            return false;
+
+        if (ev.value == 2) {
+            for (const auto &slot : slots)
+                if (isQueuedRepeat(slot, ev.code)) {
+                    num_collapsed++;
+                    return shedding = true;
+                }
+            return false;
+        }
+
+        for (auto it = slots.begin(); it != slots.end();) {
+            if (!isQueuedRepeat(*it, ev.code)) {
+                it++;
+                continue;
+            }
+            num_stale++;
+            it = slots.erase(it);
+            while (it != slots.end() && it->ev.type != EV_KEY && !it->pending)
+                it = slots.erase(it);
+        }
+        return false;
+    }
+
+    /** Get the oldest passthrough event that has not been sent to
+     *  MacroD, and mark it as sent.
+     *
+     * @return False if there is no such event.
+     */
+    bool takeUnsent(struct input_event &ev, SteadyClock::time_point now) {
+        for (auto &slot : slots)
+            if (slot.pending && !slot.sent) {
+                slot.sent = true;
+                slot.sent_at = now;
+                ev = slot.ev;
+                return true;
+            }
+        return false;
+    }
+
+    /** Add an event received from MacroD to the oldest slot that was
+     *  sent to it. */
+    void reply(const struct input_event &ev) {
+        for (auto &slot : slots)
+            if (slot.pending && slot.sent) {
+                slot.out.push_back(ev);
+                return;
+            }
+    }
+
+    /** Mark the oldest slot that was sent to MacroD as ready. */
+    void done() {
+        for (auto &slot : slots)
+            if (slot.pending && slot.sent) {
+                slot.pending = false;
+                return;
+            }
+    }
+
+    /** Add a pause to the reply of the oldest slot that was sent to
+     *  MacroD, the events before it are emitted once the slots ahead
+     *  have been, and the events after it when the pause is over. */
+    void pause(std::chrono::microseconds duration) {
+        for (auto &slot : slots)
+            if (slot.pending && slot.sent) {
+                slot.pauses.push_back({slot.out.size(), duration});
+                return;
+            }
+    }
+
+    /** Remove the slots at the front of the queue that are ready,
+     *  up to the first one that is paused or waiting for MacroD.
+     *
+     * @param out Receives the events to emit, in order.
+     * @param now Used to time pauses, see pause().
+     */
+    void drain(std::vector<struct input_event> &out, SteadyClock::time_point now) {
+        while (!slots.empty() && slots.front().resume_at <= now) {
+            auto &slot = slots.front();
+            slot.resume_at = SteadyClock::time_point();
+            auto begin = slot.out.begin() + slot.emitted;
+            if (slot.num_paused < slot.pauses.size()) {
+                const Pause &p = slot.pauses[slot.num_paused++];
+                out.insert(out.end(), begin, slot.out.begin() + p.pos);
+                slot.emitted = p.pos;
+                slot.resume_at = now + p.duration;
+                continue;
+            }
+            if (slot.pending)
+                break;
+            out.insert(out.end(), begin, slot.out.end());
+            slots.pop_front();
+        }
+    }
+
+    /** Check if the queue is empty, i.e nothing is waiting for MacroD
+     *  or a pause. */
+    bool empty() const {
+        return slots.empty();
+    }
+
+    /** Time at which the pause holding up the queue is over.
+     *
+     * @return The time, or time_point::max() if the queue is not
+     *         paused.
+     */
+    SteadyClock::time_point pausedUntil() const {
+        if (slots.empty() || slots.front().resume_at == SteadyClock::time_point())
+            return SteadyClock::time_point::max();
+        return slots.front().resume_at;
+    }
+
+    /** Give up on MacroD, pending slots get their original event, and
+     *  pauses are cut short.
+     *
+     * A slot that has already emitted part of its reply instead keeps
+     * the rest of the events it received, emitting the original event
+     * after half a reply would type something the user never asked
+     * for.
+     *
+     * @param out Receives the events to emit, in order.
+     */
+    void abort(std::vector<struct input_event> &out) {
+        for (auto &slot : slots) {
+            if (slot.pending) {
+                if (!slot.emitted) {
+                    slot.out.clear();
+                    slot.out.push_back(slot.ev);
+                }
+                slot.pending = false;
+            }
+            slot.pauses.clear();
+            slot.num_paused = 0;
+            slot.resume_at = SteadyClock::time_point();
+        }
+        drain(out, SteadyClock::time_point());
+    }
+
+    /** Check if any slot is waiting for MacroD. */
+    bool hasPending() const {
+        for (const auto &slot : slots)
+            if (slot.pending)
+                return true;
+        return false;
+    }
+
+    /** Number of slots that were sent to MacroD and not answered yet. */
+    size_t numInflight() const {
+        size_t n = 0;
+        for (const auto &slot : slots)
+            n += slot.pending && slot.sent;
+        return n;
+    }
+
+    /** Time since the oldest slot that MacroD has not answered was
+     *  sent to it. */
+    SteadyClock::duration oldestPending(SteadyClock::time_point now) const {
+        for (const auto &slot : slots)
+            if (slot.pending && slot.sent)
+                return now - slot.sent_at;
+        return SteadyClock::duration::zero();
+    }
+
+    inline void setPolicy(OrderPolicy policy) {
+        this->policy = policy;
+    }
+
+    /** Tell the queue whether MacroD is behind, see shed() */
+    inline void setLagging(bool lagging) {
+        this->lagging = lagging;
+    }
+
+    inline uint64_t numCollapsed() const noexcept {
+        return num_collapsed;
+    }
+
+    inline uint64_t numStale() const noexcept {
+        return num_stale;
+    }
+};
@@ -75,7 +75,11 @@ int FSWatcher::getMaxWatchers() const {
 void FSWatcher::stop() noexcept(false) {
     int max_wait_usec = FSW_THREAD_STOP_TIMEOUT_SEC * 1000000;
     int wait_usec = 0;
-    running = RunState::STOPPING;
+    // Nothing to do if the callback already stopped the thread.
+    RunState state = RunState::RUNNING;
+    if (!running.compare_exchange_strong(state, RunState::STOPPING) &&
+        state == RunState::STOPPED)
+        return;
     while (running != RunState::STOPPED) {
         usleep(10);
         if ((wait_usec += 10) >= max_wait_usec)
@@ -101,12 +105,20 @@ void FSWatcher::add(string path) {
                                IN_MODIFY
                                | IN_DELETE
                                | IN_DELETE_SELF
-                               | IN_CREATE);
+                               | IN_CREATE
+                               | IN_MOVED_TO
+                               | IN_MOVED_FROM);
     if (wd == -1) {
         throw SystemError("Error in inotify_add_watch() for path: " + path);
     }
     path_to_wd[rpath] = wd;
     wd_to_path[wd] = rpath;
+
+    // Remember the directory contents so that they can be compared
+    // when rescanning.
+    struct stat stbuf;
+    if (stat(rpath.c_str(), &stbuf) != -1 && S_ISDIR(stbuf.st_mode))
+        dir_state[rpath] = scanDir(rpath);
 }
 
 void FSWatcher::remove(string path) {
@@ -123,11 +135,98 @@ void FSWatcher::remove(string path) {
     }
 
     int wd = path_to_wd[rpath];
-    path_to_wd.erase(rpath);
-    wd_to_path.erase(wd);
+    forget(wd);
     inotify_rm_watch(fd, wd);
 }
 
+void FSWatcher::forget(int wd) {
+    auto it = wd_to_path.find(wd);
+    if (it == wd_to_path.end())
+        return;
+    // The path may have been watched again with a new descriptor.
+    auto pit = path_to_wd.find(it->second);
+    if (pit != path_to_wd.end() && pit->second == wd) {
+        path_to_wd.erase(pit);
+        dir_state.erase(it->second);
+    }
+    wd_to_path.erase(it);
+}
+
+unordered_map<string, FSFileState> FSWatcher::scanDir(const string &dir_path) {
+    unordered_map<string, FSFileState> state;
+    DIR *dir = opendir(dir_path.c_str());
+    if (dir == nullptr)
+        return state;
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != nullptr) {
+        string path = dir_path + "/" + entry->d_name;
+        struct stat stbuf;
+        if (stat(path.c_str(), &stbuf) == -1 || S_ISDIR(stbuf.st_mode))
+            continue;
+        state[entry->d_name] = {stbuf.st_ino, stbuf.st_mtim, stbuf.st_size};
+    }
+    closedir(dir);
+    return state;
+}
+
+void FSWatcher::rescan() {
+    lock_guard<mutex> lock(events_mtx);
+    size_t num_events = events.size();
+
+    for (auto &[dir_path, known] : dir_state) {
+        auto current = scanDir(dir_path);
+
+        for (const auto &[name, st] : current) {
+            string path = dir_path + "/" + name;
+            auto it = known.find(name);
+            if (it == known.end()) {
+                if (auto_add) {
+                    try {
+                        add(path);
+                    } catch (const SystemError &e) {
+                        continue;
+                    }
+                }
+                events.push_back(new FSEvent(path, IN_CREATE, name));
+            } else if (it->second != st) {
+                // The file was replaced, the old watch refers to the
+                // previous inode.
+                auto wit = path_to_wd.find(path);
+                if (it->second.ino != st.ino && wit != path_to_wd.end()) {
+                    int wd = wit->second;
+                    forget(wd);
+                    inotify_rm_watch(fd, wd);
+                    try {
+                        add(path);
+                    } catch (const SystemError &e) {}
+                }
+                events.push_back(new FSEvent(path, IN_MODIFY, ""));
+            }
+        }
+
+        for (const auto &[name, st] : known) {
+            if (current.find(name) != current.end())
+                continue;
+            string path = dir_path + "/" + name;
+            auto wit = path_to_wd.find(path);
+            if (wit != path_to_wd.end()) {
+                int wd = wit->second;
+                forget(wd);
+                inotify_rm_watch(fd, wd);
+                FSEvent *ev = new FSEvent(path, IN_DELETE_SELF, "");
+                ev->deleted = true;
+                events.push_back(ev);
+            }
+            events.push_back(new FSEvent(dir_path, IN_DELETE, name));
+        }
+
+        known = move(current);
+    }
+
+    syslog(LOG_INFO, "FSWatcher rescan found %zu changes",
+           events.size() - num_events);
+}
+
 vector<FSEvent> *FSWatcher::addFrom(string dir_path) {
     DIR *dir = opendir(dir_path.c_str());
     if (dir == nullptr) {
@@ -162,51 +261,88 @@ vector<FSEvent> *FSWatcher::addFrom(string dir_path) {
 FSEvent *FSWatcher::handleEvent(struct inotify_event *ev) {
     FSEvent *fs_ev = nullptr;
 
+    if (ev->mask & IN_Q_OVERFLOW) {
+        syslog(LOG_WARNING, "inotify queue overflow, rescanning watched directories");
+        rescan();
+        return nullptr;
+    }
+
+    if (ev->mask & IN_IGNORED) {
+        forget(ev->wd);
+        return nullptr;
+    }
+
+    // Events may still be queued for files that were removed.
+    auto wit = wd_to_path.find(ev->wd);
+    if (wit == wd_to_path.end())
+        return nullptr;
+    string wd_path = wit->second;
+
+    // Keep the directory state up to date, so that a rescan only
+    // reports what inotify did not.
+    auto dit = dir_state.find(wd_path);
+    if (dit != dir_state.end() && ev->len > 0) {
+        if (ev->mask & (IN_DELETE | IN_MOVED_FROM)) {
+            dit->second.erase(ev->name);
+        } else {
+            struct stat stbuf;
+            string path = wd_path + "/" + ev->name;
+            if (stat(path.c_str(), &stbuf) != -1 && !S_ISDIR(stbuf.st_mode))
+                dit->second[ev->name] = {stbuf.st_ino, stbuf.st_mtim, stbuf.st_size};
+        }
+    }
+
     // File creation, needs to be added.
-    if (ev->mask & IN_CREATE) {
+    if (ev->mask & (IN_CREATE | IN_MOVED_TO)) {
         // Assemble directory and name into a full path
-        string dir_path = wd_to_path[ev->wd];
-        stringstream path;
-        path << dir_path << "/" << ev->name;
+        string path = wd_path + "/" + ev->name;
         if (auto_add)
             try {
-                add(path.str());
+                // A file moved over a watched one has a new inode.
+                auto pit = path_to_wd.find(path);
+                if (pit != path_to_wd.end()) {
+                    int wd = pit->second;
+                    forget(wd);
+                    inotify_rm_watch(fd, wd);
+                }
+                add(path);
             } catch (SystemError &e) {
                 return nullptr;
             }
-        fs_ev = new FSEvent(ev, path.str());
-    } else if (ev->mask & (IN_MODIFY | IN_DELETE | IN_DELETE_SELF)) {
+        fs_ev = new FSEvent(ev, path);
+        fs_ev->mask |= IN_CREATE;
+    } else if (ev->mask & (IN_MODIFY | IN_DELETE | IN_DELETE_SELF | IN_MOVED_FROM)) {
         // File modified, save event.
-        if (wd_to_path.find(ev->wd) == wd_to_path.end()) {
-            throw SystemError("Received watch descriptor for file that we are not watching.");
-        }
-        fs_ev = new FSEvent(ev, wd_to_path[ev->wd]);
-        //if (ev->mask & IN_DELETE) {
-        //    fs_ev->deleted = true;
-        //    if (ev->len > 0) {
-        //        //fs_ev->path += "/" + string(ev->name, ev->len);
-        //        delete fs_ev;
-        //        return nullptr;
-        //    }
-        //    //int wd = ev->wd;
-        //    //string rpath = wd_to_path[wd];
-        //    //path_to_wd.erase(rpath);
-        //    //wd_to_path.erase(wd);
-        //    //inotify_rm_watch(fd, wd);
-        //}
+        fs_ev = new FSEvent(ev, wd_path);
+        if (ev->mask & IN_MOVED_FROM)
+            fs_ev->mask |= IN_DELETE;
     } else {
         return nullptr;
     }
 
-    // Do not send events about directories.
-    if (fs_ev->deleted || !S_ISDIR(fs_ev->stbuf.st_mode) || watch_dirs) {
+    if (wanted(fs_ev))
         return fs_ev;
-    }
 
     delete fs_ev;
     return nullptr;
 }
 
+bool FSWatcher::wanted(const FSEvent *ev) const {
+    // Do not send events about directories.
+    return ev->deleted || !S_ISDIR(ev->stbuf.st_mode) || watch_dirs;
+}
+
+void FSWatcher::flushEvents(const FSWatchFn &callback) {
+    lock_guard<mutex> lock(events_mtx);
+    while (running == RunState::RUNNING && !events.empty()) {
+        FSEvent *fs_ev = events.front();
+        events.pop_front();
+        if (wanted(fs_ev) && !callback(*fs_ev))
+            running = RunState::STOPPING;
+        delete fs_ev;
+    }
+}
+
 void FSWatcher::watch(const function<bool(FSEvent &ev)> &callback) {
     // Local `running`, is set by the callback
     // Instance-wide `running` set by FSWatcher::stop()
@@ -216,10 +352,15 @@ void FSWatcher::watch(const function<bool(FSEvent &ev)> &callback) {
         pfd.events = POLLIN;
 
         try {
+            // Events left over from a rescan come first.
+            flushEvents(callback);
+            if (running != RunState::RUNNING)
+                break;
+
             // Poll with a timeout of 128 ms, this is so that we can check
             // `running` continuously.
             errno = 0;
-            switch (poll(&pfd, 1, 128)) {
+            switch (this->backup_num_read ? 1 : poll(&pfd, 1, 128)) {
                 case -1:
                     throw SystemError("Error in poll() on inotify fd: ", (int) errno);
 
@@ -253,9 +394,10 @@ void FSWatcher::watch(const function<bool(FSEvent &ev)> &callback) {
                                 running = RunState::STOPPING;
                             delete fs_ev;
                         }
+                        flushEvents(callback);
                         if (running != RunState::RUNNING) {
-                            p += sizeof(struct inotify_event);
-                            size_t len = (evbuf + sizeof(evbuf)) - p;
+                            p += sizeof(struct inotify_event) + ev->len;
+                            size_t len = &evbuf[num_read] - p;
                             memmove(&evbuf[0], p, len);
                             this->backup_num_read = len;
                             break;
@@ -282,6 +424,16 @@ FSEvent::FSEvent(struct inotify_event *ev, string path)
     }
 }
 
+FSEvent::FSEvent(string path, uint32_t mask, string name)
+    : path(path),
+      mask(mask),
+      name(name)
+{
+    if (stat(path.c_str(), &stbuf) == -1)
+        memset(&stbuf, 0, sizeof(stbuf));
+    rescanned = true;
+}
+
 FSEvent::FSEvent(string path) : path(path) {
     mask = 0;
     stat(path.c_str(), &stbuf);
@@ -54,6 +54,7 @@ extern "C" {
 #endif
 
 #include <vector>
+#include <deque>
 #include <string>
 #include <unordered_map>
 #include <thread>
@@ -62,8 +63,12 @@ extern "C" {
 #include <functional>
 #include <stdexcept>
 
-/** Number of items inside the event buffer of \link FSWatcher \endlink */
-static constexpr size_t EVBUF_ITEMS = 10;
+/** Number of items inside the event buffer of \link FSWatcher \endlink
+ *
+ * Every item has room for the longest possible name, so this is the
+ * least amount of events returned by a single read(). Bursts like a
+ * `git checkout` in a script directory generate hundreds of events. */
+static constexpr size_t EVBUF_ITEMS = 256;
 
 /** Time before runtime_error is thrown in stop() if it cannot stop
  *  the thread. */
@@ -73,7 +78,11 @@ static constexpr int FSW_THREAD_STOP_TIMEOUT_SEC = 15;
 struct FSEvent {
     /** Absolute path to file. */
     std::string path;
-    /** Mask received from inotify. */
+    /** Mask received from inotify.
+     *
+     * Files moved into a watched directory have IN_CREATE set along
+     * with IN_MOVED_TO, and files moved out of it have IN_DELETE set
+     * along with IN_MOVED_FROM. */
     uint32_t mask = 0;
     /** Name of file (relevent for directory events.) */
     std::string name;
@@ -83,10 +92,15 @@ struct FSEvent {
     bool added = false;
     /** True if this event was sent as a result of file deletion. */
     bool deleted = false;
+    /** True if this event was synthesized by FSWatcher::rescan() */
+    bool rescanned = false;
 
     /** Initialize an FSEvent from an inotify event */
     FSEvent(struct inotify_event *ev, std::string path);
 
+    /** Initialize a synthesized FSEvent. */
+    FSEvent(std::string path, uint32_t mask, std::string name);
+
     /** Initialize an FSEvent from an absolute path, assumed to
      *  be an `added` event. */
     explicit FSEvent(std::string path);
@@ -100,11 +114,33 @@ enum RunState {
     STOPPING,
 };
 
+/** State of a directory entry, used to find changes that inotify
+ *  did not report. */
+struct FSFileState {
+    ino_t ino;
+    struct timespec mtime;
+    off_t size;
+
+    inline bool operator==(const FSFileState &o) const {
+        return ino == o.ino && size == o.size &&
+               mtime.tv_sec == o.mtime.tv_sec &&
+               mtime.tv_nsec == o.mtime.tv_nsec;
+    }
+
+    inline bool operator!=(const FSFileState &o) const {
+        return !(*this == o);
+    }
+};
+
 /** File system watcher.
  *
  * Uses the Linux inotify API to listen for file system
  * events.
  *
+ * When the kernel event queue overflows (IN_Q_OVERFLOW) the watched
+ * directories are rescanned, and events are synthesized for the
+ * entries that were created, modified or deleted in the meantime.
+ *
  * Example:
  *
  *   FSWatcher fsw;
@@ -145,17 +181,22 @@ private:
     /** Inotify main file descriptor. */
     OSAPIHandle fd;
     /** Event buffer used to receive inotify events. */
+    alignas(struct inotify_event)
     char evbuf[EVBUF_ITEMS * (sizeof(struct inotify_event) + NAME_MAX + 1)];
     /** Maps paths to watch descriptors. */
     std::unordered_map<std::string, int> path_to_wd;
     /** Maps ids received from inotify to paths, ids are referred to
      *  as wd (watch-descriptor.) */
     std::unordered_map<int, std::string> wd_to_path;
+    /** Last known state of the entries in watched directories, maps
+     *  directory paths to entry names to their state. */
+    std::unordered_map<std::string,
+                       std::unordered_map<std::string, FSFileState>> dir_state;
     /** Protects \link FSWatcher::events \endlink */
     std::mutex events_mtx;
-    /** Holds received events, is emptied by calling
-     *  \link FSWatcher::getEvents() \endlink */
-    std::vector<FSEvent *> events;
+    /** Events synthesized by \link FSWatcher::rescan() \endlink that
+     *  have not yet been passed to the callback. */
+    std::deque<FSEvent *> events;
     /** Set to RUNNING when \link FSWatcher::watch() \endlink is called,
      *  is set to STOPPED by calling \link FSWatcher::stop() \endlink */
     std::atomic<RunState> running = RunState::STOPPED;
@@ -178,6 +219,19 @@ private:
     /** Handle an event. */
     FSEvent *handleEvent(struct inotify_event *ev);
 
+    /** Check whether an event should be passed to the callback. */
+    bool wanted(const FSEvent *ev) const;
+
+    /** Pass synthesized events to the callback until they run out, or
+     *  the watcher is stopped. */
+    void flushEvents(const FSWatchFn &callback);
+
+    /** Read the state of all non-directory entries in a directory. */
+    std::unordered_map<std::string, FSFileState> scanDir(const std::string &dir_path);
+
+    /** Forget about a watch descriptor, i.e after IN_IGNORED. */
+    void forget(int wd);
+
 public:
     /** Initialize inotify file descriptor.
      */
@@ -231,6 +285,18 @@ public:
      */
     std::vector<FSEvent> *addFrom(std::string path);
 
+    /** Rescan all watched directories.
+     *
+     * Compares the directory entries with their last known state by
+     * inode, mtime and size, then queues IN_CREATE, IN_MODIFY and
+     * IN_DELETE events for everything that changed. The events are
+     * passed to the callback before any new inotify events.
+     *
+     * This is done automatically when the inotify queue overflows, it
+     * must not be called while watch() is running in another thread.
+     */
+    void rescan();
+
     /** Remove a directory and the files within.
      *
      * @param path Path to directory.
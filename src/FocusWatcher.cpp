@@ -0,0 +1,213 @@
+/* =====================================================================================
+ * Window focus watcher.
+ *
+ * Copyright (C) 2018 Jonas Møller (no) <jonasmo441@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * =====================================================================================
+ */
+
+#include <thread>
+#include <algorithm>
+#include <unordered_set>
+
+#if MESON_COMPILE
+#include <hawck_config.h>
+#else
+#define USE_X11 0
+#endif
+
+extern "C" {
+    #include <unistd.h>
+    #include <poll.h>
+    #include <syslog.h>
+    #include <ctype.h>
+}
+
+#include "FocusWatcher.hpp"
+#if USE_X11
+#include "XLib.hpp"
+#endif
+
+using namespace std;
+
+#if USE_X11
+/** Displays opened by focus watchers, protected by x_error_mtx. */
+static unordered_set<Display *> watched_displays;
+static mutex x_error_mtx;
+/** Handler that was installed before ignoreXError. */
+static XErrorHandler prev_x_error_handler = nullptr;
+
+/** Windows can be destroyed between receiving the focus event and
+ *  querying their class, the default handler would exit() on the
+ *  resulting BadWindow error.
+ *
+ * The error handler is global to the process, so errors on other
+ *  displays, e.g the one used by XTestUDevice, are passed on to the
+ *  previous handler. */
+static int ignoreXError(Display *d, XErrorEvent *ev) {
+    XErrorHandler prev; {
+        lock_guard<mutex> lock(x_error_mtx);
+        if (watched_displays.count(d))
+            return 0;
+        prev = prev_x_error_handler;
+    }
+    return prev ? prev(d, ev) : 0;
+}
+
+/** Ignore errors on a display, see ignoreXError() */
+static void watchXErrors(const XLib *x, Display *d) {
+    static once_flag install_flag;
+    call_once(install_flag, [x]() {
+        lock_guard<mutex> lock(x_error_mtx);
+        prev_x_error_handler = x->SetErrorHandler(ignoreXError);
+    });
+    lock_guard<mutex> lock(x_error_mtx);
+    watched_displays.insert(d);
+}
+
+static void unwatchXErrors(Display *d) {
+    lock_guard<mutex> lock(x_error_mtx);
+    watched_displays.erase(d);
+}
+#endif
+
+FocusWatcher::FocusWatcher() {
+    ids[""] = FOCUS_NONE;
+}
+
+FocusWatcher::~FocusWatcher() {
+    stop();
+#if USE_X11
+    if (dpy) {
+        XLib::get()->CloseDisplay((Display *) dpy);
+        unwatchXErrors((Display *) dpy);
+    }
+#endif
+}
+
+int FocusWatcher::intern(string name) {
+    transform(name.begin(), name.end(), name.begin(), ::tolower);
+    lock_guard<mutex> lock(ids_mtx);
+    auto it = ids.find(name);
+    if (it != ids.end())
+        return it->second;
+    int id = ids.size();
+    ids[name] = id;
+    return id;
+}
+
+void FocusWatcher::update() {
+#if USE_X11
+    const XLib *x = XLib::get();
+    Display *d = (Display *) dpy;
+    Atom active = x->InternAtom(d, "_NET_ACTIVE_WINDOW", False);
+    Atom type;
+    int format;
+    unsigned long nitems, after;
+    unsigned char *data = nullptr;
+    Window win = None;
+
+    if (x->GetWindowProperty(d, DefaultRootWindow(d), active, 0, 1, False,
+                             XA_WINDOW, &type, &format, &nitems, &after,
+                             &data) == Success && data) {
+        if (nitems == 1)
+            win = *(Window *) data;
+        x->Free(data);
+    }
+
+    int id = FOCUS_NONE;
+    XClassHint hint;
+    if (win != None && x->GetClassHint(d, win, &hint)) {
+        if (hint.res_class)
+            id = intern(hint.res_class);
+        x->Free(hint.res_name);
+        x->Free(hint.res_class);
+    }
+    focus_id = id;
+#endif
+}
+
+bool FocusWatcher::begin() {
+#if USE_X11
+    if (running == RunState::RUNNING)
+        return true;
+
+    const XLib *x = XLib::get();
+    Display *d = x ? x->OpenDisplay(nullptr) : nullptr;
+    if (!d) {
+        syslog(LOG_WARNING, "Unable to open display, focus tracking is disabled");
+        return false;
+    }
+    dpy = d;
+    watchXErrors(x, d);
+    x->SelectInput(d, DefaultRootWindow(d), PropertyChangeMask);
+    update();
+
+    running = RunState::RUNNING;
+    std::thread t0([this]() {this->watch();});
+    t0.detach();
+    return true;
+#else
+    syslog(LOG_WARNING, "Built without X11, focus tracking is disabled");
+    return false;
+#endif
+}
+
+void FocusWatcher::watch() {
+#if USE_X11
+    const XLib *x = XLib::get();
+    Display *d = (Display *) dpy;
+    Atom active = x->InternAtom(d, "_NET_ACTIVE_WINDOW", False);
+    struct pollfd pfd;
+    pfd.fd = ConnectionNumber(d);
+    pfd.events = POLLIN;
+
+    while (running == RunState::RUNNING) {
+        // Poll with a timeout of 128 ms, this is so that we can check
+        // `running` continuously.
+        if (!x->Pending(d) && poll(&pfd, 1, 128) <= 0)
+            continue;
+
+        bool changed = false;
+        while (x->Pending(d)) {
+            XEvent ev;
+            x->NextEvent(d, &ev);
+            if (ev.type == PropertyNotify && ev.xproperty.atom == active)
+                changed = true;
+        }
+        // Focus changes come in bursts, only look up the last one.
+        if (changed)
+            update();
+    }
+#endif
+
+    running = RunState::STOPPED;
+}
+
+void FocusWatcher::stop() {
+    if (running != RunState::RUNNING)
+        return;
+    running = RunState::STOPPING;
+    while (running != RunState::STOPPED)
+        usleep(1000);
+}
@@ -0,0 +1,112 @@
+/* =====================================================================================
+ * Window focus watcher.
+ *
+ * Copyright (C) 2018 Jonas Møller (no) <jonasmo441@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * =====================================================================================
+ */
+
+/** @file FocusWatcher.hpp
+ *
+ * @brief Keep track of the currently focused application.
+ */
+
+#pragma once
+
+#include <string>
+#include <unordered_map>
+#include <mutex>
+#include <atomic>
+
+#include "FSWatcher.hpp"
+
+/** Focus id used when the focused application cannot be determined,
+ *  i.e when there is no display to watch. */
+static constexpr int FOCUS_UNKNOWN = -1;
+
+/** Focus id used when no window, or a window without a class, is focused. */
+static constexpr int FOCUS_NONE = 0;
+
+/** Window focus watcher.
+ *
+ * Subscribes to changes of the _NET_ACTIVE_WINDOW property on the X11
+ * root window and caches the class of the focused window. Application
+ * names are interned as integer ids, so checking which application
+ * has focus on the hot path is a single atomic load.
+ *
+ * Application names are compared case-insensitively.
+ *
+ * Example:
+ *
+ *   FocusWatcher fw;
+ *   int firefox = fw.intern("Firefox");
+ *   fw.begin();
+ *   ...
+ *   if (fw.current() == firefox)
+ *       doFirefoxThing();
+ */
+class FocusWatcher {
+private:
+    /** Display connection, opaque so that users of this class
+     *  do not have to include the X11 headers. */
+    void *dpy = nullptr;
+    /** Id of the focused application. */
+    std::atomic<int> focus_id = FOCUS_UNKNOWN;
+    /** Protects \link FocusWatcher::ids \endlink */
+    std::mutex ids_mtx;
+    /** Maps lowercase application names to ids. */
+    std::unordered_map<std::string, int> ids;
+    std::atomic<RunState> running = RunState::STOPPED;
+
+    /** Read the focused window from the display and update focus_id. */
+    void update();
+
+public:
+    FocusWatcher();
+
+    /** Stops the watcher thread and closes the display connection. */
+    ~FocusWatcher();
+
+    /** Connect to the display and spawn a thread that watches
+     *  for focus changes.
+     *
+     * @return False if there is no display to connect to, in this case
+     *         current() will keep returning FOCUS_UNKNOWN.
+     */
+    bool begin();
+
+    /** Watch for focus changes until stop() is called. */
+    void watch();
+
+    /** Stop watching. */
+    void stop();
+
+    /** Get the id of an application name, allocating a new one if
+     *  the name has not been seen before. */
+    int intern(std::string name);
+
+    /** Get the id of the currently focused application. */
+    inline int current() const noexcept {
+        return focus_id;
+    }
+};
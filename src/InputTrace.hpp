@@ -0,0 +1,98 @@
+/* =====================================================================================
+ * Input event trace files.
+ *
+ * Copyright (C) 2018 Jonas Møller (no) <jonasmo441@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * =====================================================================================
+ */
+
+/** @file InputTrace.hpp
+ *
+ * @brief Reading and writing input event traces.
+ *
+ * A trace is a flat array of `struct input_event`, the same format that
+ * is read from /dev/input/event*, so a trace can also be recorded with
+ * `cat /dev/input/eventN > trace`. Timestamps in traces written by
+ * hawck-workload are relative to the start of the trace.
+ *
+ * The size of `struct input_event` depends on the architecture, traces
+ * should be replayed on the architecture they were written on.
+ */
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+extern "C" {
+    #include <fcntl.h>
+    #include <unistd.h>
+    #include <sys/stat.h>
+    #include <linux/input.h>
+}
+
+#include "SystemError.hpp"
+
+/** Read all events from a trace file. */
+inline std::vector<struct input_event> readTrace(const std::string &path) {
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd == -1)
+        throw SystemError("Unable to open trace " + path + ": ", errno);
+    struct stat stbuf;
+    if (fstat(fd, &stbuf) == -1) {
+        close(fd);
+        throw SystemError("Unable to stat trace " + path + ": ", errno);
+    }
+
+    std::vector<struct input_event> evs(stbuf.st_size / sizeof(struct input_event));
+    char *buf = (char *) evs.data();
+    size_t len = evs.size() * sizeof(struct input_event);
+    for (size_t off = 0; off < len;) {
+        ssize_t n = read(fd, buf + off, len - off);
+        if (n <= 0) {
+            close(fd);
+            throw SystemError("Unable to read trace " + path + ": ", errno);
+        }
+        off += n;
+    }
+    close(fd);
+    return evs;
+}
+
+/** Write events to a trace file, replacing it if it exists. */
+inline void writeTrace(const std::string &path, const std::vector<struct input_event> &evs) {
+    int fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd == -1)
+        throw SystemError("Unable to create trace " + path + ": ", errno);
+    const char *buf = (const char *) evs.data();
+    size_t len = evs.size() * sizeof(struct input_event);
+    for (size_t off = 0; off < len;) {
+        ssize_t n = write(fd, buf + off, len - off);
+        if (n <= 0) {
+            close(fd);
+            throw SystemError("Unable to write trace " + path + ": ", errno);
+        }
+        off += n;
+    }
+    close(fd);
+}
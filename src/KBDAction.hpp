@@ -10,6 +10,18 @@ extern "C" {
     #include <linux/uinput.h>
     #include <linux/input.h>
     #include <stdint.h>
+    #include <sys/types.h>
+}
+
+#include <string>
+
+/** Directory holding the sockets that MacroD instances listen on. */
+static constexpr char KBD_SOCK_DIR[] = "/var/lib/hawck-input";
+
+/** Get the path of the socket that the MacroD of a user listens on,
+ *  InputD connects to one of these for every user session. */
+inline std::string kbdSocketPath(uid_t uid) {
+    return std::string(KBD_SOCK_DIR) + "/kbd-" + std::to_string(uid) + ".sock";
 }
 
 /** Actions as sent via UNIX socket from InputD to MacroD */
@@ -17,8 +29,14 @@ struct KBDAction {
     /** Whether this action signifies the end of a series of
      *  events. */
     uint8_t done : 1;
+    /** This action is not a reply, MacroD tells InputD whether it has
+     *  any scripts to run keys through (ev.value = 1) or not (0). */
+    uint8_t state : 1;
+    /** InputD waits ev.value µs before emitting the rest of the reply
+     *  to the current key. */
+    uint8_t pause : 1;
     /** The source keyboard for this event. */
-    uint8_t kbd : 7;
+    uint8_t kbd : 5;
     /** The event that was emitted, or should be emitted
      *  from the InputD UDevice. */
     struct input_event ev;
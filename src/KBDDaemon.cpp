@@ -30,10 +30,15 @@
 #include <iostream>
 #include <string>
 #include <chrono>
+#include <algorithm>
 
 extern "C" {
     #include <syslog.h>
     #include <grp.h>
+    #include <dirent.h>
+    #include <stdio.h>
+    #include <signal.h>
+    #include <sys/time.h>
 }
 
 #include "KBDDaemon.hpp"
@@ -55,10 +60,16 @@ using namespace Permissions;
 
 constexpr int FSW_MAX_WAIT_PERMISSIONS_US = 5 * 1000000;
 
-KBDDaemon::KBDDaemon() :
-    kbd_com("/var/lib/hawck-input/kbd.sock")
-{
+/** Set by SIGUSR1, rate limit counters are logged by the main loop. */
+static volatile sig_atomic_t dump_stats = 0;
+
+static void handleSigUsr1(int) {
+    dump_stats = 1;
+}
+
+KBDDaemon::KBDDaemon() {
     initPassthrough();
+    initSessions();
 }
 
 void KBDDaemon::addDevice(const std::string& device) {
@@ -66,24 +77,41 @@ void KBDDaemon::addDevice(const std::string& device) {
 }
 
 KBDDaemon::~KBDDaemon() {
+    watchdog.stop();
     for (Keyboard *kbd : kbds)
         delete kbd;
 }
 
+int KBDDaemon::keyDirUID(const std::string &dir_path) {
+    // Files in keys/<uid>/ belong to a single session.
+    if (pathDirname(dir_path) != data_dirs["keys"])
+        return -1;
+    unsigned uid;
+    char c;
+    if (sscanf(pathBasename(dir_path).c_str(), "%u%c", &uid, &c) != 1)
+        return -1;
+    return uid;
+}
+
+void KBDDaemon::rebuildPassthrough() {
+    for (auto &[uid, sess] : sessions) {
+        sess->passthrough_keys.clear();
+        for (const auto &[path, vec] : key_sources) {
+            int src_uid = keyDirUID(pathDirname(path));
+            if (src_uid == -1 || (uid_t) src_uid == uid)
+                sess->passthrough_keys.insert(vec->begin(), vec->end());
+        }
+    }
+}
+
 void KBDDaemon::unloadPassthrough(std::string path) {
     if (key_sources.find(path) != key_sources.end()) {
-        auto vec = key_sources[path];
-        for (int code : *vec)
-            passthrough_keys.erase(code);
-        delete vec;
+        delete key_sources[path];
         key_sources.erase(path);
 
         syslog(LOG_INFO, "Removing passthrough keys from: %s", path.c_str());
 
-        // Re-add keys
-        for (const auto &[_, vec] : key_sources)
-            for (int code : *vec)
-                passthrough_keys.insert(code);
+        rebuildPassthrough();
     }
 }
 
@@ -109,12 +137,11 @@ void KBDDaemon::loadPassthrough(std::string rel_path) {
             } catch (const std::exception &e) {
                 continue;
             }
-            if (i >= 0) {
-                passthrough_keys.insert(i);
+            if (i >= 0)
                 cells_i->push_back(i);
-            }
         }
         key_sources[path] = cells_i.release();
+        rebuildPassthrough();
         keys_fsw.add(path);
         syslog(LOG_INFO, "Loaded passthrough keys from: %s", path.c_str());
     } catch (const CSV::CSVError &e) {
@@ -142,12 +169,120 @@ void KBDDaemon::loadPassthrough(FSEvent *ev) {
     }
 }
 
-void KBDDaemon::initPassthrough() {
-    auto files = mkuniq(keys_fsw.addFrom(data_dirs["keys"]));
+void KBDDaemon::loadPassthroughDir(const std::string &dir_path) {
+    auto files = mkuniq(keys_fsw.addFrom(dir_path));
     for (auto &file : *files)
         loadPassthrough(&file);
 }
 
+void KBDDaemon::initPassthrough() {
+    const string &keys_dir = data_dirs["keys"];
+    loadPassthroughDir(keys_dir);
+
+    // Per-session keys are kept in keys/<uid>/
+    auto dir = shared_ptr<DIR>(opendir(keys_dir.c_str()), &closedir);
+    if (!dir)
+        return;
+    struct dirent *entry;
+    while ((entry = readdir(dir.get()))) {
+        string path = keys_dir + "/" + entry->d_name;
+        if (entry->d_type == DT_DIR && keyDirUID(path) != -1)
+            loadPassthroughDir(path);
+    }
+}
+
+void KBDDaemon::connectSession(const std::string &path, int tries) {
+    unsigned uid;
+    char c;
+    if (sscanf(pathBasename(path).c_str(), "kbd-%u.soc%c", &uid, &c) != 2 || c != 'k')
+        return;
+
+    // MacroD may not have called listen() or set the permissions
+    // of the socket yet.
+    shared_ptr<MacroSession> sess;
+    while (!sess) {
+        try {
+            sess = make_shared<MacroSession>(uid, path, macro_rate, macro_burst,
+                                             clock->now());
+        } catch (const SocketError &e) {
+            if (--tries <= 0) {
+                syslog(LOG_WARNING, "%s", e.what());
+                return;
+            }
+            clock->sleepFor(Milliseconds(100));
+        }
+    }
+
+    // Only the owner of the session may listen on its socket.
+    struct ucred cred = sess->com.getPeerCredentials();
+    if (cred.uid != uid) {
+        syslog(LOG_ERR, "Refusing MacroD socket %s owned by uid %u",
+               path.c_str(), (unsigned) cred.uid);
+        return;
+    }
+
+    lock_guard<mutex> lock(sessions_mtx);
+    sessions[uid] = sess;
+    last_uid = uid;
+    rebuildPassthrough();
+    updateActive();
+    syslog(LOG_INFO, "Connected to MacroD session of uid %u", uid);
+}
+
+void KBDDaemon::initSessions() {
+    auto dir = shared_ptr<DIR>(opendir(KBD_SOCK_DIR), &closedir);
+    if (dir) {
+        struct dirent *entry;
+        while ((entry = readdir(dir.get())))
+            if (entry->d_type == DT_SOCK)
+                connectSession(string(KBD_SOCK_DIR) + "/" + entry->d_name, 1);
+    }
+    readSeat();
+}
+
+void KBDDaemon::dropSession(const shared_ptr<MacroSession> &sess) {
+    {
+        lock_guard<mutex> lock(sessions_mtx);
+        auto it = sessions.find(sess->uid);
+        // The session may already have been replaced by a new connection.
+        if (it == sessions.end() || it->second != sess)
+            return;
+        sessions.erase(it);
+        updateActive();
+    }
+
+    // MacroD accepts a new connection after an error, if it is
+    // still running.
+    connectSession(kbdSocketPath(sess->uid), 1);
+}
+
+void KBDDaemon::readSeat() {
+    int uid = -1;
+    ifstream seat(string(SEAT_DIR) + "/" + SEAT_NAME);
+    for (string line; getline(seat, line);) {
+        if (line.compare(0, 11, "ACTIVE_UID=") == 0) {
+            try {
+                uid = stoi(line.substr(11));
+            } catch (const std::exception &e) {}
+            break;
+        }
+    }
+
+    lock_guard<mutex> lock(sessions_mtx);
+    if (uid != seat_uid)
+        syslog(LOG_INFO, "Active uid on %s changed to %d", SEAT_NAME, uid);
+    seat_uid = uid;
+    updateActive();
+}
+
+void KBDDaemon::updateActive() {
+    // Fall back to the last session that connected when there is no
+    // seat information, i.e without logind.
+    int uid = (seat_uid != -1) ? seat_uid : last_uid;
+    auto it = (uid != -1) ? sessions.find(uid) : sessions.end();
+    active = (it != sessions.end()) ? it->second : nullptr;
+}
+
 void KBDDaemon::updateAvailableKBDs() {
     available_kbds.clear();
     for (auto &kbd : kbds)
@@ -156,7 +291,11 @@ void KBDDaemon::updateAvailableKBDs() {
 }
 
 void KBDDaemon::run() {
-    KBDAction action;
+    try {
+        blackbox.open(home_path + "/blackbox");
+    } catch (const SystemError &e) {
+        syslog(LOG_WARNING, "Unable to open the black box: %s", e.what());
+    }
 
     for (auto& kbd : kbds) {
         syslog(LOG_INFO, "Attempting to get lock on device: %s @ %s",
@@ -166,8 +305,15 @@ void KBDDaemon::run() {
 
     updateAvailableKBDs();
 
+    keys_fsw.setWatchDirs(true);
     keys_fsw.begin([this](FSEvent &ev) {
-                       lock_guard<mutex> lock(passthrough_keys_mtx);
+                       lock_guard<mutex> lock(sessions_mtx);
+                       if (S_ISDIR(ev.stbuf.st_mode)) {
+                           // New keys/<uid>/ directory.
+                           if (ev.mask & IN_CREATE && keyDirUID(ev.path) != -1)
+                               loadPassthroughDir(ev.path);
+                           return true;
+                       }
                        syslog(LOG_INFO, "kbd file change on: %s", ev.path.c_str());
                        if (ev.mask & IN_DELETE_SELF)
                            unloadPassthrough(ev.path);
@@ -176,6 +322,29 @@ void KBDDaemon::run() {
                        return true;
                    });
 
+    sock_fsw.add(KBD_SOCK_DIR);
+    sock_fsw.setWatchDirs(true);
+    sock_fsw.setAutoAdd(false);
+    sock_fsw.begin([this](FSEvent &ev) {
+                       if (ev.mask & IN_CREATE && S_ISSOCK(ev.stbuf.st_mode))
+                           connectSession(ev.path, 20);
+                       return true;
+                   });
+
+    try {
+        seat_fsw.add(SEAT_DIR);
+        seat_fsw.setWatchDirs(true);
+        seat_fsw.setAutoAdd(false);
+        seat_fsw.begin([this](FSEvent &ev) {
+                           if (pathBasename(ev.path) == SEAT_NAME)
+                               readSeat();
+                           return true;
+                       });
+    } catch (const SystemError &e) {
+        syslog(LOG_WARNING, "Unable to watch %s, routing keys to the last "
+                            "MacroD session: %s", SEAT_DIR, e.what());
+    }
+
     input_fsw.add("/dev/input");
     input_fsw.setWatchDirs(true);
     input_fsw.setAutoAdd(false);
@@ -193,6 +362,7 @@ void KBDDaemon::run() {
 
                         syslog(LOG_INFO, "Input device hotplug event on: %s",
                                ev.path.c_str());
+                        blackbox.add(Blackbox::HOTPLUG);
 
                         lock_guard<mutex> lock(pulled_kbds_mtx);
 
@@ -211,7 +381,7 @@ void KBDDaemon::run() {
                             unsigned grp_perm;
                             int ret;
                             do {
-                                usleep(wait_inc_us);
+                                clock->sleepFor(chrono::microseconds(wait_inc_us));
                                 ret = stat(ev.path.c_str(), &stbuf);
                                 grp_perm = stbuf.st_mode & S_IRWXG;
 
@@ -251,118 +421,450 @@ void KBDDaemon::run() {
                         return true;
                     });
 
-    Keyboard *kbd = nullptr;
+    signal(SIGUSR1, handleSigUsr1);
+
+    if (watchdog_enabled)
+        watchdog.start();
+
+    vector<size_t> ready;
+    vector<input_event> batch;
     for (;;) {
-        bool had_key = false;
-        action.done = 0;
-        try {
-            available_kbds_mtx.lock();
-            vector<Keyboard*> kbds(available_kbds);
-            available_kbds_mtx.unlock();
-            int idx = kbdMultiplex(kbds, 64);
-            if (idx != -1) {
-                kbd = kbds[idx];
-                kbd->get(&action.ev);
-
-                // Throw away the key if the keyboard isn't locked yet.
-                if (kbd->getState() == KBDState::LOCKED)
-                    had_key = true;
-                // Always lock unlocked keyboards.
-                else if (kbd->getState() == KBDState::OPEN)
-                    kbd->lock();
+
+        if (watchdog.beat("poll"))
+            regrabAll();
+        blackbox.tick();
+
+        if (dump_stats) {
+            dump_stats = 0;
+            logStats();
+        }
+
+        int poll_ms = 64;
+        if (inflight) {
+            releaseDeferred(*inflight);
+            if (!order.hasPending()) {
+                inflight = nullptr;
+            } else if (!inflight->deferred.empty()) {
+                // Wake up when there are tokens for the next event.
+                auto wait = chrono::duration_cast<Milliseconds>(inflight->bucket.wait(1, clock->now()));
+                poll_ms = max(1, min(poll_ms, (int) wait.count() + 1));
             }
-        } catch (const KeyboardError &e) {
-            // Disable the keyboard,
-            syslog(LOG_ERR,
-                   "Read error on keyboard, assumed to be removed: %s",
-                   kbd->getName().c_str());
-            kbd->disable();
-            {
-                lock_guard<mutex> lock(available_kbds_mtx);
-                auto pos_it = find(available_kbds.begin(),
-                                   available_kbds.end(),
-                                   kbd);
-                available_kbds.erase(pos_it);
+        }
+        if (!order.empty()) {
+            emitReady();
+            // Wake up when the pause in a reply is over.
+            auto until = order.pausedUntil();
+            if (until != Clock::time_point::max()) {
+                auto wait = chrono::duration_cast<Milliseconds>(until - clock->now());
+                poll_ms = max(1, min(poll_ms, (int) wait.count() + 1));
             }
-            lock_guard<mutex> lock(pulled_kbds_mtx);
-            pulled_kbds.push_back(kbd);
         }
-
-        if (!had_key)
+        sendQueued();
+
+        // Deferred replies are not counted against MacroD, it has
+        // already answered.
+        if (inflight && inflight->deferred.empty() &&
+            order.oldestPending(clock->now()) > timeout &&
+            clock->now() - last_reply > timeout)
+        {
+            abortInflight("Timed out waiting for MacroD");
             continue;
+        }
 
-        bool is_passthrough; {
-            lock_guard<mutex> lock(passthrough_keys_mtx);
-            is_passthrough = passthrough_keys.count(action.ev.code);
+        // Replies come from the in-flight session, state reports from
+        // the active one.
+        shared_ptr<MacroSession> sess = inflight;
+        if (!sess) {
+            lock_guard<mutex> lock(sessions_mtx);
+            sess = active;
         }
+        available_kbds_mtx.lock();
+        vector<Keyboard*> kbds(available_kbds);
+        available_kbds_mtx.unlock();
+        if (!kbdMultiplex(kbds, poll_ms, sess ? sess->com.getFd() : -1, ready))
+            continue;
 
-        // Check if the key is listed in the passthrough set.
-        if (is_passthrough) {
-            input_event orig_ev = action.ev;
+        // MacroD is handled before the keyboards.
+        if (ready.back() == kbds.size()) {
+            recvSession(sess);
+            continue;
+        }
 
-            // Pass key to Lua executor
+        // Drain every keyboard that has input.
+        batch.clear();
+        for (size_t idx : ready) {
+            Keyboard *kbd = kbds[idx];
+            input_event evs[MAX_READ_EVENTS];
+            size_t n;
             try {
-                kbd_com.send(&action);
-
-                // Receive keys to emit from the macro daemon.
-                int count = 0;
-                for (;; count++) {
-                    kbd_com.recv(&action, timeout);
-                    if (action.done)
-                        break;
-                    udev.emit(&action.ev);
+                watchdog.stage("keyboard-read");
+                n = kbd->get(evs, MAX_READ_EVENTS);
+            } catch (const KeyboardError &e) {
+                // Disable the keyboard,
+                syslog(LOG_ERR,
+                       "Read error on keyboard, assumed to be removed: %s",
+                       kbd->getName().c_str());
+                watchdog.stage("keyboard-removed");
+                blackbox.add(Blackbox::HOTPLUG);
+                kbd->disable();
+                {
+                    lock_guard<mutex> lock(available_kbds_mtx);
+                    auto pos_it = find(available_kbds.begin(),
+                                       available_kbds.end(),
+                                       kbd);
+                    available_kbds.erase(pos_it);
                 }
-                // Flush received keys and continue on.
-                udev.flush();
-                // Skip emmision of the original key if everything went OK
-                if (count == 0)
-                    cout << "MacroD swallowed event" << endl;
-                continue;
-            } catch (const SocketError &e) {
-                lock_guard<mutex> lock(available_kbds_mtx);
-
-                cout << "Resetting connection ..." << endl;
-
-                udev.emit(&orig_ev);
-                udev.upAll();
-                udev.flush();
-                udev.upAll();
-                udev.flush();
-
-                // Unlock all keyboards so that the user can actually type.
-                for (auto& kbd : available_kbds)
-                    try {
-                        syslog(LOG_INFO, "Unlocking keyboard due to error: \"%s\" @ %s",
-                               kbd->getName().c_str(), kbd->getPhys().c_str());
-                        kbd->unlock();
-                    } catch (const KeyboardError &e) {
-                        syslog(LOG_ERR, "Unable to unlock keyboard: %s", kbd->getName().c_str());
-                        kbd->disable();
-                    }
-
-                syslog(LOG_CRIT, "Unable to communicate with MacroD, reconnecting ...");
-
-                // Reconnect.
-                kbd_com.recon();
-
-                // Lock keyboards
-                for (auto& kbd : available_kbds)
-                    try {
-                        kbd->lock();
-                    } catch (const KeyboardError &e) {
-                        // Report the error and continue, further keyboard
-                        // errors will be caught in kbd->get() later on.
-                        syslog(LOG_ERR, "Unable to lock keyboard: %s", kbd->getName().c_str());
-                    }
-
-                // Skip the received event
+                lock_guard<mutex> lock(pulled_kbds_mtx);
+                pulled_kbds.push_back(kbd);
                 continue;
             }
+
+            // Throw away the keys if the keyboard isn't locked yet.
+            if (kbd->getState() == KBDState::LOCKED)
+                batch.insert(batch.end(), evs, evs + n);
+            // Always lock unlocked keyboards.
+            else if (kbd->getState() == KBDState::OPEN)
+                kbd->lock();
+        }
+
+        // Keys from different keyboards, e.g a chord played across a
+        // keyboard and a foot pedal, are handled in the order they
+        // were pressed, and sent to MacroD together.
+        if (ready.size() > 1)
+            stable_sort(batch.begin(), batch.end(),
+                        [](const input_event &a, const input_event &b) {
+                            return timercmp(&a.time, &b.time, <);
+                        });
+
+        if (isIdle()) {
+            if (batch.empty())
+                continue;
+            // Nothing is waiting in `order` when idle, so every event
+            // goes straight through, it only keeps track of modifiers.
+            for (const auto &ev : batch)
+                order.push(ev, false);
+            blackbox.add(Blackbox::EVENTS, batch.size());
+            watchdog.stage("uinput-flush");
+            udev.forward(batch.data(), batch.size());
+            continue;
+        }
+
+        bool emitted = false;
+        for (const auto &ev : batch)
+            emitted |= handleInput(ev);
+        if (emitted) {
+            watchdog.stage("uinput-flush");
+            udev.flush();
         }
+        sendQueued();
+    }
+}
+
+bool KBDDaemon::isIdle() {
+    bool idle; {
+        lock_guard<mutex> lock(sessions_mtx);
+        idle = !inflight && order.empty() &&
+               (!active || active->idle || active->passthrough_keys.empty());
+    }
+    if (idle != idle_mode) {
+        syslog(LOG_INFO, idle ? "No scripts are active, forwarding keys directly"
+                              : "Scripts are active, passing keys to MacroD");
+        idle_mode = idle;
+    }
+    return idle;
+}
 
-        udev.emit(&action.ev);
-        udev.flush();
+void KBDDaemon::recvSession(const shared_ptr<MacroSession> &sess) {
+    KBDAction actions[MAX_READ_REPLIES];
+    size_t n;
+    watchdog.stage("macrod-recv");
+    try {
+        n = sess->com.recvMany(actions, MAX_READ_REPLIES, timeout);
+    } catch (const SocketError &e) {
+        if (sess == inflight) {
+            abortInflight(e.what());
+        } else {
+            syslog(LOG_ERR, "Lost connection to MacroD of uid %u: %s",
+                   (unsigned) sess->uid, e.what());
+            dropSession(sess);
+        }
+        return;
     }
+
+    bool had_reply = false;
+    for (size_t i = 0; i < n; i++) {
+        const KBDAction &action = actions[i];
+        if (action.state) {
+            lock_guard<mutex> lock(sessions_mtx);
+            sess->idle = !action.ev.value;
+        } else if (sess != inflight) {
+            syslog(LOG_WARNING, "Ignoring reply from MacroD of uid %u, no keys were sent",
+                   (unsigned) sess->uid);
+        } else {
+            governReply(*inflight, action);
+            had_reply = true;
+        }
+    }
+    if (!had_reply)
+        return;
+
+    last_reply = clock->now();
+    if (!order.hasPending())
+        inflight = nullptr;
+    emitReady();
+    sendQueued();
+}
+
+bool KBDDaemon::handleInput(const input_event &ev) {
+    blackbox.add(Blackbox::EVENTS);
+
+    // Only the active session is looked at, other sessions
+    // do not receive anything. Keys keep going to the in-flight
+    // session until it has answered, so that replies are not mixed
+    // up when the active session changes.
+    shared_ptr<MacroSession> sess;
+    watchdog.stage("sessions-lock");
+    bool is_passthrough; {
+        lock_guard<mutex> lock(sessions_mtx);
+        sess = inflight ? inflight : active;
+        is_passthrough = sess && ev.type == EV_KEY &&
+                         sess->passthrough_keys.count(ev.code);
+    }
+
+    // Drop repeats that have gone stale while MacroD is behind.
+    if (order.shed(ev)) {
+        blackbox.add(Blackbox::DROPPED);
+        return false;
+    }
+
+    // Only repeats are limited, typed presses and releases always
+    // go through and do not use up tokens.
+    if (!is_passthrough && ev.type == EV_KEY && ev.value == 2 &&
+        !input_bucket.take(1, clock->now()))
+    {
+        num_input_dropped++;
+        blackbox.add(Blackbox::DROPPED);
+        return false;
+    }
+
+    if (order.push(ev, is_passthrough)) {
+        udev.emit(&ev);
+        return true;
+    }
+
+    if (is_passthrough) {
+        if (inflight != sess)
+            last_reply = clock->now();
+        inflight = sess;
+    }
+    return false;
+}
+
+bool KBDDaemon::updateLag() {
+    bool lagging = inflight && (order.numInflight() >= lag_depth ||
+                                order.oldestPending(clock->now()) >= lag_time);
+    blackbox.gauge(Blackbox::QUEUE, order.numInflight());
+    if (lagging && !was_lagging)
+        num_lag++;
+    was_lagging = lagging;
+    order.setLagging(lagging);
+    return lagging;
+}
+
+void KBDDaemon::sendQueued() {
+    vector<KBDAction> actions;
+    KBDAction action;
+    memset(&action, 0, sizeof(action));
+    // Pass keys to the Lua executor, replies are picked up by
+    // kbdMultiplex() when they arrive.
+    while (!updateLag() && order.takeUnsent(action.ev, clock->now()))
+        actions.push_back(action);
+    if (actions.empty())
+        return;
+    watchdog.stage("macrod-send");
+    try {
+        inflight->com.send(actions);
+    } catch (const SocketError &e) {
+        abortInflight(e.what());
+    }
+}
+
+void KBDDaemon::emitReady() {
+    vector<input_event> evs;
+    order.drain(evs, clock->now());
+    if (evs.empty())
+        return;
+    watchdog.stage("uinput-flush");
+    for (auto &ev : evs)
+        udev.emit(&ev);
+    udev.flush();
+}
+
+void KBDDaemon::abortInflight(const char *why) {
+    vector<input_event> evs;
+    order.abort(evs);
+    blackbox.add(Blackbox::TIMEOUTS);
+    watchdog.stage("uinput-flush");
+    for (auto &ev : evs)
+        udev.emit(&ev);
+    udev.upAll();
+    udev.flush();
+    udev.upAll();
+    udev.flush();
+
+    // Keys are passed straight through until MacroD
+    // can be reached again.
+    syslog(LOG_CRIT, "Unable to communicate with MacroD of uid %u: %s",
+           (unsigned) inflight->uid, why);
+    dropSession(inflight);
+    inflight = nullptr;
+}
+
+void KBDDaemon::governReply(MacroSession &sess, const KBDAction &action) {
+    // Markers carry no event, and are never held back or dropped.
+    bool is_marker = action.done || action.pause;
+    if (sess.deferred.empty() && (is_marker || sess.bucket.take(1, clock->now()))) {
+        forwardReply(sess, action);
+        return;
+    }
+
+    if (!sess.rate_warned) {
+        syslog(LOG_WARNING, "MacroD of uid %u exceeded its output rate of %g events/s",
+               (unsigned) sess.uid, macro_rate);
+        sess.rate_warned = true;
+    }
+
+    // Releases are never dropped, that would leave keys stuck.
+    bool is_release = action.ev.type == EV_KEY && action.ev.value == 0;
+    if (rate_policy == RatePolicy::DROP) {
+        if (!is_marker && action.ev.type == EV_KEY && !is_release) {
+            sess.num_dropped++;
+            blackbox.add(Blackbox::DROPPED);
+        } else {
+            forwardReply(sess, action);
+        }
+        return;
+    }
+
+    if (sess.deferred.size() >= MAX_DEFERRED && !is_marker && !is_release) {
+        sess.num_dropped++;
+        blackbox.add(Blackbox::DROPPED);
+        return;
+    }
+    sess.deferred.push_back(action);
+    if (!is_marker)
+        sess.num_deferred++;
+}
+
+void KBDDaemon::forwardReply(MacroSession &sess, const KBDAction &action) {
+    if (action.done) {
+        auto rtt = order.oldestPending(clock->now());
+        blackbox.latency(chrono::duration_cast<chrono::microseconds>(rtt).count());
+        order.done();
+    } else if (action.pause) {
+        order.pause(chrono::microseconds(action.ev.value));
+    } else {
+        order.reply(action.ev);
+        sess.num_emitted++;
+    }
+}
+
+void KBDDaemon::releaseDeferred(MacroSession &sess) {
+    while (!sess.deferred.empty() &&
+           (sess.deferred.front().done || sess.deferred.front().pause ||
+            sess.bucket.take(1, clock->now())))
+    {
+        forwardReply(sess, sess.deferred.front());
+        sess.deferred.pop_front();
+    }
+}
+
+void KBDDaemon::releaseAll(const char *stage) {
+    syslog(LOG_CRIT, "Event loop stalled in %s, releasing keyboards", stage);
+    num_stalls++;
+    blackbox.add(Blackbox::STALLS);
+    // The list of keyboards does not change after startup, and the
+    // locks that protect the others may be held by the stalled code.
+    for (Keyboard *kbd : kbds) {
+        try {
+            kbd->unlock();
+        } catch (const KeyboardError &e) {
+            syslog(LOG_ERR, "Unable to release keyboard %s: %s",
+                   kbd->getName().c_str(), e.what());
+        }
+    }
+}
+
+void KBDDaemon::regrabAll() {
+    syslog(LOG_WARNING, "Event loop recovered, locking keyboards");
+    {
+        lock_guard<mutex> lock(available_kbds_mtx);
+        for (Keyboard *kbd : available_kbds) {
+            if (kbd->getState() != KBDState::OPEN)
+                continue;
+            kbd->discardPending();
+            try {
+                kbd->lock();
+            } catch (const SystemError &e) {
+                syslog(LOG_ERR, "Unable to lock keyboard %s: %s",
+                       kbd->getName().c_str(), e.what());
+            }
+        }
+    }
+    // Keys released while the keyboards were free never reached the
+    // virtual device.
+    udev.upAll();
+    udev.flush();
+}
+
+void KBDDaemon::logStats() {
+    lock_guard<mutex> lock(sessions_mtx);
+    for (const auto &[uid, sess] : sessions)
+        syslog(LOG_INFO, "MacroD of uid %u: %lu emitted, %lu deferred, %lu dropped",
+               (unsigned) uid, (unsigned long) sess->num_emitted,
+               (unsigned long) sess->num_deferred, (unsigned long) sess->num_dropped);
+    syslog(LOG_INFO, "Keyboards: %lu repeats dropped", (unsigned long) num_input_dropped);
+    syslog(LOG_INFO, "Event loop stalled %lu times", (unsigned long) num_stalls);
+    syslog(LOG_INFO, "MacroD fell behind %lu times, %lu repeats collapsed, "
+                     "%lu stale repeats removed",
+           (unsigned long) num_lag, (unsigned long) order.numCollapsed(),
+           (unsigned long) order.numStale());
+    if (udev.isProbing())
+        syslog(LOG_INFO, "Output delivery latency: %s, %lu SYN_DROPPED, "
+                         "%lu frames not delivered",
+               udev.deliveryLatency().summary().c_str(),
+               (unsigned long) udev.numSynDropped(),
+               (unsigned long) udev.numUndelivered());
+}
+
+void KBDDaemon::setMacroRate(double rate, double burst, RatePolicy policy) {
+    lock_guard<mutex> lock(sessions_mtx);
+    macro_rate = rate;
+    macro_burst = burst;
+    rate_policy = policy;
+    for (auto &[_, sess] : sessions)
+        sess->bucket.configure(rate, burst, clock->now());
+}
+
+void KBDDaemon::setClock(Clock &c) {
+    clock = &c;
+    udev.setClock(c);
+    watchdog.setClock(c);
+    input_bucket.reset(c.now());
+    last_reply = c.now();
+}
+
+void KBDDaemon::setWatchdog(int time_ms) {
+    watchdog_enabled = time_ms > 0;
+    // Must be longer than the poll timeout of the event loop.
+    watchdog.setDeadline(Milliseconds(max(time_ms, 100)));
+}
+
+void KBDDaemon::setDeliveryProbe(bool enabled) {
+    if (enabled)
+        udev.startProbe();
+    else
+        udev.stopProbe();
 }
 
 void KBDDaemon::setEventDelay(int delay) {
@@ -32,6 +32,8 @@
 #include <set>
 #include <mutex>
 #include <thread>
+#include <memory>
+#include <deque>
 
 #include "KBDConnection.hpp"
 #include "UNIXSocket.hpp" 
@@ -41,6 +43,11 @@
 #include "Keyboard.hpp"
 #include "SystemError.hpp"
 #include "FSWatcher.hpp"
+#include "EventOrder.hpp"
+#include "TokenBucket.hpp"
+#include "Watchdog.hpp"
+#include "Clock.hpp"
+#include "Blackbox.hpp"
 
 extern "C" {
     #include <fcntl.h>
@@ -51,18 +58,85 @@ extern "C" {
 //      This will log keypresses to stdout
 #define DANGER_DANGER_LOG_KEYS 0
 
+/** Logind seat file, holds the uid of the active session. */
+static constexpr char SEAT_DIR[] = "/run/systemd/seats";
+static constexpr char SEAT_NAME[] = "seat0";
+
+/** Maximum number of deferred events per session, events beyond this
+ *  are dropped so that a runaway macro cannot hold up typing for long. */
+static constexpr size_t MAX_DEFERRED = 1024;
+
+/** Maximum number of events read from a keyboard at once. */
+static constexpr size_t MAX_READ_EVENTS = 64;
+
+/** Maximum number of packets read from MacroD at once. */
+static constexpr size_t MAX_READ_REPLIES = 512;
+
+/** What to do with macro output that goes beyond the rate limit. */
+enum class RatePolicy {
+    /** Drop key presses and repeats, releases are always kept so that
+     *  no keys are left stuck. */
+    DROP,
+    /** Emit the events later, at the allowed rate. */
+    DEFER,
+};
+
+/** Connection to the MacroD of a user session. */
+struct MacroSession {
+    uid_t uid;
+    UNIXSocket<KBDAction> com;
+    /** Keys passed to this session, the shared passthrough keys
+     *  along with the keys from /var/lib/hawck-input/keys/<uid>/ */
+    std::set<int> passthrough_keys;
+    /** Limits the rate of events emitted on behalf of the session. */
+    TokenBucket bucket;
+    /** Replies waiting for tokens when the policy is RatePolicy::DEFER */
+    std::deque<KBDAction> deferred;
+    /** Whether the session has been warned about its output rate. */
+    bool rate_warned = false;
+    /** MacroD has reported that it has no scripts to run. */
+    bool idle = false;
+    /** Number of events that were emitted, deferred or dropped. */
+    uint64_t num_emitted = 0;
+    uint64_t num_deferred = 0;
+    uint64_t num_dropped = 0;
+
+    MacroSession(uid_t uid, const std::string &addr, double rate, double burst,
+                 Clock::time_point now)
+        : uid(uid),
+          com(addr, false),
+          bucket(rate, burst, now)
+    {}
+};
+
 class KBDDaemon {
     using Milliseconds = std::chrono::milliseconds;
 private:
+    /** Used for timeouts, rate limits and retry delays. */
+    Clock *clock = &Clock::system();
     Milliseconds timeout = Milliseconds(1024);
-    std::set<int> passthrough_keys;
-    std::mutex passthrough_keys_mtx;
     std::string home_path = "/var/lib/hawck-input";
     std::unordered_map<std::string, std::string> data_dirs = {
         {"keys", home_path + "/keys"}
     };
+    /** Protects the sessions, their passthrough keys and
+     *  \link KBDDaemon::key_sources \endlink */
+    std::mutex sessions_mtx;
+    /** Maps csv file paths to the keys they contain. */
     std::unordered_map<std::string, std::vector<int>*> key_sources;
-    UNIXSocket<KBDAction> kbd_com;
+    /** Connected MacroD sessions by uid. */
+    std::unordered_map<uid_t, std::shared_ptr<MacroSession>> sessions;
+    /** Session that receives key events, nullptr if there is none and
+     *  all keys are passed straight through. */
+    std::shared_ptr<MacroSession> active;
+    /** Keys are forwarded without looking at them, because the active
+     *  session has nothing to do with them, see isIdle() */
+    bool idle_mode = false;
+    /** Uid of the active session on seat0, -1 if unknown. */
+    int seat_uid = -1;
+    /** Uid of the last session that connected, used when the seat
+     *  is unknown. */
+    int last_uid = -1;
     UDevice udev;
     /** All keyboards. */
     std::vector<Keyboard *> kbds;
@@ -77,6 +151,126 @@ private:
     FSWatcher keys_fsw;
     /** Watcher for /dev/input/ hotplug */
     FSWatcher input_fsw;
+    /** Watcher for MacroD sockets in /var/lib/hawck-input */
+    FSWatcher sock_fsw;
+    /** Watcher for logind seat changes */
+    FSWatcher seat_fsw;
+    /** Events waiting for MacroD, or for events that were sent to it. */
+    EventOrder order;
+    /** Session that the pending events in `order` were sent to. */
+    std::shared_ptr<MacroSession> inflight;
+    /** When the last reply from the in-flight session arrived. */
+    Clock::time_point last_reply;
+    /** Output rate of each MacroD session, in events per second. */
+    double macro_rate = 256;
+    /** Events each MacroD session may emit at once. */
+    double macro_burst = 512;
+    RatePolicy rate_policy = RatePolicy::DEFER;
+    /** Limits key repeats typed on the keyboards, presses and releases
+     *  are never held back. */
+    TokenBucket input_bucket = TokenBucket(1000, 200, clock->now());
+    /** Number of typed key repeats that were dropped. */
+    uint64_t num_input_dropped = 0;
+    /** MacroD is considered to be behind when this many events are
+     *  waiting for it, */
+    size_t lag_depth = 8;
+    /** or when it has not answered an event for this long. */
+    Milliseconds lag_time = Milliseconds(100);
+    bool was_lagging = false;
+    /** Number of times MacroD fell behind. */
+    uint64_t num_lag = 0;
+    /** Releases the keyboards when the event loop stalls, so that
+     *  they keep working. */
+    Watchdog watchdog{Milliseconds(300), [this](const char *stage) { releaseAll(stage); }};
+    bool watchdog_enabled = true;
+    /** Number of times the event loop stalled. */
+    std::atomic<uint64_t> num_stalls = 0;
+    /** Per-second performance aggregates that survive crashes, read
+     *  with hawck-blackbox. */
+    Blackbox blackbox;
+
+    /** Get the session that a directory of csv files belongs to.
+     *
+     * @return The uid for keys/<uid>/, or -1 for directories with files
+     *         that apply to all sessions.
+     */
+    int keyDirUID(const std::string &dir_path);
+
+    /** Recompute the passthrough keys of every session, requires
+     *  sessions_mtx to be held. */
+    void rebuildPassthrough();
+
+    /** Load all key files from a directory. */
+    void loadPassthroughDir(const std::string &dir_path);
+
+    /** Connect to the MacroD listening on a socket named kbd-<uid>.sock
+     *
+     * @param path Path to the socket.
+     * @param tries Number of attempts, newly created sockets may not
+     *              be listening or have the right permissions yet.
+     */
+    void connectSession(const std::string &path, int tries);
+
+    /** Connect to the MacroD sockets that already exist. */
+    void initSessions();
+
+    /** Forget a session after a connection error. */
+    void dropSession(const std::shared_ptr<MacroSession> &sess);
+
+    /** Read the uid of the active session from the logind seat file. */
+    void readSeat();
+
+    /** Choose the session that receives key events, requires
+     *  sessions_mtx to be held. */
+    void updateActive();
+
+    /** Emit the events in `order` that are ready. */
+    void emitReady();
+
+    /** Give up on the in-flight session, pending events are emitted
+     *  as they were read and the session is dropped. */
+    void abortInflight(const char *why);
+
+    /** Pass a reply from MacroD through the rate limit of its session. */
+    void governReply(MacroSession &sess, const KBDAction &action);
+
+    /** Hand a reply from MacroD over to `order`. */
+    void forwardReply(MacroSession &sess, const KBDAction &action);
+
+    /** Forward the deferred replies that the session has tokens for. */
+    void releaseDeferred(MacroSession &sess);
+
+    /** Check whether MacroD is behind, and tell `order` about it. */
+    bool updateLag();
+
+    /** Send queued passthrough events to the in-flight session, unless
+     *  it is behind, all in one write. */
+    void sendQueued();
+
+    /** Check whether keys can be forwarded without looking at them, i.e
+     *  there is no session, or it has no passthrough keys or scripts. */
+    bool isIdle();
+
+    /** Receive the packets that are available from a MacroD session,
+     *  replies for the in-flight session and state reports. */
+    void recvSession(const std::shared_ptr<MacroSession> &sess);
+
+    /** Route an event that was read from a keyboard.
+     *
+     * @return True if the event was emitted, and udev needs a flush.
+     */
+    bool handleInput(const struct input_event &ev);
+
+    /** Ungrab all keyboards, called from the watchdog thread when the
+     *  event loop has stalled in `stage`. */
+    void releaseAll(const char *stage);
+
+    /** Grab the keyboards again after a stall, events that arrived
+     *  while they were released have already reached the system. */
+    void regrabAll();
+
+    /** Write rate limit and lag counters to syslog. */
+    void logStats();
 
 public:
     explicit KBDDaemon(const char *device);
@@ -131,4 +325,52 @@ public:
     inline void setSocketTimeout(int time) {
         timeout = Milliseconds(time);
     }
+
+    /** Set how events are ordered while MacroD is handling some of
+     *  them, see EventOrder. */
+    inline void setOrderPolicy(OrderPolicy policy) {
+        order.setPolicy(policy);
+    }
+
+    /** Set the output rate limit of MacroD sessions.
+     *
+     * @param rate Events per second, zero or less for no limit.
+     * @param burst Events that may be emitted at once.
+     * @param policy What to do with events beyond the limit.
+     */
+    void setMacroRate(double rate, double burst, RatePolicy policy);
+
+    /** Set when MacroD is considered to be behind, in which case
+     *  events are held back and stale repeats are shed.
+     *
+     * @param depth Number of events waiting for MacroD.
+     * @param time_ms Time in milliseconds that MacroD has not answered.
+     */
+    inline void setLagLimits(int depth, int time_ms) {
+        lag_depth = depth;
+        lag_time = Milliseconds(time_ms);
+    }
+
+    /** Replace the clock used for timeouts, rate limits, event pacing
+     *  and the watchdog, must be called before run(). */
+    void setClock(Clock &c);
+
+    /** Set how long the event loop may stall before the keyboards are
+     *  released, must be called before run().
+     *
+     * @param time_ms Time in milliseconds, 0 disables the watchdog.
+     */
+    void setWatchdog(int time_ms);
+
+    /** Time the delivery of emitted events, see UDevice::startProbe() */
+    void setDeliveryProbe(bool enabled);
+
+    /** Set the rate limit for key repeats typed on the keyboards.
+     *
+     * @param rate Events per second, zero or less for no limit.
+     * @param burst Events that may be emitted at once.
+     */
+    inline void setInputRate(double rate, double burst) {
+        input_bucket.configure(rate, burst, clock->now());
+    }
 };
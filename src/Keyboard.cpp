@@ -167,16 +167,27 @@ void Keyboard::lock() {
 }
 
 void Keyboard::unlock() {
-    if (state == KBDState::LOCKED)
+    if (state.exchange(KBDState::OPEN) == KBDState::LOCKED)
         if (ioctl(fd, EVIOCGRAB, NULL) == -1)
             throw KeyboardError("Failure in ioctl(EVIOCGRAB)");
+}
 
-    state = KBDState::OPEN;
+void Keyboard::discardPending() noexcept {
+    struct pollfd pfd = {fd, POLLIN, 0};
+    struct input_event evs[64];
+    while (poll(&pfd, 1, 0) == 1 && (pfd.revents & POLLIN))
+        if (read(fd, evs, sizeof(evs)) <= 0)
+            break;
 }
 
 void Keyboard::get(struct input_event *ev) {
+    get(ev, 1);
+}
+
+size_t Keyboard::get(struct input_event *evs, size_t max) {
     ssize_t n;
-    if ((n = read(fd, ev, sizeof(*ev))) != sizeof(*ev)) {
+    // evdev only returns whole events.
+    if ((n = read(fd, evs, max * sizeof(*evs))) < (ssize_t) sizeof(*evs)) {
         stringstream err("read() failed, returned: ");
         err << n << ": " << strerror(errno);
         throw KeyboardError(err.str());
@@ -190,6 +201,7 @@ void Keyboard::get(struct input_event *ev) {
         state = KBDState::LOCKED;
         syslog(LOG_INFO, "Acquired lock on keyboard: %s", name.c_str());
     }
+    return n / sizeof(*evs);
 }
 
 void Keyboard::disable() noexcept {
@@ -214,10 +226,14 @@ void Keyboard::reset(const char *path) {
     this->fd = fd;
 }
 
-int kbdMultiplex(const std::vector<Keyboard*>& kbds, int timeout) {
+int kbdMultiplex(const std::vector<Keyboard*>& kbds, int timeout, int extra_fd) {
     size_t idx = 0,
-           len = kbds.size();
+           len = kbds.size() + 1;
     struct pollfd pfds[len];
+    // The extra fd goes first so that it is preferred over keyboards,
+    // poll() ignores it when it is negative.
+    pfds[idx].events = POLLIN;
+    pfds[idx++].fd = extra_fd;
     for (const auto& kbd : kbds) {
         pfds[idx].events = POLLIN;
         pfds[idx++].fd = kbd->getfd();
@@ -235,16 +251,38 @@ int kbdMultiplex(const std::vector<Keyboard*>& kbds, int timeout) {
             return -1;
 
         default:
-            int fd = -1;
-            for (auto pfd : pfds)
-                if (pfd.revents & (POLLNVAL | POLLERR | POLLHUP | POLLNVAL | POLLIN)) {
-                    fd = pfd.fd;
-                    break;
-                }
-            for (idx = 0; idx < kbds.size(); idx++)
-                if (pfds[idx].fd == fd)
-                    return idx;
+            for (idx = 0; idx < len; idx++)
+                if (pfds[idx].revents & (POLLNVAL | POLLERR | POLLHUP | POLLIN))
+                    return (idx == 0) ? kbds.size() : idx - 1;
 
             throw SystemError("Unable to find file descriptor returned by poll()");
     }
 }
+
+bool kbdMultiplex(const std::vector<Keyboard*>& kbds, int timeout, int extra_fd,
+                  std::vector<size_t>& ready)
+{
+    size_t len = kbds.size() + 1;
+    struct pollfd pfds[len];
+    for (size_t i = 0; i < kbds.size(); i++) {
+        pfds[i].events = POLLIN;
+        pfds[i].fd = kbds[i]->getfd();
+    }
+    pfds[kbds.size()].events = POLLIN;
+    pfds[kbds.size()].fd = extra_fd;
+
+    ready.clear();
+    switch (poll(pfds, len, timeout)) {
+        case -1:
+            throw SystemError("Error in poll(): ", errno);
+
+        case 0:
+            return false;
+
+        default:
+            for (size_t i = 0; i < len; i++)
+                if (pfds[i].revents & (POLLNVAL | POLLERR | POLLHUP | POLLIN))
+                    ready.push_back(i);
+            return true;
+    }
+}
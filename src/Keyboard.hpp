@@ -37,6 +37,7 @@
 #include <stdexcept>
 #include <vector>
 #include <functional>
+#include <atomic>
 
 extern "C" {
     #include <unistd.h>
@@ -85,8 +86,9 @@ private:
     std::string uniq_id = "";
     /** Filed descriptor for keyboard device. */
     int fd = -1;
-    /** State of the keyboard, used in locking. */
-    KBDState state = KBDState::OPEN;
+    /** State of the keyboard, used in locking. Atomic because the
+     *  InputD watchdog unlocks keyboards from its own thread. */
+    std::atomic<KBDState> state = KBDState::OPEN;
 
 public:
     /** Keyboard constructor.
@@ -115,6 +117,9 @@ public:
     /** Release the exclusive lock to the keyboard. */
     void unlock();
 
+    /** Throw away events that have not been read yet. */
+    void discardPending() noexcept;
+
     /** Disable the keyboard. */
     void disable() noexcept;
 
@@ -146,6 +151,15 @@ public:
      */
     void get(struct input_event *ev);
 
+    /** Get all events that have been read by the kernel, up to `max`,
+     *  with a single read().
+     *
+     * Blocks until a key is pressed if there are no events.
+     *
+     * @return Number of events stored in `evs`.
+     */
+    size_t get(struct input_event *evs, size_t max);
+
     /** Get human-readable name of the keyboard device.
      *
      * @return Human-readable name of device.
@@ -188,13 +202,38 @@ public:
  *
  * @param kbds Keyboards to check.
  * @param timeout Time to wait in milliseconds.
+ * @param extra_fd Another file descriptor to wait on, e.g a socket,
+ *                 ignored if it is negative.
  * 
  * @throws SystemError if the underlying polling function fails.
  *
- * @return Index of keyboard with available input in kbds, returns
- *         -1 if the function timed out.
+ * @return Index of keyboard with available input in kbds, kbds.size()
+ *         if extra_fd has input, or -1 if the function timed out.
+ */
+int kbdMultiplex(const std::vector<Keyboard*>& kbds, int timeout, int extra_fd);
+
+/**
+ * IO multiplexing on keyboards, reporting every file descriptor that is
+ * ready instead of just the first one.
+ *
+ * @param ready Receives the indices of keyboards with available input,
+ *              followed by kbds.size() if extra_fd has input.
+ *
+ * @throws SystemError if the underlying polling function fails.
+ *
+ * @return False if the function timed out.
  */
-int kbdMultiplex(const std::vector<Keyboard*>& kbds, int timeout);
+bool kbdMultiplex(const std::vector<Keyboard*>& kbds, int timeout, int extra_fd,
+                  std::vector<size_t>& ready);
+
+/**
+ * Same as kbdMultiplex, but without an extra file descriptor.
+ *
+ * @see kbdMultiplex
+ */
+inline int kbdMultiplex(const std::vector<Keyboard*>& kbds, int timeout) {
+    return kbdMultiplex(kbds, timeout, -1);
+}
 
 /**
  * Same as kbdMultiplex, but will not time out.
@@ -0,0 +1,122 @@
+/* =====================================================================================
+ * Latency histogram.
+ *
+ * Copyright (C) 2018 Jonas Møller (no) <jonasmo441@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * =====================================================================================
+ */
+
+/** @file LatencyHistogram.hpp
+ *
+ * @brief Histogram of latencies with power of two buckets.
+ */
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <string>
+#include <sstream>
+
+extern "C" {
+    #include <stdint.h>
+}
+
+/** Counts latencies in buckets of [2^i, 2^(i+1)) µs.
+ *
+ * Samples are added from one thread and can be read from any other,
+ * a reader may see a sample in the total before it is in a bucket.
+ */
+class LatencyHistogram {
+public:
+    static constexpr size_t num_buckets = 24;
+
+private:
+    std::array<std::atomic<uint64_t>, num_buckets> buckets = {};
+    std::atomic<uint64_t> count = 0;
+    std::atomic<uint64_t> max_us = 0;
+
+    static size_t bucketOf(uint64_t us) noexcept {
+        size_t i = 0;
+        while (us > 1 && i < num_buckets - 1) {
+            us >>= 1;
+            i++;
+        }
+        return i;
+    }
+
+public:
+    void add(uint64_t us) noexcept {
+        buckets[bucketOf(us)].fetch_add(1, std::memory_order_relaxed);
+        count.fetch_add(1, std::memory_order_relaxed);
+        if (us > max_us.load(std::memory_order_relaxed))
+            max_us.store(us, std::memory_order_relaxed);
+    }
+
+    /** Remove all samples, must not race with add(). */
+    void reset() noexcept {
+        for (auto &b : buckets)
+            b.store(0, std::memory_order_relaxed);
+        count.store(0, std::memory_order_relaxed);
+        max_us.store(0, std::memory_order_relaxed);
+    }
+
+    inline uint64_t total() const noexcept {
+        return count.load(std::memory_order_relaxed);
+    }
+
+    inline uint64_t max() const noexcept {
+        return max_us.load(std::memory_order_relaxed);
+    }
+
+    /** Get an upper bound for the p-quantile in µs, 0 if there are no
+     *  samples.
+     *
+     * @param p Quantile between 0 and 1.
+     */
+    uint64_t quantile(double p) const noexcept {
+        uint64_t n = 0;
+        for (const auto &b : buckets)
+            n += b.load(std::memory_order_relaxed);
+        if (n == 0)
+            return 0;
+        uint64_t rank = (uint64_t) (p * n);
+        uint64_t seen = 0;
+        for (size_t i = 0; i < num_buckets; i++) {
+            seen += buckets[i].load(std::memory_order_relaxed);
+            if (seen > rank)
+                return (uint64_t) 2 << i;
+        }
+        return max();
+    }
+
+    /** Format as "n=... p50<=...us p99<=...us max=...us" */
+    std::string summary() const {
+        std::stringstream ss;
+        ss << "n=" << total()
+           << " p50<=" << quantile(0.5) << "us"
+           << " p99<=" << quantile(0.99) << "us"
+           << " max=" << max() << "us";
+        return ss.str();
+    }
+};
@@ -0,0 +1,252 @@
+/* =====================================================================================
+ * Application launcher.
+ *
+ * Copyright (C) 2018 Jonas Møller (no) <jonasmo441@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * =====================================================================================
+ */
+
+#include <fstream>
+#include <iostream>
+#include <chrono>
+
+extern "C" {
+    #include <spawn.h>
+    #include <signal.h>
+    #include <stdlib.h>
+    #include <string.h>
+    #include <errno.h>
+    #include <dirent.h>
+    #include <unistd.h>
+    #include <syslog.h>
+    #include <sys/wait.h>
+    #include <sys/stat.h>
+}
+
+#include "Launcher.hpp"
+#include "SystemError.hpp"
+#include "utils.hpp"
+
+extern char **environ;
+
+using namespace std;
+
+static const string desktop_suffix = ".desktop";
+
+DesktopIndex::DesktopIndex() {
+    const char *data_home = getenv("XDG_DATA_HOME");
+    const char *home = getenv("HOME");
+    if (data_home && *data_home)
+        dirs.push_back(string(data_home) + "/applications");
+    else if (home)
+        dirs.push_back(string(home) + "/.local/share/applications");
+    dirs.push_back("/usr/local/share/applications");
+    dirs.push_back("/usr/share/applications");
+
+    fsw.setWatchDirs(true);
+    fsw.setAutoAdd(false);
+    for (const auto &dir : dirs) {
+        struct stat stbuf;
+        if (stat(dir.c_str(), &stbuf) == -1 || !S_ISDIR(stbuf.st_mode))
+            continue;
+        try {
+            fsw.add(dir);
+        } catch (const SystemError &e) {
+            syslog(LOG_WARNING, "Unable to watch %s: %s", dir.c_str(), e.what());
+        }
+    }
+    fsw.begin([this](FSEvent &ev) {
+                  string name = ev.name.empty() ? pathBasename(ev.path) : ev.name;
+                  if (name.size() > desktop_suffix.size() &&
+                      name.compare(name.size() - desktop_suffix.size(),
+                                   string::npos, desktop_suffix) == 0)
+                      invalidate(name.substr(0, name.size() - desktop_suffix.size()));
+                  else
+                      invalidate("");
+                  return true;
+              });
+}
+
+DesktopIndex::~DesktopIndex() noexcept {
+    try {
+        fsw.stop();
+    } catch (const exception &e) {
+        syslog(LOG_ERR, "Unable to stop desktop file watcher: %s", e.what());
+    }
+}
+
+DesktopIndex::Entry DesktopIndex::parse(const string &name) {
+    Entry entry;
+    for (const auto &dir : dirs) {
+        ifstream file(dir + "/" + name + desktop_suffix);
+        if (!file.is_open())
+            continue;
+        string action;
+        // Lines outside of the entry and its actions, e.g in [X-Foo]
+        // groups, are ignored.
+        bool in_group = false;
+        string line;
+        while (getline(file, line)) {
+            if (line.empty() || line[0] == '#')
+                continue;
+            if (line[0] == '[') {
+                static const string action_hdr = "[Desktop Action ";
+                size_t end = line.rfind(']');
+                in_group = true;
+                if (line.compare(0, end + 1, "[Desktop Entry]") == 0)
+                    action = "";
+                else if (line.compare(0, action_hdr.size(), action_hdr) == 0 &&
+                         end != string::npos && end > action_hdr.size())
+                    action = line.substr(action_hdr.size(), end - action_hdr.size());
+                else
+                    in_group = false;
+                continue;
+            }
+            if (in_group && line.compare(0, 5, "Exec=") == 0) {
+                size_t end = line.find_last_not_of(" \t\r");
+                entry[action] = line.substr(5, end - 4);
+            }
+        }
+        break;
+    }
+    return entry;
+}
+
+string DesktopIndex::exec(const string &name, const string &action) {
+    lock_guard<mutex> lock(mtx);
+    auto it = entries.find(name);
+    if (it == entries.end())
+        it = entries.emplace(name, parse(name)).first;
+    auto ait = it->second.find(action);
+    return (ait == it->second.end()) ? "" : ait->second;
+}
+
+void DesktopIndex::invalidate(const string &name) {
+    lock_guard<mutex> lock(mtx);
+    if (name.empty())
+        entries.clear();
+    else
+        entries.erase(name);
+}
+
+Launcher::Launcher()
+    : LuaIface(this, Launcher_lua_methods),
+      worker([this]() { work(); })
+{}
+
+Launcher::~Launcher() {
+    {
+        lock_guard<mutex> lock(mtx);
+        stopping = true;
+    }
+    cv.notify_one();
+    worker.join();
+}
+
+void Launcher::spawn(string cmd) {
+    {
+        lock_guard<mutex> lock(mtx);
+        queue.push_back(move(cmd));
+    }
+    cv.notify_one();
+}
+
+void Launcher::work() {
+    unique_lock<mutex> lock(mtx);
+    while (!stopping) {
+        cv.wait_for(lock, chrono::milliseconds(reap_interval_ms),
+                    [this]() { return stopping || !queue.empty(); });
+        while (!queue.empty()) {
+            string cmd = move(queue.front());
+            queue.pop_front();
+            lock.unlock();
+            try {
+                start(cmd);
+            } catch (const SystemError &e) {
+                syslog(LOG_ERR, "Unable to launch '%s': %s", cmd.c_str(), e.what());
+            }
+            lock.lock();
+        }
+        reap();
+    }
+}
+
+void Launcher::start(const string &cmd) {
+    posix_spawn_file_actions_t actions;
+    posix_spawnattr_t attr;
+    posix_spawn_file_actions_init(&actions);
+    posix_spawnattr_init(&attr);
+
+    // MacroD holds the connection to InputD, a long-running child that
+    // inherits it would keep InputD from noticing when MacroD exits.
+    if (DIR *dir = opendir("/proc/self/fd")) {
+        int dir_fd = dirfd(dir);
+        while (struct dirent *entry = readdir(dir)) {
+            int fd = atoi(entry->d_name);
+            if (fd > STDERR_FILENO && fd != dir_fd)
+                posix_spawn_file_actions_addclose(&actions, fd);
+        }
+        closedir(dir);
+    }
+
+    // Start the child in its own session with default signal handling,
+    // it should not be affected by what happens to MacroD.
+    sigset_t mask, dfl;
+    sigemptyset(&mask);
+    sigemptyset(&dfl);
+    sigaddset(&dfl, SIGPIPE);
+    sigaddset(&dfl, SIGCHLD);
+    posix_spawnattr_setsigmask(&attr, &mask);
+    posix_spawnattr_setsigdefault(&attr, &dfl);
+    posix_spawnattr_setflags(&attr, POSIX_SPAWN_SETSIGMASK
+                                  | POSIX_SPAWN_SETSIGDEF
+                                  | POSIX_SPAWN_SETSID);
+
+    const char *argv[] = {"/bin/sh", "-c", cmd.c_str(), nullptr};
+    pid_t pid;
+    int err = posix_spawn(&pid, argv[0], &actions, &attr,
+                          (char *const *) argv, environ);
+    posix_spawn_file_actions_destroy(&actions);
+    posix_spawnattr_destroy(&attr);
+    if (err)
+        throw SystemError("Error in posix_spawn(): ", err);
+
+    lock_guard<mutex> lock(mtx);
+    children.push_back(pid);
+}
+
+void Launcher::reap() {
+    for (auto it = children.begin(); it != children.end();) {
+        int status;
+        pid_t ret = waitpid(*it, &status, WNOHANG);
+        if (ret == 0) {
+            it++;
+            continue;
+        }
+        if (ret == -1 && errno != ECHILD)
+            syslog(LOG_WARNING, "Error in waitpid(%d): %s", *it, strerror(errno));
+        it = children.erase(it);
+    }
+}
+
+LUA_CREATE_BINDINGS(Launcher_lua_methods)
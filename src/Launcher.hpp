@@ -0,0 +1,152 @@
+/* =====================================================================================
+ * Application launcher.
+ *
+ * Copyright (C) 2018 Jonas Møller (no) <jonasmo441@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * =====================================================================================
+ */
+
+/** @file Launcher.hpp
+ *
+ * @brief Start applications without blocking the event loop.
+ */
+
+#pragma once
+
+#include <string>
+#include <deque>
+#include <vector>
+#include <unordered_map>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+extern "C" {
+    #include <sys/types.h>
+    #include <lua.h>
+    #include <lauxlib.h>
+    #include <lualib.h>
+}
+
+#include "LuaUtils.hpp"
+#include "FSWatcher.hpp"
+
+/** Index of installed .desktop files.
+ *
+ * Desktop files are parsed when they are first looked up and kept
+ * until inotify reports a change to them, so every script shares a
+ * single parse of each file.
+ */
+class DesktopIndex {
+    /** Exec lines by action name, the [Desktop Entry] group has the
+     *  empty name. An empty map means that the file does not exist. */
+    using Entry = std::unordered_map<std::string, std::string>;
+private:
+    /** Searched in order, the user directory takes precedence. */
+    std::vector<std::string> dirs;
+    std::unordered_map<std::string, Entry> entries;
+    std::mutex mtx;
+    FSWatcher fsw;
+
+    Entry parse(const std::string &name);
+
+public:
+    DesktopIndex();
+
+    ~DesktopIndex() noexcept;
+
+    /** Get the Exec line of an application action.
+     *
+     * @param name Name of the desktop file without the .desktop suffix.
+     * @param action Name of a [Desktop Action], or an empty string for
+     *               the [Desktop Entry] itself.
+     * @return The Exec line, or an empty string if there is no such
+     *         application or action.
+     */
+    std::string exec(const std::string &name, const std::string &action);
+
+    /** Forget a parsed file, or all of them if `name` is empty. */
+    void invalidate(const std::string &name);
+};
+
+// Methods to export to Lua
+#define Launcher_lua_methods(M, _)                      \
+    M(Launcher, spawn, std::string()) _                 \
+    M(Launcher, exec, std::string(), std::string())
+
+LUA_DECLARE(Launcher_lua_methods)
+
+/** Application launcher.
+ *
+ * Commands are started with posix_spawn() from a worker thread, so a
+ * launch hotkey returns to the event loop as soon as the command has
+ * been queued. Children are never waited on, the worker reaps them
+ * when they exit.
+ */
+class Launcher : public Lua::LuaIface<Launcher> {
+private:
+    /** How often the worker checks for exited children. */
+    static constexpr int reap_interval_ms = 1000;
+
+    DesktopIndex index;
+    std::deque<std::string> queue;
+    /** Children that have not been reaped yet. Only these are waited
+     *  on, so that pclose() on io.popen() handles keeps working. */
+    std::vector<pid_t> children;
+    std::mutex mtx;
+    std::condition_variable cv;
+    bool stopping = false;
+    std::thread worker;
+
+    void work();
+
+    /** Start `/bin/sh -c cmd` without inheriting any file descriptors
+     *  other than stdin, stdout and stderr. */
+    void start(const std::string &cmd);
+
+    /** Reap exited children without blocking. */
+    void reap();
+
+    LUA_METHOD_COLLECT(Launcher_lua_methods);
+
+public:
+    Launcher();
+
+    ~Launcher();
+
+    /** Queue a shell command to be started, returns immediately. */
+    void spawn(std::string cmd);
+
+    /** Number of children that have not been reaped yet. */
+    inline size_t numChildren() {
+        std::lock_guard<std::mutex> lock(mtx);
+        return children.size();
+    }
+
+    /** See DesktopIndex::exec() */
+    inline std::string exec(std::string name, std::string action) {
+        return index.exec(name, action);
+    }
+
+    LUA_EXTRACT(Launcher_lua_methods)
+};
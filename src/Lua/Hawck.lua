@@ -40,6 +40,10 @@ FALLTHROUGH = 0x3141592654
 -- Keeps track of keys that are requested by the script.
 __keys = {}
 
+-- Applications that the script applies to, the script applies
+-- to all applications when this is empty.
+__apps = {}
+
 -- Root match scope
 __match = MatchScope.new()
 match = __match
@@ -189,6 +193,83 @@ say = LazyF.new(function (message)
     notify("Hawck", message)()
 end)
 
+--- Start recording output events into the macro `name`.
+--  Recording continues until stop_recording is called.
+record = LazyF.new(function (name)
+    macros:record(name)
+end)
+
+stop_recording = ConcatF.new(function ()
+    macros:stop()
+end)
+
+--- Toggle recording of the macro `name`.
+toggle_recording = LazyF.new(function (name)
+    if macros:isRecording() then
+      macros:stop()
+    else
+      macros:record(name)
+    end
+end)
+
+--- Play back a recorded macro as fast as possible.
+play = LazyF.new(function (name)
+    macros:play(name)
+end)
+
+--- Play back a recorded macro at the speed it was recorded.
+play_timed = LazyF.new(function (name)
+    macros:playTimed(name)
+end)
+
+--- Condition that is true while the shared state `name` is equal to
+--  `value`, or when no value is given, while it is set to anything
+--  other than false or nil. Shared state is visible to all scripts.
+is_state = LazyCondF.new(function (name, value)
+    local current = state[name]
+    if value == nil then
+      return current ~= nil and current ~= false
+    end
+    return current == value
+end)
+
+--- Set the shared state `name` to `value`.
+set_state = LazyF.new(function (name, value)
+    state[name] = value
+end)
+
+--- Toggle the shared state `name` between true and false.
+toggle_state = LazyF.new(function (name)
+    state[name] = not state[name]
+end)
+
+local state_watchers = {}
+
+--- Call `fn` with the new value whenever the shared state `name` is
+--  changed, either by this script or by another one.
+function on_state_change(name, fn)
+  state_watchers[name] = {fn = fn, version = __stateVersion(name)}
+end
+
+--- Called by MacroD after the shared state has changed.
+function __stateChanged()
+  for name, watcher in pairs(state_watchers) do
+    local version = __stateVersion(name)
+    if version ~= watcher.version then
+      watcher.version = version
+      watcher.fn(state[name])
+    end
+  end
+end
+
+--- Only run the script while one of the given applications has focus,
+--  the names are matched against the window class, ignoring case.
+function only_in(...)
+  for _, name in ipairs({...}) do
+    table.insert(__apps, name)
+  end
+end
+
 function mode(name, cond)
   local state = true
   local messages = {
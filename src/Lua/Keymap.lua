@@ -28,6 +28,13 @@
 local strict = require "strict"
 local u = require "utils"
 local ALIASES = require "keymaps/aliases"
+-- Linux key names (esc, leftctrl, btn_left, ...), provided by MacroD.
+local succ, LINUX_KEYS = pcall(require, "keymaps/default_linux")
+if not succ then
+  LINUX_KEYS = nil
+end
+-- Generated by gen-aliases.lua during installation.
+local ALIAS_INDEX = "/usr/share/hawck/keymaps/aliases.idx"
 local kbmap = {}
 local KEYMAP_MODS = {"Shift",
                      "AltGr",
@@ -274,29 +281,103 @@ function kbmap.getall()
   return keymaps
 end
 
---- Create a new kbmap from a Linux keymap file
+--- Read the aliases of a keymap from an alias index.
+--
+-- The index starts with a "HWKALIAS 1" line, followed by one
+-- "<lang> <offset> <length>" line per keymap and an empty line. The
+-- offsets are relative to the end of the empty line, and point to
+-- sections of "<hex code point>\t<key name>" lines. Only the section of
+-- the requested keymap is read.
+--
+-- @param path Path to the alias index.
 -- @param lang The key map language.
-function kbmap.new(lang)
-  assert(lang)
-  local maps = kbmap.getall()
-  if not maps[lang] then
-    error("No such keymap: " .. lang)
+-- @return Table mapping characters to key names, or nil if the index
+--         does not exist or has no entry for the keymap.
+function kbmap.readAliases(path, lang)
+  local file = io.open(path, "rb")
+  if not file then
+    return nil
+  end
+  if file:read("l") ~= "HWKALIAS 1" then
+    file:close()
+    return nil
+  end
+
+  local offset, len
+  for line in file:lines() do
+    if line == "" then
+      break
+    end
+    local name, o, l = line:match("^(%S+) (%d+) (%d+)$")
+    if name == lang then
+      offset, len = tonumber(o), tonumber(l)
+    end
+  end
+
+  if not offset then
+    file:close()
+    return nil
+  end
+
+  file:seek("set", file:seek() + offset)
+  local data = file:read(len) or ""
+  file:close()
+
+  local aliases = {}
+  for hex, name in data:gmatch("(%x+)\t([^\n]+)\n") do
+    aliases[utf8.char(tonumber(hex, 16))] = name
   end
-  local keymap, combo_map, mod_codes = readLinuxKBMap(maps[lang])
+  return aliases
+end
+
+--- Create a kbmap from a Linux keymap file, without any aliases
+--  besides the builtin ones.
+-- @param path Path to the keymap file.
+function kbmap.load(path)
+  return kbmap.fromTables(readLinuxKBMap(path))
+end
+
+--- Create a kbmap from the tables produced by readLinuxKBMap.
+function kbmap.fromTables(keymap, combo_map, mod_codes)
   local map = {
     keymap = keymap,
     combo_map = combo_map,
     mod_codes = mod_codes,
+    aliases = ALIASES or {},
   }
   setmetatable(map, kbmap_meta)
   return map
 end
 
+--- Create a new kbmap from a Linux keymap file
+-- @param lang The key map language.
+function kbmap.new(lang)
+  assert(lang)
+  local map
+  -- Keymaps compiled by gen-cache.lua are loaded from the module
+  -- cache, without searching for and parsing the keymap file.
+  local succ, compiled = pcall(require, "keymaps/compiled/" .. lang)
+  if succ then
+    map = kbmap.fromTables(compiled.keymap, compiled.combo_map, compiled.mod_codes)
+  else
+    local maps = kbmap.getall()
+    if not maps[lang] then
+      error("No such keymap: " .. lang)
+    end
+    map = kbmap.load(maps[lang])
+  end
+  local aliases = kbmap.readAliases(ALIAS_INDEX, lang)
+  if aliases then
+    map.aliases = setmetatable(aliases, {__index = ALIASES})
+  end
+  return map
+end
+
 --- Get a combo key, i.e a key that consists of a modifier+key combo.
 -- @param key Key name.
 function kbmap:getCombo(key)
-  if ALIASES and ALIASES[key] then
-    key = ALIASES[key]
+  if self.aliases[key] then
+    key = self.aliases[key]
   end
   return self.combo_map[key] or error(("No such combo key: %s"):format(key))
 end
@@ -304,10 +385,12 @@ end
 --- Get a key code from a key name.
 -- @param key Key name.
 function kbmap:getKeysym(key)
-  if ALIASES and ALIASES[key] then
-    key = ALIASES[key]
+  if self.aliases[key] then
+    key = self.aliases[key]
   end
-  return self.keymap[key] or error(("No such key: %s"):format(key))
+  return (self.keymap[key] or
+          (LINUX_KEYS and type(key) == "string" and LINUX_KEYS[key]) or
+          error(("No such key: %s"):format(key)))
 end
 
 --- Check if a key is a modifier, i.e one of Control/Control_R/Shift/Shift_R/Alt/AltGr
@@ -74,6 +74,13 @@ local function readDesktopFile(path)
   return actions
 end
 
+--- Get the launcher provided by MacroD, which shares a single index of
+--  the desktop files between all scripts and starts applications
+--  without blocking. Returns nil when running outside of MacroD.
+local function nativeLauncher()
+  return rawget(_G, "launcher")
+end
+
 local AppMethods = {}
 
 function AppMethods:new(arg)
@@ -93,13 +100,21 @@ function AppMetaMethods.__index(t, key)
     key = key:gsub("_", "-")
   end
 
-  local action = t._actions[key]
-  if not action or not action["Exec"] then
+  local exec
+  local launcher = nativeLauncher()
+  if launcher then
+    exec = launcher:exec(t._name, key == 0 and "" or key)
+    if exec == "" then
+      exec = nil
+    end
+  else
+    local action = t._actions[key]
+    exec = action and action["Exec"]
+  end
+  if not exec then
     error("No such action: " .. key)
   end
 
-  local exec = action["Exec"]
-
   return LazyF.new(function (self, arg)
       print(arg)
       local cmd
@@ -108,14 +123,21 @@ function AppMetaMethods.__index(t, key)
       else
         cmd = exec:gsub("%%u", u.shescape(arg or ""))
       end
-      io.popen(cmd)
+      if launcher then
+        launcher:spawn(cmd)
+      else
+        io.popen(cmd)
+      end
   end)
 end
 
 local function app(name)
   local t = {
-    _actions = readDesktopFile(("/usr/share/applications/%s.desktop"):format(name))
+    _name = name
   }
+  if not nativeLauncher() then
+    t._actions = readDesktopFile(("/usr/share/applications/%s.desktop"):format(name))
+  end
   setmetatable(t, AppMetaMethods)
   return t
 end
@@ -0,0 +1,105 @@
+/* =====================================================================================
+ * Lua bindings for event code names.
+ *
+ * Copyright (C) 2018 Jonas Møller (no) <jonasmo441@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * =====================================================================================
+ */
+
+#include <string_view>
+
+extern "C" {
+    #include <ctype.h>
+    #include <string.h>
+    #include <linux/input.h>
+}
+
+#include "LuaEventCodes.hpp"
+#include "EventCodes.hpp"
+
+using namespace std;
+
+namespace Lua {
+    /** Longest name accepted by keycodesIndex() */
+    static constexpr size_t max_name_len = 64;
+
+    /** __index metamethod of the keycodes userdata. */
+    static int keycodesIndex(lua_State *L) {
+        if (lua_type(L, 2) == LUA_TNUMBER) {
+            const char *name = EventCodes::codeName(EV_KEY, lua_tointeger(L, 2));
+            if (!name) {
+                lua_pushnil(L);
+                return 1;
+            }
+            char buf[max_name_len];
+            if (!strncmp(name, "KEY_", 4))
+                name += 4;
+            size_t i;
+            for (i = 0; name[i] && i < sizeof(buf) - 1; i++)
+                buf[i] = tolower(name[i]);
+            lua_pushlstring(L, buf, i);
+            return 1;
+        }
+
+        size_t len;
+        const char *key = luaL_checklstring(L, 2, &len);
+        // Turn "esc" into "KEY_ESC" and "btn_left" into "BTN_LEFT"
+        char buf[max_name_len];
+        size_t off = 0;
+        if (strncmp(key, "btn_", 4)) {
+            memcpy(buf, "KEY_", 4);
+            off = 4;
+        }
+        if (len + off > sizeof(buf)) {
+            lua_pushnil(L);
+            return 1;
+        }
+        for (size_t i = 0; i < len; i++)
+            buf[off + i] = toupper(key[i]);
+
+        const EventCodes::Entry *e = EventCodes::find(string_view(buf, off + len));
+        if (e && e->type == EV_KEY)
+            lua_pushinteger(L, e->code);
+        else
+            lua_pushnil(L);
+        return 1;
+    }
+
+    static int luaopenKeycodes(lua_State *L) {
+        lua_newuserdata(L, 1);
+        if (luaL_newmetatable(L, "Hawck.keycodes")) {
+            lua_pushcfunction(L, keycodesIndex);
+            lua_setfield(L, -2, "__index");
+        }
+        lua_setmetatable(L, -2);
+        return 1;
+    }
+
+    void openEventCodes(lua_State *L) {
+        lua_getglobal(L, "package");
+        lua_getfield(L, -1, "preload");
+        lua_pushcfunction(L, luaopenKeycodes);
+        lua_setfield(L, -2, "keymaps/default_linux");
+        lua_pop(L, 2);
+    }
+}
@@ -0,0 +1,72 @@
+/* =====================================================================================
+ * Lua loader for the module cache.
+ *
+ * Copyright (C) 2018 Jonas Møller (no) <jonasmo441@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * =====================================================================================
+ */
+
+#include <string>
+
+#include "LuaModuleCache.hpp"
+#include "ModuleCache.hpp"
+
+using namespace std;
+
+namespace Lua {
+    /** Entry of package.searchers, see openModuleCache() */
+    static int cacheSearcher(lua_State *L) {
+        const ModuleCache *cache = (const ModuleCache *) lua_touserdata(L, lua_upvalueindex(1));
+        const char *name = luaL_checkstring(L, 1);
+        string_view chunk = cache->find(name);
+        if (chunk.empty()) {
+            lua_pushfstring(L, "\n\tno module '%s' in the module cache", name);
+            return 1;
+        }
+        // The chunk is read straight from the shared mapping. Its debug
+        // information names the original source file.
+        if (luaL_loadbufferx(L, chunk.data(), chunk.size(), name, "b") != LUA_OK) {
+            lua_pushfstring(L, "\n\tunable to load '%s' from the module cache: %s",
+                            name, lua_tostring(L, -1));
+            return 1;
+        }
+        lua_pushliteral(L, MODULE_CACHE_PATH);
+        return 2;
+    }
+
+    void openModuleCache(lua_State *L, const ModuleCache *cache) {
+        if (!cache->size())
+            return;
+        lua_getglobal(L, "package");
+        lua_getfield(L, -1, "searchers");
+        // Insert after the preload searcher.
+        for (lua_Integer i = luaL_len(L, -1); i >= 2; i--) {
+            lua_rawgeti(L, -1, i);
+            lua_rawseti(L, -2, i + 1);
+        }
+        lua_pushlightuserdata(L, (void *) cache);
+        lua_pushcclosure(L, cacheSearcher, 1);
+        lua_rawseti(L, -2, 2);
+        lua_pop(L, 2);
+    }
+}
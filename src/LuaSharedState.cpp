@@ -0,0 +1,128 @@
+/* =====================================================================================
+ * Lua bindings for the shared state store.
+ *
+ * Copyright (C) 2018 Jonas Møller (no) <jonasmo441@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * =====================================================================================
+ */
+
+#include <exception>
+
+#include "LuaSharedState.hpp"
+#include "SharedState.hpp"
+
+using namespace std;
+
+namespace Lua {
+    static SharedState *checkState(lua_State *L) {
+        return *(SharedState **) luaL_checkudata(L, 1, "Hawck.state");
+    }
+
+    /** __index metamethod of the state userdata. */
+    static int stateIndex(lua_State *L) {
+        SharedState *store = checkState(L);
+        size_t len;
+        const char *key = luaL_checklstring(L, 2, &len);
+        SharedState::Value v = store->get(string_view(key, len));
+        switch (v.type) {
+            case SharedState::Type::BOOL:
+                lua_pushboolean(L, v.i);
+                break;
+            case SharedState::Type::INT:
+                lua_pushinteger(L, v.i);
+                break;
+            case SharedState::Type::STRING:
+                lua_pushlstring(L, v.s, v.len);
+                break;
+            default:
+                lua_pushnil(L);
+        }
+        return 1;
+    }
+
+    /** __newindex metamethod of the state userdata. */
+    static int stateNewIndex(lua_State *L) {
+        SharedState *store = checkState(L);
+        size_t len;
+        const char *key = luaL_checklstring(L, 2, &len);
+        SharedState::Value v;
+        bool ok = true;
+        try {
+            switch (lua_type(L, 3)) {
+                case LUA_TNIL:
+                    break;
+                case LUA_TBOOLEAN:
+                    v = SharedState::Value::boolean(lua_toboolean(L, 3));
+                    break;
+                case LUA_TNUMBER:
+                    if (!lua_isinteger(L, 3))
+                        return luaL_error(L, "state.%s: only integers can be shared", key);
+                    v = SharedState::Value::integer(lua_tointeger(L, 3));
+                    break;
+                case LUA_TSTRING: {
+                    size_t slen;
+                    const char *s = lua_tolstring(L, 3, &slen);
+                    v = SharedState::Value::string(string_view(s, slen));
+                    break;
+                }
+                default:
+                    return luaL_error(L, "state.%s: cannot share a %s", key,
+                                      luaL_typename(L, 3));
+            }
+            store->set(string_view(key, len), v);
+        } catch (const exception &e) {
+            // lua_error() does not return, raise it once the exception
+            // has been destroyed.
+            lua_pushfstring(L, "state.%s: %s", key, e.what());
+            ok = false;
+        }
+        if (!ok)
+            return lua_error(L);
+        return 0;
+    }
+
+    static int stateVersion(lua_State *L) {
+        SharedState *store = (SharedState *) lua_touserdata(L, lua_upvalueindex(1));
+        size_t len;
+        const char *key = luaL_checklstring(L, 1, &len);
+        lua_pushinteger(L, store->version(string_view(key, len)));
+        return 1;
+    }
+
+    void openSharedState(lua_State *L, SharedState *store) {
+        SharedState **ud = (SharedState **) lua_newuserdata(L, sizeof(store));
+        *ud = store;
+        if (luaL_newmetatable(L, "Hawck.state")) {
+            lua_pushcfunction(L, stateIndex);
+            lua_setfield(L, -2, "__index");
+            lua_pushcfunction(L, stateNewIndex);
+            lua_setfield(L, -2, "__newindex");
+        }
+        lua_setmetatable(L, -2);
+        lua_setglobal(L, "state");
+
+        lua_pushlightuserdata(L, store);
+        lua_pushcclosure(L, stateVersion, 1);
+        lua_setglobal(L, "__stateVersion");
+    }
+}
@@ -421,6 +421,10 @@ namespace Lua {
             return lua_type(L, idx) == LUA_TSTRING;
         }
 
+        inline bool checkLuaType(int idx, const std::string&) noexcept {
+            return lua_type(L, idx) == LUA_TSTRING;
+        }
+
         inline bool checkLuaType(int idx, bool) noexcept {
             return lua_type(L, idx) == LUA_TBOOLEAN;
         }
@@ -447,6 +451,12 @@ namespace Lua {
             return lua_tostring(L, idx);
         }
 
+        inline std::string luaGetVal(int idx, std::string) noexcept {
+            size_t sz;
+            const char *s = lua_tolstring(L, idx, &sz);
+            return std::string(s, sz);
+        }
+
         static inline constexpr int varargLength() noexcept {
             return 0;
         }
@@ -26,17 +26,23 @@
  * =====================================================================================
  */
 #include <thread>
+#include <algorithm>
 #include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
 
 #define DEBUG_LOG_KEYS 0
 
 extern "C" {
-    #include <gtk/gtk.h>
-    #include <glib.h>
-    #include <libnotify/notify.h>
+    #include <dirent.h>
+    #include <signal.h>
     #include <unistd.h>
     #include <sys/stat.h>
     #include <syslog.h>
+    #include <poll.h>
+    #include <stdio.h>
+    #include <string.h>
 }
 
 #include "Daemon.hpp"
@@ -45,12 +51,21 @@ extern "C" {
 #include "utils.hpp"
 #include "Permissions.hpp"
 #include "LuaConfig.hpp"
+#include "LuaEventCodes.hpp"
+#include "LuaSharedState.hpp"
+#include "LuaModuleCache.hpp"
+#include "EventCodes.hpp"
+#include "InputTrace.hpp"
+#include "XTestUDevice.hpp"
+#include "WaylandUDevice.hpp"
 
 using namespace Lua;
 using namespace Permissions;
 using namespace std;
 
-static const char *event_str[EV_CNT];
+/** Time MacroD has to be without key events before stubs are
+ *  instantiated in the background. */
+static constexpr auto IDLE_LOAD_DELAY = chrono::seconds(2);
 
 inline bool goodLuaFilename(const string& name) {
     return !(
@@ -58,36 +73,45 @@ inline bool goodLuaFilename(const string& name) {
     );
 }
 
-static inline void initEventStrs()
-{
-    event_str[EV_SYN      ] = "SYN"       ;
-    event_str[EV_KEY      ] = "KEY"       ;
-    event_str[EV_REL      ] = "REL"       ;
-    event_str[EV_ABS      ] = "ABS"       ;
-    event_str[EV_MSC      ] = "MSC"       ;
-    event_str[EV_SW       ] = "SW"        ;
-    event_str[EV_LED      ] = "LED"       ;
-    event_str[EV_SND      ] = "SND"       ;
-    event_str[EV_REP      ] = "REP"       ;
-    event_str[EV_FF       ] = "FF"        ;
-    event_str[EV_PWR      ] = "PWR"       ;
-    event_str[EV_FF_STATUS] = "FF_STATUS" ;
-    event_str[EV_MAX      ] = "MAX"       ;
+/** Modifiers are in the __keys of every script, so they do not cause
+ *  stubs to be instantiated. */
+static inline bool isModifier(int code) {
+    switch (code) {
+        case KEY_LEFTCTRL: case KEY_RIGHTCTRL:
+        case KEY_LEFTSHIFT: case KEY_RIGHTSHIFT:
+        case KEY_LEFTALT: case KEY_RIGHTALT:
+        case KEY_LEFTMETA: case KEY_RIGHTMETA:
+            return true;
+        default:
+            return false;
+    }
 }
 
 MacroDaemon::MacroDaemon()
-    : kbd_srv("/var/lib/hawck-input/kbd.sock")
+    : recorder(&remote_udev),
+      notifier("Hawck")
 {
-    auto [grp, grpbuf] = getgroup("hawck-input-share");
-    chown("/var/lib/hawck-input/kbd.sock", getuid(), grp->gr_gid);
-    chmod("/var/lib/hawck-input/kbd.sock", 0660);
-    initEventStrs();
-    notify_init("Hawck");
+    remote_udev.setRecorder(&recorder);
     string HOME(getenv("HOME"));
     home_dir = HOME + "/.local/share/hawck";
+    try {
+        module_cache.open(MODULE_CACHE_PATH);
+        syslog(LOG_INFO, "Using %zu modules from %s", module_cache.size(),
+               MODULE_CACHE_PATH);
+    } catch (const SystemError &e) {
+        syslog(LOG_INFO, "No module cache, loading modules from source: %s", e.what());
+    }
     initScriptDir(home_dir + "/scripts-enabled");
 }
 
+void MacroDaemon::listen() {
+    string sock_path = kbdSocketPath(getuid());
+    kbd_srv = make_unique<UNIXServer>(sock_path);
+    auto [grp, grpbuf] = getgroup("hawck-input-share");
+    chown(sock_path.c_str(), getuid(), grp->gr_gid);
+    chmod(sock_path.c_str(), 0660);
+}
+
 void MacroDaemon::getConnection() {
     if (kbd_com)
         delete kbd_com;
@@ -96,7 +120,7 @@ void MacroDaemon::getConnection() {
     // Keep looping around until we get a connection.
     for (;;) {
         try {
-            int fd = kbd_srv.accept();
+            int fd = kbd_srv->accept();
             kbd_com = new UNIXSocket<KBDAction>(fd);
             syslog(LOG_INFO, "Got a connection");
             break;
@@ -104,13 +128,42 @@ void MacroDaemon::getConnection() {
             cout << "MacroDaemon accept() error: " << e.what() << endl;
         }
         // Wait for 0.1 seconds
-        usleep(100000);
+        clock->sleepFor(chrono::milliseconds(100));
     }
 
     remote_udev.setConnection(kbd_com);
+    reported_idle = -1;
+}
+
+void MacroDaemon::reportIdle() {
+    bool idle = disabled;
+    if (!idle) {
+        lock_guard<mutex> lock(scripts_mtx);
+        idle = stubs.empty() &&
+               none_of(scripts.begin(), scripts.end(),
+                       [](const auto &p) { return p.second->isEnabled(); });
+    }
+    if ((int) idle == reported_idle)
+        return;
+
+    KBDAction ac;
+    memset(&ac, 0, sizeof(ac));
+    ac.state = 1;
+    ac.ev.value = !idle;
+    kbd_com->send(&ac);
+    reported_idle = idle;
+
+    // Keys are not seen while idle, so they can't be tracked.
+    if (idle) {
+        lock_guard<mutex> lock(scripts_mtx);
+        held_keys.clear();
+    }
 }
 
 MacroDaemon::~MacroDaemon() {
+    stop_idle_loader = true;
+    if (idle_loader.joinable())
+        idle_loader.join();
     for (auto &[_, s] : scripts)
         delete s;
 }
@@ -125,7 +178,7 @@ void MacroDaemon::initScriptDir(const std::string &dir_path) {
 
         // Attempt to load the script:
         try {
-            loadScript(path);
+            loadScript(path, true);
         } catch (exception &e) {
             cout << "Error: " << e.what() << endl;
         }
@@ -133,7 +186,7 @@ void MacroDaemon::initScriptDir(const std::string &dir_path) {
     auto files = mkuniq(fsw.addFrom(dir_path));
 }
 
-void MacroDaemon::loadScript(const std::string &rel_path) {
+void MacroDaemon::loadScript(const std::string &rel_path, bool lazy) {
     string bn = pathBasename(rel_path);
     if (!goodLuaFilename(bn)) {
         cout << "Wrong filename, not loading: " << bn << endl;
@@ -166,86 +219,229 @@ void MacroDaemon::loadScript(const std::string &rel_path) {
         return;
     }
 
+    string name = pathBasename(rel_path);
+    string hash = keyCacheHash(path);
+    vector<int> keys;
+
+    if (lazy && readKeyCache(name, hash, keys)) {
+        unloadScript(name);
+        cout << "Deferred loading of script: " << name << endl;
+        stubs[name] = {path, keys};
+        return;
+    }
+
+    auto t_start = chrono::steady_clock::now();
     auto sc = mkuniq(new Script());
+    openEventCodes(sc->getL());
+    openSharedState(sc->getL(), &shared_state);
+    openModuleCache(sc->getL(), &module_cache);
     sc->call("require", "init");
     sc->open(&remote_udev, "udev");
+    sc->open(&recorder, "macros");
+    sc->open(&launcher, "launcher");
     sc->from(path);
+    loadScriptApps(sc.get());
+    writeKeyCache(name, hash, scriptKeys(sc.get()));
 
-    string name = pathBasename(rel_path);
-
-    if (scripts.find(name) != scripts.end()) {
-        // Script already loaded, reload it
-        delete scripts[name];
-        scripts.erase(name);
-    }
+    // Script already loaded, reload it
+    unloadScript(name);
 
     cout << "Loaded script: " << name << endl;
     scripts[name] = sc.release();
+    auto load_time = chrono::steady_clock::now() - t_start;
+    blackbox.add(Blackbox::RELOADS);
+    blackbox.add(Blackbox::RELOAD_US,
+                 chrono::duration_cast<chrono::microseconds>(load_time).count());
 }
 
 void MacroDaemon::unloadScript(const std::string &rel_path) {
     string name = pathBasename(rel_path);
     if (scripts.find(name) != scripts.end()) {
         cout << "delete scripts[" << name << "]" << endl;
+        script_apps.erase(scripts[name]);
         delete scripts[name];
         scripts.erase(name);
     }
+    stubs.erase(name);
+}
+
+void MacroDaemon::instantiate(const std::string &name) {
+    auto it = stubs.find(name);
+    if (it == stubs.end())
+        return;
+    // The stub is removed first so that a broken script is not
+    // retried on every key press.
+    string path = it->second.path;
+    stubs.erase(it);
+    try {
+        loadScript(path);
+    } catch (const exception &e) {
+        syslog(LOG_ERR, "Unable to load script %s: %s", name.c_str(), e.what());
+        return;
+    }
+
+    // Let the script know about keys that were pressed before it
+    // existed, e.g the ctrl in ctrl+x.
+    auto sc_it = scripts.find(name);
+    if (sc_it == scripts.end())
+        return;
+    lua_State *L = sc_it->second->getL();
+    for (int code : held_keys) {
+        lua_getglobal(L, "kbd");
+        lua_getfield(L, -1, "prepare");
+        lua_insert(L, -2);
+        lua_pushinteger(L, 1);
+        lua_pushinteger(L, code);
+        lua_pushinteger(L, EV_KEY);
+        if (lua_pcall(L, 4, 0, 0) != LUA_OK)
+            lua_pop(L, 1);
+    }
+}
+
+void MacroDaemon::idleLoad() {
+    using namespace std::chrono;
+    while (!stop_idle_loader) {
+        clock->sleepFor(milliseconds(250));
+        auto since = clock->now() - Clock::time_point(Clock::duration(last_event_t));
+        if (since < IDLE_LOAD_DELAY)
+            continue;
+        lock_guard<mutex> lock(scripts_mtx);
+        if (!stubs.empty())
+            instantiate(stubs.begin()->first);
+    }
+}
+
+vector<int> MacroDaemon::scriptKeys(Lua::Script *sc) {
+    lua_State *L = sc->getL();
+    vector<int> keys;
+
+    // Use raw access, _G is protected against reading undefined variables.
+    lua_rawgeti(L, LUA_REGISTRYINDEX, LUA_RIDX_GLOBALS);
+    lua_pushstring(L, "kbd");
+    lua_rawget(L, -2);
+    lua_pushstring(L, "__keys");
+    lua_rawget(L, -3);
+    if (lua_istable(L, -1) && !lua_isnil(L, -2)) {
+        lua_pushnil(L);
+        while (lua_next(L, -2)) {
+            lua_pop(L, 1);
+            // Stack: _G, kbd, __keys, name
+            lua_getfield(L, -3, "getKeysym");
+            lua_pushvalue(L, -4);
+            lua_pushvalue(L, -3);
+            // Unknown key names raise errors, they are just left out.
+            if (lua_pcall(L, 2, 1, 0) == LUA_OK && lua_isnumber(L, -1))
+                keys.push_back(lua_tointeger(L, -1));
+            lua_pop(L, 1);
+        }
+    }
+    lua_pop(L, 3);
+
+    sort(keys.begin(), keys.end());
+    keys.erase(unique(keys.begin(), keys.end()), keys.end());
+    return keys;
+}
+
+string MacroDaemon::keyCacheHash(const std::string &path) {
+    // FNV-1a over the script and the configuration.
+    uint64_t h = 14695981039346656037ull;
+    for (const string &p : {path, home_dir + "/cfg.lua"}) {
+        ifstream file(p, ios::binary);
+        char buf[4096];
+        while (file.read(buf, sizeof(buf)), file.gcount() > 0)
+            for (streamsize i = 0; i < file.gcount(); i++) {
+                h ^= (uint8_t) buf[i];
+                h *= 1099511628211ull;
+            }
+    }
+    stringstream ss;
+    ss << hex << setw(16) << setfill('0') << h;
+    return ss.str();
 }
 
-struct script_error_info {
-    lua_Debug ar;
-    char path[];
-};
-
-#if 0
-// FIXME: See FIXME in MacroDaemon::notify
-// TODO: My idea for this would be to run "gedit $info->path +$info->ar.currentline",
-//       then figure out what other editors support opening a file on a specific line
-//       and let the user choose which editor to use.
-extern "C" void viewSource(NotifyNotification *n, char *action, script_error_info *info) {
-    pid_t pid;
-    fprintf(stderr, "Line nr: %d\n", info->ar.currentline);
-    fprintf(stderr, "path: %s\n", info->path);
-    fflush(stderr);
+bool MacroDaemon::readKeyCache(const std::string &name, const std::string &hash,
+                               vector<int> &keys)
+{
+    ifstream file(home_dir + "/cache/" + name + ".keys");
+    string file_hash;
+    if (!(file >> file_hash) || file_hash != hash)
+        return false;
+    keys.clear();
+    int code;
+    while (file >> code)
+        keys.push_back(code);
+    return file.eof();
 }
-#endif
 
-void f(void *) {
-    fprintf(stderr, "GOT EM\n"); fflush(stderr);
+void MacroDaemon::writeKeyCache(const std::string &name, const std::string &hash,
+                                const vector<int> &keys)
+{
+    string dir = home_dir + "/cache";
+    if (mkdir(dir.c_str(), 0700) == -1 && errno != EEXIST) {
+        syslog(LOG_WARNING, "Unable to create %s: %s", dir.c_str(), strerror(errno));
+        return;
+    }
+    // Write to a temporary file first, so that a MacroD that is
+    // killed half way through does not leave a truncated cache.
+    string path = dir + "/" + name + ".keys";
+    string tmp_path = path + ".tmp";
+    {
+        ofstream file(tmp_path);
+        file << hash << "\n";
+        for (int code : keys)
+            file << code << "\n";
+        if (!file) {
+            syslog(LOG_WARNING, "Unable to write key cache: %s", tmp_path.c_str());
+            return;
+        }
+    }
+    if (rename(tmp_path.c_str(), path.c_str()) == -1)
+        syslog(LOG_WARNING, "Unable to write key cache %s: %s", path.c_str(), strerror(errno));
+}
+
+void MacroDaemon::loadScriptApps(Lua::Script *sc) {
+    lua_State *L = sc->getL();
+    vector<int> apps;
+
+    // Use raw access, _G is protected against reading undefined variables.
+    lua_rawgeti(L, LUA_REGISTRYINDEX, LUA_RIDX_GLOBALS);
+    lua_pushstring(L, "__apps");
+    lua_rawget(L, -2);
+    if (lua_istable(L, -1)) {
+        size_t len = lua_rawlen(L, -1);
+        for (size_t i = 1; i <= len; i++) {
+            lua_rawgeti(L, -1, i);
+            if (lua_type(L, -1) == LUA_TSTRING)
+                apps.push_back(focus.intern(lua_tostring(L, -1)));
+            lua_pop(L, 1);
+        }
+    }
+    lua_pop(L, 2);
+
+    if (apps.empty())
+        script_apps.erase(sc);
+    else
+        script_apps[sc] = apps;
+}
+
+bool MacroDaemon::scriptIsActive(Lua::Script *sc, int focus_id) {
+    // Without focus information every script is active.
+    if (focus_id == FOCUS_UNKNOWN)
+        return true;
+    auto it = script_apps.find(sc);
+    if (it == script_apps.end())
+        return true;
+    const auto &apps = it->second;
+    return find(apps.begin(), apps.end(), focus_id) != apps.end();
 }
 
 void MacroDaemon::notify(string title, string msg) {
-    NotifyNotification *n;
     char cwd[PATH_MAX];
     getcwd(cwd, sizeof(cwd));
     string fire_icon_path(cwd);
     fire_icon_path += "/icons/fire.svg";
-    n = notify_notification_new(title.c_str(), msg.c_str(), fire_icon_path.c_str());
-    notify_notification_set_timeout(n, 12000);
-    notify_notification_set_urgency(n, NOTIFY_URGENCY_CRITICAL);
-    notify_notification_set_app_name(n, "Hawck");
-
-    // FIXME: The viewSource callback is not executed.
-    // Apparently I need to call g_main_loop_run, I tried it and nothing
-    // happened, I have no idea how to get this working.
-    // Furthermore g_main_loop_run is a blocking call so I'd have to
-    // restructure this so that the notification stuff happens in another
-    // thread.
-    #if 0
-    script_error_info *info =
-        (script_error_info *) malloc(sizeof(script_error_info) + script->abs_src.size() + 1);
-    memcpy(&info->ar, ar, sizeof(info->ar));
-    strcpy(info->path, script->abs_src.c_str());
-    notify_notification_add_action(n,
-                                   "view_source",
-                                   "View source",
-                                   NOTIFY_ACTION_CALLBACK(viewSource),
-                                   info,
-                                   free);
-    g_signal_connect(n, "closed", free, info);
-    #endif
-    
-    if (!notify_notification_show(n, nullptr)) {
+
+    if (!notifier.show(title, msg, fire_icon_path, Urgency::CRITICAL, 12000)) {
         fprintf(stderr, "Failed to show notification: %s\n", msg.c_str());
     }
 }
@@ -274,28 +470,200 @@ bool MacroDaemon::runScript(Lua::Script *sc, const struct input_event &ev) {
     return repeat;
 }
 
+void MacroDaemon::notifyStateChanged() {
+    uint64_t gen = shared_state.generation();
+    if (gen == notified_gen)
+        return;
+    notified_gen = gen;
+    for (auto &[_, sc] : scripts) {
+        if (!sc->isEnabled())
+            continue;
+        try {
+            sc->call("__stateChanged");
+        } catch (const LuaError &e) {
+            syslog(LOG_ERR, "LUA:%s", e.fmtReport().c_str());
+        }
+    }
+}
+
 void MacroDaemon::reloadAll() {
     lock_guard<mutex> lock(scripts_mtx);
     ChDir cd(home_dir + "/scripts");
+    // The key codes of stubs depend on the keymap, so they are
+    // instantiated instead of being reloaded.
+    vector<string> stub_names;
+    for (auto &[name, _] : stubs)
+        stub_names.push_back(name);
     for (auto &[_, sc] : scripts) {
         try {
             sc->setEnabled(true);
             sc->reset();
+            openEventCodes(sc->getL());
+            openSharedState(sc->getL(), &shared_state);
+            openModuleCache(sc->getL(), &module_cache);
             sc->call("require", "init");
             sc->open(&remote_udev, "udev");
+            sc->open(&recorder, "macros");
+            sc->open(&launcher, "launcher");
             sc->reload();
+            loadScriptApps(sc);
         } catch (const LuaError& e) {
             syslog(LOG_ERR, "Error when reloading script: %s", e.what());
             sc->setEnabled(false);
         }
     }
+    for (const auto &name : stub_names)
+        instantiate(name);
+}
+
+void MacroDaemon::setOutput(const std::string &name) {
+    string use = name;
+    if (name == "auto") {
+        // XTest only reaches X11 clients, so it is not used on Wayland.
+        if (getenv("WAYLAND_DISPLAY"))
+            use = "wayland";
+        else if (getenv("DISPLAY"))
+            use = "xtest";
+        else
+            use = "uinput";
+    }
+
+    lock_guard<mutex> lock(scripts_mtx);
+    remote_udev.setBackend(nullptr);
+    output.reset();
+    try {
+        if (use == "xtest")
+            output = make_unique<XTestUDevice>();
+        else if (use == "wayland")
+            output = make_unique<WaylandUDevice>();
+        else if (use != "uinput")
+            throw invalid_argument("Unknown output: " + name);
+    } catch (const SystemError &e) {
+        syslog(LOG_WARNING, "Unable to use %s output, falling back to uinput: %s",
+               use.c_str(), e.what());
+        return;
+    }
+    remote_udev.setBackend(output.get());
+    syslog(LOG_INFO, "Using %s output", use.c_str());
+}
+
+void MacroDaemon::tickBlackbox() {
+    if (!blackbox.tick())
+        return;
+    // Lua memory is sampled once per second.
+    lock_guard<mutex> lock(scripts_mtx);
+    int kib = 0;
+    for (auto &[_, sc] : scripts)
+        kib += lua_gc(sc->getL(), LUA_GCCOUNT, 0);
+    blackbox.gauge(Blackbox::LUA_KIB, kib);
+}
+
+void MacroDaemon::processEvent(const struct input_event &ev) {
+    bool repeat = true;
+
+    #if DEBUG_LOG_KEYS
+    syslog(LOG_DEBUG, "%s %s %d", EventCodes::typeName(ev.type),
+           EventCodes::codeName(ev.type, ev.code), ev.value);
+    #endif
+
+    last_event_t = clock->now().time_since_epoch().count();
+    auto t_start = chrono::steady_clock::now();
+    tickBlackbox();
+
+    {
+        lock_guard<mutex> lock(scripts_mtx);
+        if (ev.value == 1)
+            held_keys.insert(ev.code);
+        else if (ev.value == 0)
+            held_keys.erase(ev.code);
+    }
+
+    if (!( (!eval_keydown && ev.value == 1) ||
+           (!eval_keyup && ev.value == 0) ) &&
+        !disabled)
+    {
+        lock_guard<mutex> lock(scripts_mtx);
+
+        // Create the scripts that are interested in the key.
+        if (!stubs.empty() && !isModifier(ev.code)) {
+            vector<string> names;
+            for (auto &[name, stub] : stubs)
+                if (binary_search(stub.keys.begin(), stub.keys.end(), (int) ev.code))
+                    names.push_back(name);
+            for (const auto &name : names)
+                instantiate(name);
+        }
+
+        int focus_id = focus.current();
+        // Look for a script match.
+        for (auto &[_, sc] : scripts)
+            if (sc->isEnabled() && scriptIsActive(sc, focus_id) &&
+                !(repeat = runScript(sc, ev)))
+                break;
+
+        notifyStateChanged();
+    }
+
+    if (repeat)
+        remote_udev.emit(&ev);
+
+    remote_udev.done();
+
+    auto time = chrono::steady_clock::now() - t_start;
+    blackbox.add(Blackbox::EVENTS);
+    blackbox.latency(chrono::duration_cast<chrono::microseconds>(time).count());
+}
+
+void MacroDaemon::replay(const string &path) {
+    using namespace std::chrono;
+
+    auto evs = readTrace(path);
+    vector<double> lat_us;
+    lat_us.reserve(evs.size());
+    auto t_start = steady_clock::now();
+    for (const auto &ev : evs) {
+        // InputD only sends key events.
+        if (ev.type != EV_KEY)
+            continue;
+        auto t0 = steady_clock::now();
+        processEvent(ev);
+        lat_us.push_back(duration<double, micro>(steady_clock::now() - t0).count());
+    }
+    double total_ms = duration<double, milli>(steady_clock::now() - t_start).count();
+
+    if (lat_us.empty()) {
+        cout << "No key events in " << path << endl;
+        return;
+    }
+    sort(lat_us.begin(), lat_us.end());
+    double sum = 0;
+    for (double l : lat_us)
+        sum += l;
+    auto pct = [&](double p) {
+                   return lat_us[min(lat_us.size() - 1, (size_t) (p * lat_us.size()))];
+               };
+    printf("events: %zu\n"
+           "total: %.2f ms\n"
+           "mean: %.2f us\n"
+           "p50: %.2f us\n"
+           "p99: %.2f us\n"
+           "max: %.2f us\n",
+           lat_us.size(), total_ms, sum / lat_us.size(),
+           pct(0.5), pct(0.99), lat_us.back());
 }
 
 void MacroDaemon::run() {
     signal(SIGPIPE, handleSigPipe);
 
-    KBDAction action;
-    struct input_event &ev = action.ev;
+    KBDAction actions[MAX_BATCH];
+
+    listen();
+
+    try {
+        blackbox.open(home_dir + "/blackbox");
+    } catch (const SystemError &e) {
+        syslog(LOG_WARNING, "Unable to open the black box: %s", e.what());
+    }
 
     // Setup/start LuaConfig
     LuaConfig conf(home_dir + "/lua-comm.fifo", home_dir + "/json-comm.fifo", home_dir + "/cfg.lua");
@@ -310,6 +678,8 @@ void MacroDaemon::run() {
     #undef _ADDCFG
     conf.addOption<string>("keymap", [this](string) {reloadAll();});
     conf.begin();
+
+    focus.begin();
     
     fsw.setWatchDirs(true);
     fsw.setAutoAdd(false);
@@ -337,34 +707,34 @@ void MacroDaemon::run() {
               });
 
 
+    idle_loader = thread([this]() { idleLoad(); });
+
     getConnection();
 
     cout << "Running MacroD mainloop ..." << endl;
 
     for (;;) {
         try {
-            bool repeat = true;
-
-            kbd_com->recv(&action);
-
-            if (!( (!eval_keydown && ev.value == 1) ||
-                   (!eval_keyup && ev.value == 0) ) &&
-                !disabled)
-            {
-                lock_guard<mutex> lock(scripts_mtx);
-                // Look for a script match.
-                for (auto &[_, sc] : scripts)
-                    if (sc->isEnabled() && !(repeat = runScript(sc, ev)))
-                        break;
-            }
-        
-            if (repeat)
-                remote_udev.emit(&ev);
-
-            remote_udev.done();
+            reportIdle();
+            // The last second before a pause is written out here,
+            // and reloads are filed under the right second.
+            tickBlackbox();
+            // Wake up now and then to report changes to the scripts.
+            struct pollfd pfd = {kbd_com->getFd(), POLLIN, 0};
+            if (poll(&pfd, 1, IDLE_REPORT_MS) <= 0)
+                continue;
+
+            // InputD sends the keys it read in one wakeup together, they
+            // are answered with a single reply, one done marker per key.
+            size_t n = kbd_com->recvMany(actions, MAX_BATCH);
+            remote_udev.beginBatch();
+            for (size_t i = 0; i < n; i++)
+                processEvent(actions[i].ev);
+            remote_udev.endBatch();
         } catch (const SocketError& e) {
             // Reset connection
             syslog(LOG_ERR, "Socket error: %s", e.what());
+            blackbox.add(Blackbox::TIMEOUTS);
             notify("Socket error", "Connection to InputD timed out, reconnecting ...");
             getConnection();
         }
@@ -37,6 +37,8 @@
 #include <memory>
 #include <string>
 #include <chrono>
+#include <thread>
+#include <set>
 
 extern "C" {
     #include <unistd.h>
@@ -55,8 +57,23 @@ extern "C" {
 #include "KBDAction.hpp"
 #include "LuaUtils.hpp"
 #include "RemoteUDevice.hpp"
+#include "MacroRecorder.hpp"
+#include "Launcher.hpp"
+#include "SharedState.hpp"
+#include "ModuleCache.hpp"
+#include "Clock.hpp"
+#include "Blackbox.hpp"
+#include "FocusWatcher.hpp"
 #include "FSWatcher.hpp"
 #include "FIFOWatcher.hpp"
+#include "Notifier.hpp"
+
+/** Maximum number of keys read from InputD at once. */
+static constexpr size_t MAX_BATCH = 64;
+
+/** How often InputD is told about changes to the scripts when
+ *  there are no keys, in milliseconds. */
+static constexpr int IDLE_REPORT_MS = 100;
 
 /** Macro daemon.
  *
@@ -65,12 +82,58 @@ extern "C" {
  */
 class MacroDaemon {
 private:
-    UNIXServer kbd_srv;
+    /** Created by run(), replay() does not listen for InputD. */
+    std::unique_ptr<UNIXServer> kbd_srv;
     UNIXSocket<KBDAction> *kbd_com = nullptr;
     std::mutex scripts_mtx;
     std::unordered_map<std::string, Lua::Script *> scripts;
+    /** Script that has not been instantiated yet, its Lua state is
+     *  created when one of its keys arrives, or when MacroD is idle. */
+    struct ScriptStub {
+        /** Absolute path to the script. */
+        std::string path;
+        /** Sorted key codes from __keys, read from the key cache. */
+        std::vector<int> keys;
+    };
+    /** Scripts that have not been instantiated, by name. */
+    std::unordered_map<std::string, ScriptStub> stubs;
+    /** Instantiates stubs in the background. */
+    std::thread idle_loader;
+    std::atomic<bool> stop_idle_loader = false;
+    /** Keys currently held down, given to scripts when they are
+     *  instantiated. */
+    std::set<int> held_keys;
+    /** Time of the last key event, in Clock ticks. */
+    std::atomic<Clock::duration::rep> last_event_t = 0;
+    /** Whether InputD was last told that there are no scripts to run,
+     *  -1 if it has not been told anything on this connection. */
+    int reported_idle = -1;
+    /** Used for idle loading and the delay between connection
+     *  attempts. */
+    Clock *clock = &Clock::system();
     RemoteUDevice remote_udev;
+    /** Device that output is applied on instead of InputD's uinput
+     *  device, may be null. */
+    std::unique_ptr<IUDevice> output;
+    MacroRecorder recorder;
+    /** Shared by all scripts as `launcher`. */
+    Launcher launcher;
+    /** Shared by all scripts as `state`. */
+    SharedState shared_state;
+    /** Generation of shared_state that scripts were last notified of. */
+    uint64_t notified_gen = 0;
+    /** Precompiled LLib modules and keymaps, mapped from a file that
+     *  every MacroD on the machine shares. */
+    ModuleCache module_cache;
+    /** Per-second performance aggregates that survive crashes, read
+     *  with hawck-blackbox. */
+    Blackbox blackbox;
     FSWatcher fsw;
+    FocusWatcher focus;
+    Notifier notifier;
+    /** Interned application ids of the applications each script
+     *  applies to, scripts without an entry apply everywhere. */
+    std::unordered_map<Lua::Script *, std::vector<int>> script_apps;
     std::string home_dir;
 
     std::atomic<bool> notify_on_err = true;
@@ -80,7 +143,8 @@ private:
     std::atomic<bool> eval_repeat = true;
     std::atomic<bool> disabled = false;
 
-    /** Display freedesktop DBus notification. */
+    /** Display freedesktop DBus notification, libnotify is loaded on
+     *  first use. */
     void notify(std::string title,
                 std::string msg);
 
@@ -92,8 +156,48 @@ private:
      */
     bool runScript(Lua::Script *sc, const struct input_event &ev);
 
-    /** Load a Lua script. */
-    void loadScript(const std::string &path);
+    /** Call __stateChanged() in all scripts if the shared state has
+     *  changed since the last call. */
+    void notifyStateChanged();
+
+    /** Check if a script applies to the focused application. */
+    bool scriptIsActive(Lua::Script *sc, int focus_id);
+
+    /** Read the applications that a script applies to from its
+     *  __apps table. */
+    void loadScriptApps(Lua::Script *sc);
+
+    /** Load a Lua script.
+     *
+     * @param path Path to the script.
+     * @param lazy Only create a stub if the key cache for the script is
+     *             up to date.
+     */
+    void loadScript(const std::string &path, bool lazy = false);
+
+    /** Create the Lua state of a stub, requires scripts_mtx to be held. */
+    void instantiate(const std::string &name);
+
+    /** Instantiate stubs one by one while no keys are arriving. */
+    void idleLoad();
+
+    /** Read the key codes from the __keys table of a script. */
+    std::vector<int> scriptKeys(Lua::Script *sc);
+
+    /** Hash of a script and the configuration, the key codes of a script
+     *  depend on the keymap set in cfg.lua */
+    std::string keyCacheHash(const std::string &path);
+
+    /** Read the cached key codes of a script.
+     *
+     * @return True if the cache exists and matches the hash.
+     */
+    bool readKeyCache(const std::string &name, const std::string &hash,
+                      std::vector<int> &keys);
+
+    /** Write the key codes of a script to the cache. */
+    void writeKeyCache(const std::string &name, const std::string &hash,
+                       const std::vector<int> &keys);
 
     /** Unload a Lua script */
     void unloadScript(const std::string &path);
@@ -104,6 +208,21 @@ private:
     /** Get a connection to listen for keys on. */
     void getConnection();
 
+    /** Create the socket that InputD connects to. */
+    void listen();
+
+    /** Tell InputD when it can stop passing keys to MacroD, because it
+     *  is disabled or has no enabled scripts, and when it has to start
+     *  again. */
+    void reportIdle();
+
+    /** Write the black box record of the last second when a new second
+     *  has started. */
+    void tickBlackbox();
+
+    /** Run the scripts on a key event, and emit the result. */
+    void processEvent(const struct input_event &ev);
+
     /** Reload all scripts from their sources, this may be necessary
      *  if an important configuration variable like the keymap is set. */
     void reloadAll();
@@ -114,4 +233,29 @@ public:
 
     /** Run the mainloop. */
     void run();
+
+    /** Choose how key events are output.
+     *
+     * Falls back to sending events to InputD, which emits them on its
+     * uinput device, if the backend is unavailable.
+     *
+     * @param name "uinput", "xtest", "wayland", or "auto" to pick
+     *             wayland or xtest depending on the session.
+     * @throws std::invalid_argument for unknown backends.
+     */
+    void setOutput(const std::string &name);
+
+    /** Replace the clock used for idle loading and reconnection
+     *  delays, must be called before run(). */
+    inline void setClock(Clock &c) noexcept {
+        clock = &c;
+    }
+
+    /** Run the key events from a trace file through the enabled
+     *  scripts as fast as possible, without connecting to InputD, and
+     *  print timing statistics.
+     *
+     * @param path Trace file, see InputTrace.hpp
+     */
+    void replay(const std::string &path);
 };
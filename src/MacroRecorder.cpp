@@ -0,0 +1,161 @@
+/* =====================================================================================
+ * Macro recorder.
+ *
+ * Copyright (C) 2018 Jonas Møller (no) <jonasmo441@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * =====================================================================================
+ */
+
+extern "C" {
+    #include <sys/mman.h>
+    #include <syslog.h>
+}
+
+#include "MacroRecorder.hpp"
+#include "RemoteUDevice.hpp"
+#include "SystemError.hpp"
+
+using namespace std;
+
+/** Number of events that fit in the first mapping of a MacroBuffer. */
+static constexpr size_t macro_buffer_start_len = 4096;
+
+/** Hard limit on the number of events in a single macro. */
+static constexpr size_t macro_buffer_max_len = 1 << 22;
+
+MacroBuffer::MacroBuffer() {
+    size_t sz = macro_buffer_start_len * sizeof(MacroEvent);
+    void *p = mmap(nullptr, sz, PROT_READ | PROT_WRITE,
+                   MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (p == MAP_FAILED)
+        throw SystemError("Unable to map macro buffer: ", errno);
+    events = (MacroEvent *) p;
+    cap = macro_buffer_start_len;
+}
+
+MacroBuffer::~MacroBuffer() {
+    munmap(events, cap * sizeof(MacroEvent));
+}
+
+void MacroBuffer::push(const MacroEvent& ev) {
+    if (len >= cap) {
+        if (cap >= macro_buffer_max_len)
+            throw SystemError("Macro is too long");
+        void *p = mremap(events, cap * sizeof(MacroEvent),
+                         2 * cap * sizeof(MacroEvent), MREMAP_MAYMOVE);
+        if (p == MAP_FAILED)
+            throw SystemError("Unable to grow macro buffer: ", errno);
+        events = (MacroEvent *) p;
+        cap *= 2;
+    }
+    events[len++] = ev;
+}
+
+MacroRecorder::MacroRecorder(RemoteUDevice *udev)
+    : LuaIface(this, MacroRecorder_lua_methods),
+      udev(udev)
+{}
+
+MacroRecorder::~MacroRecorder() {
+    for (auto &[_, buf] : macros)
+        delete buf;
+}
+
+void MacroRecorder::record(string name) {
+    if (playing)
+        return;
+
+    auto it = macros.find(name);
+    if (it == macros.end())
+        it = macros.insert({name, new MacroBuffer()}).first;
+    recording = it->second;
+    recording->clear();
+    last_t = SteadyClock::now();
+    syslog(LOG_INFO, "Recording macro: %s", name.c_str());
+}
+
+int MacroRecorder::stop() {
+    if (!recording)
+        return 0;
+    int num = recording->size();
+    recording = nullptr;
+    return num;
+}
+
+void MacroRecorder::capture(int type, int code, int value) {
+    if (!recording || playing)
+        return;
+
+    using namespace std::chrono;
+    auto now = SteadyClock::now();
+    auto dt = duration_cast<microseconds>(now - last_t).count();
+    last_t = now;
+
+    MacroEvent ev;
+    ev.dt_us = (dt > UINT32_MAX) ? UINT32_MAX : dt;
+    ev.type = type;
+    ev.code = code;
+    ev.value = value;
+    try {
+        recording->push(ev);
+    } catch (const SystemError &e) {
+        syslog(LOG_ERR, "Stopped recording: %s", e.what());
+        recording = nullptr;
+    }
+}
+
+void MacroRecorder::playBuffer(const MacroBuffer *buf, bool timed) {
+    // Don't record the playback, this would also make it possible
+    // to replay a macro into itself.
+    playing = true;
+    try {
+        for (const MacroEvent *ev = buf->begin(); ev != buf->end(); ev++) {
+            if (timed && ev->dt_us >= min_gap_us)
+                udev->pause(min(ev->dt_us, max_gap_us));
+            udev->emit(ev->type, ev->code, ev->value);
+        }
+        udev->flush();
+    } catch (...) {
+        playing = false;
+        throw;
+    }
+    playing = false;
+}
+
+bool MacroRecorder::play(string name) {
+    auto it = macros.find(name);
+    if (it == macros.end() || it->second == recording)
+        return false;
+    playBuffer(it->second, false);
+    return true;
+}
+
+bool MacroRecorder::playTimed(string name) {
+    auto it = macros.find(name);
+    if (it == macros.end() || it->second == recording)
+        return false;
+    playBuffer(it->second, true);
+    return true;
+}
+
+LUA_CREATE_BINDINGS(MacroRecorder_lua_methods)
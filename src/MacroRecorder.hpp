@@ -0,0 +1,178 @@
+/* =====================================================================================
+ * Macro recorder.
+ *
+ * Copyright (C) 2018 Jonas Møller (no) <jonasmo441@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * =====================================================================================
+ */
+
+/** @file MacroRecorder.hpp
+ *
+ * @brief Record and play back sequences of output events.
+ */
+
+#pragma once
+
+#include <string>
+#include <unordered_map>
+#include <chrono>
+
+extern "C" {
+    #include <stdint.h>
+    #include <lua.h>
+    #include <lauxlib.h>
+    #include <lualib.h>
+}
+
+#include "LuaUtils.hpp"
+
+class RemoteUDevice;
+
+/** Compact representation of a recorded event, half the size
+ *  of an input_event. */
+struct MacroEvent {
+    /** Time since the previous event in µs. */
+    uint32_t dt_us;
+    uint16_t type;
+    uint16_t code;
+    int32_t value;
+};
+
+/** Growable buffer of MacroEvents.
+ *
+ * The events are stored in a shared anonymous mapping rather than on
+ * the heap, so large recordings never fragment the allocator used by
+ * the Lua states.
+ */
+class MacroBuffer {
+private:
+    MacroEvent *events = nullptr;
+    size_t len = 0;
+    size_t cap = 0;
+
+public:
+    MacroBuffer();
+    ~MacroBuffer();
+
+    MacroBuffer(const MacroBuffer&) = delete;
+    MacroBuffer& operator=(const MacroBuffer&) = delete;
+
+    /** Append an event, growing the mapping if needed. */
+    void push(const MacroEvent& ev);
+
+    /** Remove all events, the mapping is kept for reuse. */
+    inline void clear() noexcept {
+        len = 0;
+    }
+
+    inline size_t size() const noexcept {
+        return len;
+    }
+
+    inline const MacroEvent *begin() const noexcept {
+        return events;
+    }
+
+    inline const MacroEvent *end() const noexcept {
+        return events + len;
+    }
+};
+
+// Methods to export to Lua
+#define MacroRecorder_lua_methods(M, _)                 \
+    M(MacroRecorder, record, std::string()) _           \
+    M(MacroRecorder, stop) _                            \
+    M(MacroRecorder, play, std::string()) _             \
+    M(MacroRecorder, playTimed, std::string()) _        \
+    M(MacroRecorder, isRecording)
+
+LUA_DECLARE(MacroRecorder_lua_methods)
+
+/** Macro recorder.
+ *
+ * Captures the events that pass through a RemoteUDevice and replays
+ * them with a single call from Lua, so replaying a macro never runs
+ * any Lua code per event.
+ *
+ * Only events that MacroD gets to see can be recorded, i.e keys in
+ * the passthrough set and events emitted by scripts.
+ */
+class MacroRecorder : public Lua::LuaIface<MacroRecorder> {
+    using SteadyClock = std::chrono::steady_clock;
+private:
+    /** Longest pause reproduced by playTimed(), longer pauses are
+     *  shortened as keys typed during playback may wait for it. */
+    static constexpr uint32_t max_gap_us = 250000;
+    /** Shortest pause that playTimed() asks InputD for, shorter
+     *  pauses are left to the event pacing done by InputD. */
+    static constexpr uint32_t min_gap_us = 1000;
+
+    RemoteUDevice *udev;
+    std::unordered_map<std::string, MacroBuffer *> macros;
+    MacroBuffer *recording = nullptr;
+    SteadyClock::time_point last_t;
+    bool playing = false;
+
+    void playBuffer(const MacroBuffer *buf, bool timed);
+
+    LUA_METHOD_COLLECT(MacroRecorder_lua_methods);
+
+public:
+    explicit MacroRecorder(RemoteUDevice *udev);
+
+    ~MacroRecorder();
+
+    /** Start recording into the macro `name`, replacing any
+     *  previous recording with the same name. */
+    void record(std::string name);
+
+    /** Stop recording.
+     *
+     * @return Number of events in the finished recording.
+     */
+    int stop();
+
+    /** Play back a macro as fast as InputD will accept it.
+     *
+     * @return False if there is no such macro.
+     */
+    bool play(std::string name);
+
+    /** Play back a macro with the timing it was recorded with.
+     *
+     * The pauses are sent to InputD along with the events, so this
+     * returns without waiting for the playback to finish.
+     *
+     * @return False if there is no such macro.
+     */
+    bool playTimed(std::string name);
+
+    inline bool isRecording() noexcept {
+        return recording != nullptr;
+    }
+
+    /** Called by the RemoteUDevice for every emitted event. */
+    void capture(int type, int code, int value);
+
+    LUA_EXTRACT(MacroRecorder_lua_methods)
+};
@@ -0,0 +1,119 @@
+/* =====================================================================================
+ * Shared cache of precompiled Lua modules.
+ *
+ * Copyright (C) 2018 Jonas Møller (no) <jonasmo441@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * =====================================================================================
+ */
+
+#include <fstream>
+#include <sstream>
+
+extern "C" {
+    #include <fcntl.h>
+    #include <stdint.h>
+    #include <string.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+}
+
+#include "ModuleCache.hpp"
+#include "SystemError.hpp"
+
+using namespace std;
+
+static constexpr char cache_magic[] = "HWKCACHE 1\n";
+
+/** FNV-1a of a file, must match fnv1a() in gen-cache.lua */
+static bool hashFile(const string &path, uint32_t &h) {
+    ifstream file(path, ios::binary);
+    if (!file)
+        return false;
+    h = 2166136261u;
+    char buf[4096];
+    while (file.read(buf, sizeof(buf)), file.gcount() > 0)
+        for (streamsize i = 0; i < file.gcount(); i++) {
+            h ^= (uint8_t) buf[i];
+            h *= 16777619u;
+        }
+    return true;
+}
+
+ModuleCache::~ModuleCache() {
+    if (map)
+        munmap((void *) map, map_len);
+}
+
+void ModuleCache::open(const string &path) {
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd == -1)
+        throw SystemError("Unable to open " + path + ": ", errno);
+    struct stat st;
+    if (fstat(fd, &st) == -1) {
+        int err = errno;
+        close(fd);
+        throw SystemError("Unable to stat " + path + ": ", err);
+    }
+    size_t len = st.st_size;
+    void *m = (len > 0) ? mmap(nullptr, len, PROT_READ, MAP_SHARED, fd, 0) : MAP_FAILED;
+    int err = errno;
+    close(fd);
+    if (m == MAP_FAILED)
+        throw SystemError("Unable to mmap " + path + ": ", len ? err : EINVAL);
+    const char *data = (const char *) m;
+
+    size_t magic_len = sizeof(cache_magic) - 1;
+    const char *index_end = (const char *) memmem(data, len, "\n\n", 2);
+    if (len < magic_len || memcmp(data, cache_magic, magic_len) || !index_end) {
+        munmap(m, len);
+        throw SystemError("Not a module cache: " + path);
+    }
+
+    unordered_map<string, string_view> found;
+    const char *chunks_start = index_end + 2;
+    size_t chunks_len = len - (chunks_start - data);
+    istringstream index(string(data + magic_len, index_end + 1));
+    string line;
+    while (getline(index, line)) {
+        istringstream fields(line);
+        string name, source;
+        size_t offset, length;
+        uint32_t hash, cur_hash;
+        if (!(fields >> name >> offset >> length >> hex >> hash >> source) ||
+            offset > chunks_len || length > chunks_len - offset)
+        {
+            munmap(m, len);
+            throw SystemError("Corrupt module cache: " + path);
+        }
+        if (!hashFile(source, cur_hash) || cur_hash != hash)
+            continue;
+        found[name] = string_view(chunks_start + offset, length);
+    }
+
+    if (map)
+        munmap((void *) map, map_len);
+    map = data;
+    map_len = len;
+    chunks = move(found);
+}
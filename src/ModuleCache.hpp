@@ -0,0 +1,88 @@
+/* =====================================================================================
+ * Shared cache of precompiled Lua modules.
+ *
+ * Copyright (C) 2018 Jonas Møller (no) <jonasmo441@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * =====================================================================================
+ */
+
+/** @file ModuleCache.hpp
+ *
+ * @brief Read-only cache of precompiled Lua modules, shared between
+ *        all MacroD processes.
+ */
+
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+/** Default location, written by gen-cache.lua during installation. */
+#define MODULE_CACHE_PATH "/var/lib/hawck/module.cache"
+
+/** Precompiled Lua chunks in a file that is mapped read-only, so every
+ *  MacroD on the machine reads the same pages.
+ *
+ * The file starts with a "HWKCACHE 1" line, followed by one
+ * "<module> <offset> <length> <hash> <source>" line per chunk and an
+ * empty line, the same layout as the keymap alias index. Offsets are
+ * relative to the end of the empty line. Chunks whose source file has
+ * changed since the cache was written, going by a 32-bit FNV-1a hash of
+ * its contents, are left out, so that edits to LLib take effect without
+ * rebuilding the cache.
+ */
+class ModuleCache {
+private:
+    const char *map = nullptr;
+    size_t map_len = 0;
+    std::unordered_map<std::string, std::string_view> chunks;
+
+public:
+    ModuleCache() = default;
+
+    ~ModuleCache();
+
+    ModuleCache(const ModuleCache&) = delete;
+    ModuleCache& operator=(const ModuleCache&) = delete;
+
+    /** Map a cache file.
+     *
+     * @throws SystemError if the file cannot be mapped or is not a
+     *         module cache.
+     */
+    void open(const std::string &path);
+
+    /** Get the bytecode of a module.
+     *
+     * @return The chunk, or an empty view if the module is not cached.
+     */
+    std::string_view find(const std::string &name) const noexcept {
+        auto it = chunks.find(name);
+        return (it == chunks.end()) ? std::string_view() : it->second;
+    }
+
+    inline size_t size() const noexcept {
+        return chunks.size();
+    }
+};
@@ -0,0 +1,111 @@
+/* =====================================================================================
+ * Desktop notifications.
+ *
+ * Copyright (C) 2018 Jonas Møller (no) <jonasmo441@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * =====================================================================================
+ */
+
+extern "C" {
+    #include <dlfcn.h>
+    #include <syslog.h>
+}
+
+#include "Notifier.hpp"
+
+using namespace std;
+
+/** Sonames to try, in order. */
+static const char *libnotify_names[] = {
+    "libnotify.so.4",
+    "libnotify.so",
+};
+
+template <class T>
+static inline bool resolve(void *lib, const char *name, T *fn) {
+    *fn = (T) dlsym(lib, name);
+    if (*fn == nullptr) {
+        syslog(LOG_ERR, "Unable to resolve %s: %s", name, dlerror());
+        return false;
+    }
+    return true;
+}
+
+Notifier::Notifier(const string &app_name) : app_name(app_name) {}
+
+Notifier::~Notifier() {
+    if (lib) {
+        notify_uninit();
+        dlclose(lib);
+    }
+}
+
+void Notifier::load() {
+    void *handle = nullptr;
+    for (const char *name : libnotify_names)
+        if ((handle = dlopen(name, RTLD_NOW | RTLD_LOCAL)))
+            break;
+    if (handle == nullptr) {
+        syslog(LOG_WARNING, "Unable to load libnotify, notifications disabled: %s",
+               dlerror());
+        return;
+    }
+
+    // g_object_unref is found through the dependencies of libnotify.
+    bool ok = resolve(handle, "notify_init", &notify_init)
+        && resolve(handle, "notify_uninit", &notify_uninit)
+        && resolve(handle, "notify_notification_new", &notification_new)
+        && resolve(handle, "notify_notification_set_timeout", &notification_set_timeout)
+        && resolve(handle, "notify_notification_set_urgency", &notification_set_urgency)
+        && resolve(handle, "notify_notification_set_app_name", &notification_set_app_name)
+        && resolve(handle, "notify_notification_show", &notification_show)
+        && resolve(handle, "g_object_unref", &object_unref);
+
+    if (!ok || !notify_init(app_name.c_str())) {
+        syslog(LOG_ERR, "Unable to initialize libnotify");
+        dlclose(handle);
+        return;
+    }
+
+    lib = handle;
+}
+
+bool Notifier::show(const string &title, const string &msg, const string &icon,
+                    Urgency urgency, int timeout_ms)
+{
+    call_once(load_flag, [this]() { load(); });
+    if (!lib) {
+        syslog(LOG_NOTICE, "%s: %s", title.c_str(), msg.c_str());
+        return false;
+    }
+
+    lock_guard<mutex> lock(show_mtx);
+    void *n = notification_new(title.c_str(), msg.c_str(),
+                               icon.empty() ? nullptr : icon.c_str());
+    notification_set_timeout(n, timeout_ms);
+    notification_set_urgency(n, (int) urgency);
+    notification_set_app_name(n, app_name.c_str());
+    bool shown = notification_show(n, nullptr);
+    object_unref(n);
+    return shown;
+}
@@ -0,0 +1,106 @@
+/* =====================================================================================
+ * Desktop notifications.
+ *
+ * Copyright (C) 2018 Jonas Møller (no) <jonasmo441@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * =====================================================================================
+ */
+
+/** @file Notifier.hpp
+ *
+ * @brief Desktop notifications through libnotify.
+ */
+
+#pragma once
+
+#include <string>
+#include <mutex>
+
+/** Notification urgency, same values as NotifyUrgency in libnotify. */
+enum class Urgency {
+    LOW = 0,
+    NORMAL = 1,
+    CRITICAL = 2,
+};
+
+/** Desktop notifier.
+ *
+ * libnotify pulls in GLib, GObject and DBus, which is a lot of mapped
+ * memory and startup time for a daemon that rarely shows anything.
+ * The library is therefore loaded with dlopen() the first time a
+ * notification is shown. If it cannot be loaded, notifications are
+ * written to syslog instead.
+ *
+ * Example:
+ *
+ *   Notifier notifier("Hawck");
+ *   notifier.show("Lua error", report, icon_path, Urgency::CRITICAL);
+ */
+class Notifier {
+private:
+    std::string app_name;
+    /** Handle returned by dlopen(), nullptr if not loaded. */
+    void *lib = nullptr;
+    /** Ensures that loading is only attempted once. */
+    std::once_flag load_flag;
+    /** Protects notifications from being shown concurrently. */
+    std::mutex show_mtx;
+
+    int (*notify_init)(const char *) = nullptr;
+    void (*notify_uninit)() = nullptr;
+    void *(*notification_new)(const char *, const char *, const char *) = nullptr;
+    void (*notification_set_timeout)(void *, int) = nullptr;
+    void (*notification_set_urgency)(void *, int) = nullptr;
+    void (*notification_set_app_name)(void *, const char *) = nullptr;
+    int (*notification_show)(void *, void **) = nullptr;
+    void (*object_unref)(void *) = nullptr;
+
+    /** Load libnotify and resolve the functions used. */
+    void load();
+
+public:
+    explicit Notifier(const std::string &app_name);
+
+    ~Notifier();
+
+    /** Show a notification.
+     *
+     * @param title Summary of the notification.
+     * @param msg Body of the notification.
+     * @param icon Path to an icon, may be empty.
+     * @param urgency Urgency of the notification.
+     * @param timeout_ms Time before the notification expires, -1 lets
+     *                   the notification server decide.
+     * @return False if the notification could not be shown.
+     */
+    bool show(const std::string &title,
+              const std::string &msg,
+              const std::string &icon = "",
+              Urgency urgency = Urgency::NORMAL,
+              int timeout_ms = -1);
+
+    /** Check if libnotify has been loaded. */
+    inline bool isLoaded() const {
+        return lib != nullptr;
+    }
+};
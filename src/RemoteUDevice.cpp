@@ -26,7 +26,12 @@
  * =====================================================================================
  */
 
+extern "C" {
+    #include <syslog.h>
+}
+
 #include "RemoteUDevice.hpp"
+#include "MacroRecorder.hpp"
 
 RemoteUDevice::RemoteUDevice(UNIXSocket<KBDAction> *conn)
     : LuaIface(this, RemoteUDevice_lua_methods) {
@@ -39,39 +44,91 @@ RemoteUDevice::RemoteUDevice()
 RemoteUDevice::~RemoteUDevice() {}
 
 void RemoteUDevice::emit(int type, int code, int val) {
+    if (recorder)
+        recorder->capture(type, code, val);
     KBDAction ac;
+    memset(&ac, 0, sizeof(ac));
     ac.ev.type = type;
     ac.ev.code = code;
     ac.ev.value = val;
     ac.done = 0;
+    if (backend) {
+        backend->emit(type, code, val);
+        unflushed.push_back(ac);
+        return;
+    }
     evbuf.push_back(ac);
 }
 
 void RemoteUDevice::emit(const input_event *send_event) {
+    if (recorder)
+        recorder->capture(send_event->type, send_event->code, send_event->value);
     KBDAction ac;
     memset(&ac, 0, sizeof(ac));
     memcpy(&ac.ev, send_event, sizeof(*send_event));
     ac.done = 0;
+    if (backend) {
+        backend->emit(send_event);
+        unflushed.push_back(ac);
+        return;
+    }
     evbuf.push_back(ac);
 }
 
 void RemoteUDevice::flush() {
-    if (!conn)
+    if (backend) {
+        try {
+            backend->flush();
+        } catch (const std::exception &e) {
+            syslog(LOG_ERR, "Output backend failed, sending events to InputD: %s",
+                   e.what());
+            backend = nullptr;
+            // The backend may not have applied any of them, InputD gets
+            // them with the next done() marker.
+            evbuf.insert(evbuf.end(), unflushed.begin(), unflushed.end());
+        }
+        unflushed.clear();
+    }
+}
+
+void RemoteUDevice::send() {
+    // Events are thrown away when there is no InputD to send them to.
+    if (!conn) {
+        evbuf.clear();
         return;
+    }
     if (evbuf.size()) {
         conn->send(evbuf);
         evbuf.clear();
     }
 }
 
-void RemoteUDevice::done() {
-    if (!conn)
+void RemoteUDevice::pause(uint32_t us) {
+    if (backend || !conn)
         return;
-    flush();
     KBDAction ac;
     memset(&ac, 0, sizeof(ac));
-    ac.done = 1;
-    conn->send(&ac);
+    ac.pause = 1;
+    ac.ev.value = us;
+    evbuf.push_back(ac);
+}
+
+void RemoteUDevice::done() {
+    flush();
+    // The marker goes in the same write as the events before it.
+    if (conn) {
+        KBDAction ac;
+        memset(&ac, 0, sizeof(ac));
+        ac.done = 1;
+        evbuf.push_back(ac);
+    }
+    if (!batching)
+        send();
+}
+
+void RemoteUDevice::endBatch() {
+    batching = false;
+    send();
 }
 
 LUA_CREATE_BINDINGS(RemoteUDevice_lua_methods)
@@ -61,6 +61,8 @@ extern "C" {
 // Declare extern "C" Lua bindings
 LUA_DECLARE(RemoteUDevice_lua_methods)
 
+class MacroRecorder;
+
 /** Remote UDevice
  *
  * See UDevice
@@ -70,6 +72,22 @@ class RemoteUDevice : public IUDevice,
 private:
     UNIXSocket<KBDAction> *conn = nullptr;
     std::vector<KBDAction> evbuf;
+    /** Receives a copy of every emitted event, may be null. */
+    MacroRecorder *recorder = nullptr;
+    /** Applies events locally instead of sending them to InputD, may
+     *  be null. */
+    IUDevice *backend = nullptr;
+    /** Events given to the backend since it was last flushed, sent to
+     *  InputD instead if the flush fails. */
+    std::vector<KBDAction> unflushed;
+    /** Set between beginBatch() and endBatch(). */
+    bool batching = false;
+
+    /** Send evbuf to InputD.
+     *
+     * @throws SocketError If the events could not be sent.
+     */
+    void send();
 
     // Collect methods into an array
     LUA_METHOD_COLLECT(RemoteUDevice_lua_methods);
@@ -87,10 +105,51 @@ public:
 
     virtual void done() override;
 
+    /** Flush the backend, events for InputD are kept until done(), as
+     *  InputD emits the reply to a key all at once anyway. */
     virtual void flush() override;
 
+    /** Have InputD wait before emitting the following events, used
+     *  when the time between events matters.
+     *
+     * InputD does the waiting, so this returns right away. Pauses are
+     * ignored when events go to a backend.
+     */
+    void pause(uint32_t us);
+
+    /** Hold back the done() markers of the following events, so that
+     *  the replies to a batch from InputD are sent together. */
+    inline void beginBatch() {
+        batching = true;
+    }
+
+    /** Send the replies held back since beginBatch().
+     *
+     * @throws SocketError If the replies could not be sent.
+     */
+    void endBatch();
+
+    /** Set the connection to InputD, replies that were meant for the
+     *  previous connection are thrown away. */
     inline void setConnection(UNIXSocket<KBDAction> *conn) {
         this->conn = conn;
+        evbuf.clear();
+        batching = false;
+    }
+
+    inline void setRecorder(MacroRecorder *recorder) {
+        this->recorder = recorder;
+    }
+
+    /** Emit events on another device, e.g XTestUDevice, InputD is only
+     *  told when the events have been applied. If the backend fails,
+     *  events are sent to InputD again.
+     *
+     * @param backend The device, or nullptr to send events to InputD.
+     */
+    inline void setBackend(IUDevice *backend) {
+        this->backend = backend;
+        unflushed.clear();
     }
 
     // Extract methods as static members taking `this` as
@@ -0,0 +1,170 @@
+/* =====================================================================================
+ * Shared state between scripts.
+ *
+ * Copyright (C) 2018 Jonas Møller (no) <jonasmo441@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * =====================================================================================
+ */
+
+#include "SharedState.hpp"
+#include "SystemError.hpp"
+
+extern "C" {
+    #include <string.h>
+}
+
+using namespace std;
+
+static uint32_t hashKey(string_view key) noexcept {
+    uint32_t h = 2166136261u;
+    for (char c : key) {
+        h ^= (uint8_t) c;
+        h *= 16777619u;
+    }
+    return h;
+}
+
+SharedState::Value SharedState::Value::boolean(bool b) noexcept {
+    Value v;
+    v.type = Type::BOOL;
+    v.i = b;
+    return v;
+}
+
+SharedState::Value SharedState::Value::integer(int64_t i) noexcept {
+    Value v;
+    v.type = Type::INT;
+    v.i = i;
+    return v;
+}
+
+SharedState::Value SharedState::Value::string(string_view s) {
+    if (s.size() > max_str_len)
+        throw SystemError("Shared state strings can be at most " +
+                          to_string(max_str_len) + " bytes long");
+    Value v;
+    v.type = Type::STRING;
+    v.len = s.size();
+    memcpy(v.s, s.data(), s.size());
+    return v;
+}
+
+bool SharedState::Value::operator==(const Value &other) const noexcept {
+    if (type != other.type)
+        return false;
+    switch (type) {
+        case Type::NIL:
+            return true;
+        case Type::STRING:
+            return str() == other.str();
+        default:
+            return i == other.i;
+    }
+}
+
+const SharedState::Slot *SharedState::find(string_view key) const noexcept {
+    size_t idx = hashKey(key) % capacity;
+    for (size_t n = 0; n < capacity; n++, idx = (idx + 1) % capacity) {
+        const Slot &slot = slots[idx];
+        if (!slot.ready.load(memory_order_acquire))
+            return nullptr;
+        if (key == slot.key)
+            return &slot;
+    }
+    return nullptr;
+}
+
+SharedState::Value SharedState::load(const Slot &slot) noexcept {
+    uint64_t w[4];
+    uint32_t seq;
+    do {
+        while ((seq = slot.seq.load(memory_order_acquire)) & 1)
+            ;
+        for (int i = 0; i < 4; i++)
+            w[i] = slot.words[i].load(memory_order_relaxed);
+        atomic_thread_fence(memory_order_acquire);
+    } while (slot.seq.load(memory_order_relaxed) != seq);
+
+    Value v;
+    v.type = (Type) (w[0] & 0xff);
+    v.len = (w[0] >> 8) & 0xff;
+    if (v.type == Type::STRING)
+        memcpy(v.s, &w[1], max_str_len);
+    else
+        v.i = (int64_t) w[1];
+    return v;
+}
+
+SharedState::Value SharedState::get(string_view key) const noexcept {
+    const Slot *slot = find(key);
+    return slot ? load(*slot) : Value();
+}
+
+uint32_t SharedState::version(string_view key) const noexcept {
+    const Slot *slot = find(key);
+    return slot ? slot->seq.load(memory_order_acquire) / 2 : 0;
+}
+
+void SharedState::set(string_view key, const Value &value) {
+    if (key.empty() || key.size() > max_key_len)
+        throw SystemError("Shared state keys must be 1 to " +
+                          to_string(max_key_len) + " bytes long");
+
+    lock_guard<mutex> lock(write_mtx);
+
+    Slot *slot = const_cast<Slot *>(find(key));
+    if (!slot) {
+        if (value.type == Type::NIL)
+            return;
+        // Claim the first free slot in the probe sequence, readers
+        // only see the key once it is marked as ready.
+        size_t idx = hashKey(key) % capacity;
+        for (size_t n = 0; n < capacity; n++, idx = (idx + 1) % capacity) {
+            if (!slots[idx].ready.load(memory_order_relaxed)) {
+                slot = &slots[idx];
+                break;
+            }
+        }
+        if (!slot)
+            throw SystemError("Shared state is full");
+        memcpy(slot->key, key.data(), key.size());
+        slot->key[key.size()] = '\0';
+        slot->ready.store(true, memory_order_release);
+    } else if (load(*slot) == value) {
+        return;
+    }
+
+    uint64_t w[4] = {(uint64_t) value.type | ((uint64_t) value.len << 8)};
+    if (value.type == Type::STRING)
+        memcpy(&w[1], value.s, max_str_len);
+    else
+        w[1] = (uint64_t) value.i;
+
+    uint32_t seq = slot->seq.load(memory_order_relaxed);
+    slot->seq.store(seq + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    for (int i = 0; i < 4; i++)
+        slot->words[i].store(w[i], memory_order_relaxed);
+    slot->seq.store(seq + 2, memory_order_release);
+    gen.fetch_add(1, memory_order_release);
+}
@@ -0,0 +1,131 @@
+/* =====================================================================================
+ * Shared state between scripts.
+ *
+ * Copyright (C) 2018 Jonas Møller (no) <jonasmo441@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * =====================================================================================
+ */
+
+/** @file SharedState.hpp
+ *
+ * @brief Key/value store shared by all scripts in MacroD.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <string_view>
+
+extern "C" {
+    #include <stdint.h>
+}
+
+/** Store of small typed values, shared by every Lua state in MacroD.
+ *
+ * Keys are kept in a fixed open-addressing table and are never removed,
+ * setting a key to nil only clears its value. Values are protected by a
+ * sequence lock per key, so readers never take a lock and never block
+ * a writer. Writers are serialized by a mutex.
+ */
+class SharedState {
+public:
+    enum class Type : uint8_t {
+        NIL = 0,
+        BOOL,
+        INT,
+        STRING
+    };
+
+    static constexpr size_t capacity = 256;
+    static constexpr size_t max_key_len = 31;
+    static constexpr size_t max_str_len = 24;
+
+    struct Value {
+        Type type = Type::NIL;
+        uint8_t len = 0;
+        /** Value of BOOL and INT. */
+        int64_t i = 0;
+        /** Value of STRING, not null-terminated. */
+        char s[max_str_len] = {};
+
+        static Value boolean(bool b) noexcept;
+        static Value integer(int64_t i) noexcept;
+        /** @throws SystemError if `s` is longer than max_str_len. */
+        static Value string(std::string_view s);
+
+        inline std::string_view str() const noexcept {
+            return std::string_view(s, len);
+        }
+
+        bool operator==(const Value &other) const noexcept;
+    };
+
+private:
+    struct Slot {
+        /** Set once the key has been written. */
+        std::atomic<bool> ready = false;
+        char key[max_key_len + 1] = {};
+        /** Odd while the value is being written. */
+        std::atomic<uint32_t> seq = 0;
+        /** Type and length, followed by the value. */
+        std::atomic<uint64_t> words[4] = {};
+    };
+
+    Slot slots[capacity];
+    std::mutex write_mtx;
+    std::atomic<uint64_t> gen = 0;
+
+    const Slot *find(std::string_view key) const noexcept;
+
+    static Value load(const Slot &slot) noexcept;
+
+public:
+    SharedState() = default;
+
+    SharedState(const SharedState&) = delete;
+    SharedState& operator=(const SharedState&) = delete;
+
+    /** Get the value of `key`, never blocks.
+     *
+     * @return The value, with type NIL if the key has not been set.
+     */
+    Value get(std::string_view key) const noexcept;
+
+    /** Set the value of `key`, setting it to the value it already has
+     *  is not a change.
+     *
+     * @throws SystemError if the key is too long or the store is full.
+     */
+    void set(std::string_view key, const Value &value);
+
+    /** Get the number of times `key` has changed. */
+    uint32_t version(std::string_view key) const noexcept;
+
+    /** Get the total number of changes to the store, used to find out
+     *  whether scripts need to be notified. */
+    inline uint64_t generation() const noexcept {
+        return gen.load(std::memory_order_acquire);
+    }
+};
@@ -0,0 +1,108 @@
+/* =====================================================================================
+ * Token bucket rate limiter.
+ *
+ * Copyright (C) 2018 Jonas Møller (no) <jonasmo441@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * =====================================================================================
+ */
+
+/** @file TokenBucket.hpp
+ *
+ * @brief Token bucket rate limiter.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <algorithm>
+
+/** Allows bursts of up to `burst` events, and `rate` events per second
+ *  after that.
+ *
+ * A rate of zero or less means that the bucket never runs out.
+ */
+class TokenBucket {
+public:
+    using SteadyClock = std::chrono::steady_clock;
+
+private:
+    double rate;
+    double burst;
+    double tokens;
+    SteadyClock::time_point last;
+
+    void refill(SteadyClock::time_point now) {
+        double dt = std::chrono::duration<double>(now - last).count();
+        if (dt > 0) {
+            tokens = std::min(burst, tokens + dt * rate);
+            last = now;
+        }
+    }
+
+public:
+    TokenBucket(double rate, double burst, SteadyClock::time_point now)
+        : rate(rate), burst(burst), tokens(burst), last(now) {}
+
+    /** Take n tokens if they are available.
+     *
+     * @return True if the tokens were taken.
+     */
+    bool take(double n, SteadyClock::time_point now) {
+        if (unlimited())
+            return true;
+        refill(now);
+        if (tokens < n)
+            return false;
+        tokens -= n;
+        return true;
+    }
+
+    /** Time until n tokens are available. */
+    SteadyClock::duration wait(double n, SteadyClock::time_point now) {
+        if (unlimited())
+            return SteadyClock::duration::zero();
+        refill(now);
+        if (tokens >= n)
+            return SteadyClock::duration::zero();
+        return std::chrono::duration_cast<SteadyClock::duration>(
+            std::chrono::duration<double>((n - tokens) / rate));
+    }
+
+    /** Change the rate and burst size, the bucket is refilled. */
+    void configure(double rate, double burst, SteadyClock::time_point now) {
+        this->rate = rate;
+        this->burst = burst;
+        tokens = burst;
+        last = now;
+    }
+
+    /** Refill the bucket, counting time from `now`. */
+    void reset(SteadyClock::time_point now) {
+        tokens = burst;
+        last = now;
+    }
+
+    inline bool unlimited() const noexcept {
+        return rate <= 0;
+    }
+};
@@ -23,6 +23,12 @@ const char hawck_udev_name[] = "Hawck virtual keyboard device";
 
 using namespace std;
 
+static uint64_t monotonicNs() noexcept {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
 static int getDevice(const string &by_name) {
     char buf[256];
     string devdir = "/dev/input";
@@ -86,6 +92,7 @@ UDevice::UDevice() {
 }    
 
 UDevice::~UDevice() {
+    stopProbe();
     ioctl(fd, UI_DEV_DESTROY);
     close(fd);
     free(evbuf);
@@ -123,6 +130,19 @@ void UDevice::flush() {
 
     input_event *bufp = evbuf;
     for (size_t i = 0; i < evbuf_top; i++) {
+        if (probing && !frame_open) {
+            size_t head = probe_head.load(memory_order_relaxed);
+            if (head - probe_tail.load(memory_order_acquire) < probe_ring_len) {
+                probe_ring[head % probe_ring_len] = monotonicNs();
+                probe_head.store(head + 1, memory_order_release);
+            } else {
+                num_undelivered++;
+            }
+            frame_open = true;
+        }
+        if (bufp->type == EV_SYN && bufp->code == SYN_REPORT)
+            frame_open = false;
+
         if (write(fd, bufp++, sizeof(*bufp)) != sizeof(*bufp))
             throw SystemError("Error in write(): ", errno);
 
@@ -147,7 +167,7 @@ void UDevice::flush() {
         //         the clients need to handle SYN_DROPPED events and
         //         they don't seem to be doing that properly.
 
-        usleep(ev_delay);
+        clock->sleepFor(std::chrono::microseconds(ev_delay));
     }
 
 
@@ -196,6 +216,89 @@ void UDevice::setEventDelay(int delay) {
     ev_delay = delay;
 }
 
+void UDevice::startProbe() {
+    if (probing)
+        return;
+    // Event times are compared with the write times.
+    int clk = CLOCK_MONOTONIC;
+    if (ioctl(dfd, EVIOCSCLOCKID, &clk) == -1)
+        throw SystemError("Unable to set the clock of the udevice: ", errno);
+    input_event evs[64];
+    while (read(dfd, evs, sizeof(evs)) > 0)
+        ;
+    probe_tail = probe_head.load();
+    frame_open = false;
+    probing = true;
+    probe_thread = thread([this]() { probe(); });
+}
+
+void UDevice::stopProbe() {
+    probing = false;
+    if (probe_thread.joinable())
+        probe_thread.join();
+}
+
+void UDevice::probe() {
+    input_event evs[64];
+    // Set after SYN_DROPPED until the next SYN_REPORT, the events in
+    // between are incomplete.
+    bool resync = false;
+    while (probing) {
+        struct pollfd pfd = {dfd, POLLIN, 0};
+        if (poll(&pfd, 1, 100) <= 0)
+            continue;
+        ssize_t n = read(dfd, evs, sizeof(evs));
+        if (n <= 0)
+            continue;
+        uint64_t now = monotonicNs();
+        for (size_t i = 0; i < n / sizeof(evs[0]); i++) {
+            const input_event &ev = evs[i];
+            if (ev.type != EV_SYN)
+                continue;
+            if (ev.code == SYN_DROPPED) {
+                num_syn_dropped++;
+                resync = true;
+                continue;
+            }
+            if (ev.code != SYN_REPORT)
+                continue;
+
+            // The kernel stamps a frame while it is being written, so
+            // it belongs to the last frame that was started before the
+            // stamp. Earlier frames did not come back. The stamp only
+            // has µs resolution, so it is rounded up.
+            uint64_t t = (uint64_t) ev.time.tv_sec * 1000000000 +
+                         (uint64_t) ev.time.tv_usec * 1000 + 999;
+            size_t tail = probe_tail.load(memory_order_relaxed);
+            size_t head = probe_head.load(memory_order_acquire);
+            uint64_t start = 0;
+            bool found = false;
+            while (tail != head && probe_ring[tail % probe_ring_len] <= t) {
+                if (found)
+                    num_undelivered++;
+                start = probe_ring[tail % probe_ring_len];
+                found = true;
+                tail++;
+            }
+            probe_tail.store(tail, memory_order_release);
+
+            if (resync) {
+                resync = false;
+                continue;
+            }
+            if (found)
+                delivery.add((now - start) / 1000);
+        }
+    }
+}
+
+void UDevice::forward(const input_event *evs, size_t n) {
+    flush();
+    ssize_t len = n * sizeof(*evs);
+    if (write(fd, evs, len) != len)
+        throw SystemError("Error in write(): ", errno);
+}
+
 void UDevice::upAll() {
     unsigned char key_states[KEY_MAX/8 + 1];
     memset(key_states, 0, sizeof(key_states));
@@ -19,7 +19,11 @@ extern "C" {
 #include <string.h>
 #include <stdio.h>
 #include <stdexcept>
+#include <atomic>
+#include <thread>
 #include "IUDevice.hpp"
+#include "Clock.hpp"
+#include "LatencyHistogram.hpp"
 
 class UDevice : public IUDevice {
 private:
@@ -27,11 +31,31 @@ private:
     int fd;
     int dfd;
     int ev_delay = 3800;
+    Clock *clock = &Clock::system();
     uinput_setup usetup;
     size_t evbuf_len;
     size_t evbuf_top;
     input_event *evbuf;
 
+    /** Number of frames that the delivery probe can wait for. */
+    static constexpr size_t probe_ring_len = 1024;
+    /** Monotonic times in ns at which frames were written, pushed by
+     *  flush() and popped by the probe thread when the frames are read
+     *  back from dfd. */
+    uint64_t probe_ring[probe_ring_len];
+    std::atomic<size_t> probe_head = 0;
+    std::atomic<size_t> probe_tail = 0;
+    /** Set by flush() when the start of the current frame is recorded. */
+    bool frame_open = false;
+    std::atomic<bool> probing = false;
+    std::thread probe_thread;
+    LatencyHistogram delivery;
+    std::atomic<uint64_t> num_syn_dropped = 0;
+    std::atomic<uint64_t> num_undelivered = 0;
+
+    /** Read frames back from dfd and time their delivery. */
+    void probe();
+
 public:
     UDevice();
 
@@ -43,6 +67,13 @@ public:
 
     virtual void flush() override;
 
+    /** Write events read from a keyboard in a single write(), without
+     *  the event delay, they already arrive at the pace they were typed.
+     *
+     * @throws SystemError If the events could not be written.
+     */
+    void forward(const input_event *evs, size_t n);
+
     virtual void done() override;
 
     /** Set delay between outputted events in µs
@@ -54,7 +85,45 @@ public:
      */
     void setEventDelay(int delay);
 
+    /** Set the clock used to pace events. */
+    inline void setClock(Clock &c) noexcept {
+        clock = &c;
+    }
+
     /** Generate key up events for all held keys.
      */
     void upAll();
+
+    /** Start timing the delivery of written frames, by reading them
+     *  back from the virtual device node in a separate thread.
+     *
+     * The latency is measured from the write() of the first event in a
+     * frame until the probe reads the SYN_REPORT, which is the delay
+     * that any other evdev reader, e.g the compositor, sees on top of
+     * Hawck's own processing.
+     */
+    void startProbe();
+
+    void stopProbe();
+
+    inline bool isProbing() const noexcept {
+        return probing;
+    }
+
+    /** Delivery latencies measured by the probe. */
+    inline const LatencyHistogram &deliveryLatency() const noexcept {
+        return delivery;
+    }
+
+    /** Number of times the probe saw SYN_DROPPED, i.e the evdev buffer
+     *  of a reader overflowed. */
+    inline uint64_t numSynDropped() const noexcept {
+        return num_syn_dropped;
+    }
+
+    /** Number of frames that never came back from the device, the
+     *  input core drops frames that do not change any state. */
+    inline uint64_t numUndelivered() const noexcept {
+        return num_undelivered;
+    }
 };
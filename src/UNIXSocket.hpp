@@ -51,6 +51,7 @@ extern "C" {
 #include <chrono>
 
 #include "SystemError.hpp"
+#include "Clock.hpp"
 
 class SocketError : public std::exception {
 private:
@@ -158,8 +159,10 @@ class UNIXSocket {
 private:
     int fd;
     std::string addr = "";
+    /** Used for the delay between connection attempts. */
+    Clock *clock = &Clock::system();
 
-    int connectTo(const std::string& addr) {
+    int connectTo(const std::string& addr, bool retry = true) {
         int fd;
         struct sockaddr_un saun;
         if ((fd = socket(AF_UNIX, SOCK_STREAM, 0)) < 0) {
@@ -173,12 +176,16 @@ private:
         int last_errno = 0;
         while (::connect(fd, (sockaddr*)&saun, len) != 0) {
             auto exc = SystemError("", errno);
+            if (!retry) {
+                ::close(fd);
+                throw SocketError("Could not connect to '" + addr + "': " + exc.what());
+            }
             // Only print the error if it changed.
             if (errno != last_errno) {
                 fprintf(stderr, "Could not connect to '%s': %s\n", addr.c_str(), exc.what());
                 last_errno = errno;
             }
-            usleep(250000);
+            clock->sleepFor(std::chrono::milliseconds(250));
             errno = 0;
         }
         fprintf(stderr, "Connection established!\n");
@@ -199,12 +206,31 @@ public:
      * Will attempt a connection ad infinitum until it succeeds.
      *
      * @param addr The address to connect to.
+     * @param clock Clock used for the delay between attempts.
      */
-    explicit UNIXSocket(const std::string& addr) {
+    explicit UNIXSocket(const std::string& addr, Clock &clock = Clock::system())
+        : clock(&clock)
+    {
         fd = connectTo(addr);
         this->addr = addr;
     }
 
+    /**
+     * Establish a socket connection.
+     *
+     * @param addr The address to connect to.
+     * @param retry Whether to keep trying until the connection
+     *              succeeds, a SocketError is thrown on failure if
+     *              this is false.
+     * @param clock Clock used for the delay between attempts.
+     */
+    UNIXSocket(const std::string& addr, bool retry, Clock &clock = Clock::system())
+        : clock(&clock)
+    {
+        fd = connectTo(addr, retry);
+        this->addr = addr;
+    }
+
     /** Reconnect to the server, this only works for UNIXSockets
      *  that have addr set. */
     void recon() {
@@ -226,6 +252,25 @@ public:
         ::close(fd);
     }
 
+    /**
+     * Get the credentials of the process on the other end, for
+     * a client these are the credentials of the server at the time
+     * it called listen().
+     */
+    struct ucred getPeerCredentials() const {
+        struct ucred cred;
+        socklen_t len = sizeof(cred);
+        if (getsockopt(fd, SOL_SOCKET, SO_PEERCRED, &cred, &len) == -1)
+            throw SocketError("Unable to get peer credentials: " +
+                              std::string(SystemError("", errno).what()));
+        return cred;
+    }
+
+    /** Get the underlying file descriptor, for use with poll() */
+    inline int getFd() const noexcept {
+        return fd;
+    }
+
     /**
      * Receive a packet.
      *
@@ -250,6 +295,36 @@ public:
         recvAll(fd, p, timeout);
     }
 
+    /**
+     * Receive all packets that are available, up to `max`, blocks
+     * until there is at least one.
+     *
+     * @param buf The buffer to insert packets into.
+     * @param max Size of `buf` in packets.
+     * @param timeout Timeout for the rest of a packet that was cut off,
+     *                negative to wait for as long as it takes.
+     * @return Number of packets received.
+     */
+    size_t recvMany(Packet *buf, size_t max, std::chrono::milliseconds timeout) {
+        ssize_t n = ::read(fd, buf, sizeof(*buf) * max);
+        if (n <= 0)
+            throw SocketError("Unable to receive packet: " + std::string(strerror(errno)));
+        // Complete a packet that was cut off.
+        if (size_t rem = n % sizeof(*buf)) {
+            char *dst = (char *) buf + n;
+            if (timeout.count() < 0)
+                recvAll(fd, dst, sizeof(*buf) - rem);
+            else
+                recvAll(fd, dst, sizeof(*buf) - rem, timeout);
+        }
+        return (n + sizeof(*buf) - 1) / sizeof(*buf);
+    }
+
+    /** @see recvMany(Packet *buf, size_t max, std::chrono::milliseconds timeout) */
+    size_t recvMany(Packet *buf, size_t max) {
+        return recvMany(buf, max, std::chrono::milliseconds(-1));
+    }
+
     /**
      * Send a packet.
      *
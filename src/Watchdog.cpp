@@ -0,0 +1,74 @@
+/* =====================================================================================
+ * Event loop watchdog.
+ *
+ * Copyright (C) 2018 Jonas Møller (no) <jonasmo441@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * =====================================================================================
+ */
+
+#include "Watchdog.hpp"
+
+using namespace std;
+
+Watchdog::Watchdog(Clock::duration deadline, StallFn on_stall, Clock &clock)
+    : clock(&clock),
+      deadline(deadline),
+      on_stall(on_stall),
+      last_beat(clock.now().time_since_epoch().count())
+{}
+
+Watchdog::~Watchdog() {
+    stop();
+}
+
+void Watchdog::start() {
+    if (thread.joinable())
+        return;
+    stopping = false;
+    last_beat = clock->now().time_since_epoch().count();
+    thread = std::thread([this]() { watch(); });
+}
+
+void Watchdog::stop() {
+    stopping = true;
+    if (thread.joinable())
+        thread.join();
+}
+
+void Watchdog::watch() {
+    // Check often enough that a stall is acted upon within a fifth of
+    // the deadline.
+    auto interval = max(Clock::duration(chrono::milliseconds(1)), deadline / 5);
+    Clock::duration::rep stalled_beat = 0;
+    while (!stopping) {
+        clock->sleepFor(interval);
+        Clock::duration::rep beat = last_beat.load(memory_order_acquire);
+        if (beat == stalled_beat)
+            continue;
+        if (clock->now() - Clock::time_point(Clock::duration(beat)) > deadline) {
+            stalled_beat = beat;
+            on_stall(cur_stage.load(memory_order_relaxed));
+            tripped.store(true, memory_order_release);
+        }
+    }
+}
@@ -0,0 +1,118 @@
+/* =====================================================================================
+ * Event loop watchdog.
+ *
+ * Copyright (C) 2018 Jonas Møller (no) <jonasmo441@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * =====================================================================================
+ */
+
+/** @file Watchdog.hpp
+ *
+ * @brief Detect stalls in an event loop.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <thread>
+
+#include "Clock.hpp"
+
+/** Watches the heartbeat of an event loop from a separate thread.
+ *
+ * The loop calls beat() every time around, and stage() before anything
+ * that might block. When no beat has arrived for longer than the
+ * deadline, the stall callback is called from the watchdog thread with
+ * the name of the stage that the loop got stuck in. It is called once
+ * per stall, the next beat() reports that the loop has recovered.
+ */
+class Watchdog {
+public:
+    using StallFn = std::function<void(const char *stage)>;
+
+private:
+    Clock *clock;
+    Clock::duration deadline;
+    StallFn on_stall;
+    std::atomic<Clock::duration::rep> last_beat;
+    std::atomic<const char *> cur_stage = "start";
+    /** Set once on_stall has returned, cleared by beat(). */
+    std::atomic<bool> tripped = false;
+    std::atomic<bool> stopping = false;
+    std::thread thread;
+
+    void watch();
+
+public:
+    /**
+     * @param deadline Longest time allowed between two beats.
+     * @param on_stall Called from the watchdog thread on a stall.
+     * @param clock Clock used for beats and for sleeping.
+     */
+    Watchdog(Clock::duration deadline, StallFn on_stall,
+             Clock &clock = Clock::system());
+
+    ~Watchdog();
+
+    Watchdog(const Watchdog&) = delete;
+    Watchdog& operator=(const Watchdog&) = delete;
+
+    /** Start the watchdog thread, the deadline counts from now. */
+    void start();
+
+    /** Stop the watchdog thread. */
+    void stop();
+
+    /** Signal that the loop is alive and is now in `name`.
+     *
+     * @return True if the stall callback was called since the last
+     *         beat, i.e the loop has just recovered from a stall.
+     */
+    inline bool beat(const char *name) noexcept {
+        cur_stage.store(name, std::memory_order_relaxed);
+        last_beat.store(clock->now().time_since_epoch().count(),
+                        std::memory_order_release);
+        return tripped.load(std::memory_order_acquire) &&
+               tripped.exchange(false, std::memory_order_acq_rel);
+    }
+
+    /** Mark the stage that the loop is in, without a beat.
+     *
+     * @param name Name of the stage, must be a string literal.
+     */
+    inline void stage(const char *name) noexcept {
+        cur_stage.store(name, std::memory_order_relaxed);
+    }
+
+    /** Must not be called while the watchdog is running. */
+    inline void setDeadline(Clock::duration d) noexcept {
+        deadline = d;
+    }
+
+    /** Must not be called while the watchdog is running. */
+    inline void setClock(Clock &c) noexcept {
+        clock = &c;
+    }
+};
@@ -0,0 +1,312 @@
+/* =====================================================================================
+ * Output through the Wayland virtual keyboard protocol.
+ *
+ * Copyright (C) 2018 Jonas Møller (no) <jonasmo441@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * =====================================================================================
+ */
+
+#include <string>
+
+extern "C" {
+    #include <dlfcn.h>
+    #include <unistd.h>
+    #include <string.h>
+    #include <stdlib.h>
+    #include <time.h>
+    #include <sys/mman.h>
+}
+
+#include "WaylandUDevice.hpp"
+#include "SystemError.hpp"
+
+using namespace std;
+
+/* libwayland-client is loaded at runtime, so its headers are not used.
+ * These have the same layout as wl_message and wl_interface, which are
+ * part of the stable libwayland ABI. */
+struct WlInterface;
+
+struct WlMessage {
+    const char *name;
+    const char *signature;
+    const WlInterface **types;
+};
+
+struct WlInterface {
+    const char *name;
+    int version;
+    int method_count;
+    const WlMessage *methods;
+    int event_count;
+    const WlMessage *events;
+};
+
+struct WlRegistryListener {
+    void (*global)(void *data, void *registry, uint32_t name,
+                   const char *interface, uint32_t version);
+    void (*global_remove)(void *data, void *registry, uint32_t name);
+};
+
+struct WaylandFns {
+    void *(*display_connect)(const char *name);
+    void (*display_disconnect)(void *display);
+    int (*display_roundtrip)(void *display);
+    void *(*marshal_constructor)(void *proxy, uint32_t opcode,
+                                 const WlInterface *interface, ...);
+    void *(*marshal_constructor_versioned)(void *proxy, uint32_t opcode,
+                                           const WlInterface *interface,
+                                           uint32_t version, ...);
+    void (*marshal)(void *proxy, uint32_t opcode, ...);
+    int (*add_listener)(void *proxy, void (**implementation)(void), void *data);
+    void (*proxy_destroy)(void *proxy);
+    const WlInterface *registry_interface;
+    const WlInterface *seat_interface;
+};
+
+/* Interfaces from virtual-keyboard-unstable-v1.xml, as wayland-scanner
+ * would have generated them. */
+extern const WlInterface virtual_keyboard_interface;
+
+static const WlInterface *no_types[] = {
+    nullptr, nullptr, nullptr, nullptr,
+};
+
+/** The wl_seat interface is filled in when libwayland-client is loaded. */
+static const WlInterface *create_keyboard_types[] = {
+    nullptr,
+    &virtual_keyboard_interface,
+};
+
+static const WlMessage manager_requests[] = {
+    {"create_virtual_keyboard", "on", create_keyboard_types},
+};
+
+static const WlMessage keyboard_requests[] = {
+    {"keymap", "uhu", no_types},
+    {"key", "uuu", no_types},
+    {"modifiers", "uuuu", no_types},
+    {"destroy", "", no_types},
+};
+
+static const WlInterface manager_interface = {
+    "zwp_virtual_keyboard_manager_v1", 1, 1, manager_requests, 0, nullptr,
+};
+
+const WlInterface virtual_keyboard_interface = {
+    "zwp_virtual_keyboard_v1", 1, 4, keyboard_requests, 0, nullptr,
+};
+
+/** Request opcodes */
+enum {
+    DISPLAY_GET_REGISTRY = 1,
+    REGISTRY_BIND = 0,
+    MANAGER_CREATE_VIRTUAL_KEYBOARD = 0,
+    KEYBOARD_KEYMAP = 0,
+    KEYBOARD_KEY = 1,
+    KEYBOARD_DESTROY = 3,
+};
+
+/** WL_KEYBOARD_KEYMAP_FORMAT_XKB_V1 */
+static constexpr uint32_t KEYMAP_FORMAT_XKB_V1 = 1;
+
+/** The compositor compiles the keymap with xkbcommon, which resolves
+ *  the includes from the XKB data installed on the system. */
+static const char keymap_fmt[] =
+    "xkb_keymap {\n"
+    "  xkb_keycodes { include \"evdev+aliases(qwerty)\" };\n"
+    "  xkb_types { include \"complete\" };\n"
+    "  xkb_compat { include \"complete\" };\n"
+    "  xkb_symbols { include \"pc+%s+inet(evdev)\" };\n"
+    "};\n";
+
+/** Sonames to try, in order. */
+static const char *libwayland_names[] = {
+    "libwayland-client.so.0",
+    "libwayland-client.so",
+};
+
+template <class T>
+static inline bool resolve(void *lib, const char *name, T *sym) {
+    return (*sym = (T) dlsym(lib, name)) != nullptr;
+}
+
+static void registryGlobal(void *data, void *, uint32_t name,
+                           const char *interface, uint32_t version)
+{
+    static_cast<WaylandUDevice *>(data)->global(name, interface, version);
+}
+
+static void registryGlobalRemove(void *, void *, uint32_t) {}
+
+static const WlRegistryListener registry_listener = {
+    registryGlobal,
+    registryGlobalRemove,
+};
+
+WaylandUDevice::WaylandUDevice() {
+    for (const char *name : libwayland_names)
+        if ((lib = dlopen(name, RTLD_NOW | RTLD_LOCAL)))
+            break;
+    if (!lib)
+        throw SystemError(string("Unable to load libwayland-client: ") + dlerror());
+
+    wl = new WaylandFns;
+    bool ok = resolve(lib, "wl_display_connect", &wl->display_connect)
+        && resolve(lib, "wl_display_disconnect", &wl->display_disconnect)
+        && resolve(lib, "wl_display_roundtrip", &wl->display_roundtrip)
+        && resolve(lib, "wl_proxy_marshal_constructor", &wl->marshal_constructor)
+        && resolve(lib, "wl_proxy_marshal_constructor_versioned",
+                   &wl->marshal_constructor_versioned)
+        && resolve(lib, "wl_proxy_marshal", &wl->marshal)
+        && resolve(lib, "wl_proxy_add_listener", &wl->add_listener)
+        && resolve(lib, "wl_proxy_destroy", &wl->proxy_destroy)
+        && resolve(lib, "wl_registry_interface", &wl->registry_interface)
+        && resolve(lib, "wl_seat_interface", &wl->seat_interface);
+    if (!ok) {
+        string err(dlerror());
+        close();
+        throw SystemError("Unable to resolve libwayland-client symbols: " + err);
+    }
+    create_keyboard_types[0] = wl->seat_interface;
+
+    if (!(display = wl->display_connect(nullptr))) {
+        close();
+        throw SystemError("Unable to connect to Wayland display");
+    }
+
+    registry = wl->marshal_constructor(display, DISPLAY_GET_REGISTRY,
+                                       wl->registry_interface, nullptr);
+    wl->add_listener(registry, (void (**)(void)) &registry_listener, this);
+    wl->display_roundtrip(display);
+
+    if (!seat || !manager) {
+        close();
+        throw SystemError("The Wayland compositor does not support "
+                          "zwp_virtual_keyboard_manager_v1");
+    }
+
+    keyboard = wl->marshal_constructor(manager, MANAGER_CREATE_VIRTUAL_KEYBOARD,
+                                       &virtual_keyboard_interface, seat, nullptr);
+
+    const char *layout = getenv("XKB_DEFAULT_LAYOUT");
+    const char *variant = getenv("XKB_DEFAULT_VARIANT");
+    try {
+        sendKeymap(layout ? layout : "us", variant ? variant : "");
+    } catch (const SystemError &) {
+        close();
+        throw;
+    }
+    flush();
+}
+
+WaylandUDevice::~WaylandUDevice() {
+    close();
+}
+
+void WaylandUDevice::global(uint32_t name, const char *interface, uint32_t) {
+    if (!seat && !strcmp(interface, "wl_seat"))
+        seat = wl->marshal_constructor_versioned(registry, REGISTRY_BIND,
+                                                 wl->seat_interface, 1, name,
+                                                 "wl_seat", 1, nullptr);
+    else if (!manager && !strcmp(interface, manager_interface.name))
+        manager = wl->marshal_constructor_versioned(registry, REGISTRY_BIND,
+                                                    &manager_interface, 1, name,
+                                                    manager_interface.name, 1,
+                                                    nullptr);
+}
+
+void WaylandUDevice::sendKeymap(const string &layout, const string &variant) {
+    string symbols = layout;
+    if (!variant.empty())
+        symbols += "(" + variant + ")";
+    char *keymap;
+    if (asprintf(&keymap, keymap_fmt, symbols.c_str()) == -1)
+        throw SystemError("Unable to allocate keymap");
+    // The size includes the terminating null byte.
+    size_t size = strlen(keymap) + 1;
+
+    int fd = memfd_create("hawck-keymap", MFD_CLOEXEC);
+    if (fd == -1) {
+        free(keymap);
+        throw SystemError("Unable to create keymap file: ", errno);
+    }
+    ssize_t written = write(fd, keymap, size);
+    free(keymap);
+    if (written != (ssize_t) size) {
+        ::close(fd);
+        throw SystemError("Unable to write keymap file: ", errno);
+    }
+
+    // libwayland duplicates the fd when sending it.
+    wl->marshal(keyboard, KEYBOARD_KEYMAP, KEYMAP_FORMAT_XKB_V1, fd, (uint32_t) size);
+    ::close(fd);
+}
+
+void WaylandUDevice::close() noexcept {
+    if (wl) {
+        if (keyboard) {
+            wl->marshal(keyboard, KEYBOARD_DESTROY);
+            wl->proxy_destroy(keyboard);
+        }
+        if (manager)
+            wl->proxy_destroy(manager);
+        if (seat)
+            wl->proxy_destroy(seat);
+        if (registry)
+            wl->proxy_destroy(registry);
+        if (display) {
+            wl->display_roundtrip(display);
+            wl->display_disconnect(display);
+        }
+        delete wl;
+    }
+    if (lib)
+        dlclose(lib);
+    keyboard = manager = seat = registry = display = lib = nullptr;
+    wl = nullptr;
+}
+
+void WaylandUDevice::emit(const input_event *send_event) {
+    emit(send_event->type, send_event->code, send_event->value);
+}
+
+void WaylandUDevice::emit(int type, int code, int val) {
+    // The compositor generates its own key repeats, and has no use for
+    // SYN_REPORT.
+    if (type != EV_KEY || val == 2)
+        return;
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    uint32_t time_ms = ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+    wl->marshal(keyboard, KEYBOARD_KEY, time_ms, (uint32_t) code, (uint32_t) (val != 0));
+}
+
+void WaylandUDevice::flush() {
+    if (wl->display_roundtrip(display) == -1)
+        throw SystemError("Lost connection to the Wayland compositor: ", errno);
+}
+
+void WaylandUDevice::done() {
+    flush();
+}
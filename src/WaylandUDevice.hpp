@@ -0,0 +1,93 @@
+/* =====================================================================================
+ * Output through the Wayland virtual keyboard protocol.
+ *
+ * Copyright (C) 2018 Jonas Møller (no) <jonasmo441@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * =====================================================================================
+ */
+
+/** @file WaylandUDevice.hpp
+ *
+ * @brief Output through the Wayland virtual keyboard protocol.
+ */
+
+#pragma once
+
+#include <string>
+
+#include "IUDevice.hpp"
+
+/** Virtual device that sends key events to a Wayland compositor with
+ *  the zwp_virtual_keyboard_v1 protocol.
+ *
+ * The compositor applies the events directly, without them going
+ * through uinput and libinput, so they do not need any pacing. Only
+ * compositors that implement the protocol are supported, i.e those
+ * based on wlroots.
+ *
+ * The keyboard gets an XKB keymap for the layout in
+ * $XKB_DEFAULT_LAYOUT and $XKB_DEFAULT_VARIANT, or "us" if unset. The
+ * layout should match the keymap configured in Hawck.
+ *
+ * libwayland-client is loaded at runtime, it is not needed unless this
+ * device is used.
+ */
+class WaylandUDevice : public IUDevice {
+private:
+    void *lib = nullptr;
+    /** Opaque Wayland objects, see WaylandUDevice.cpp */
+    void *display = nullptr;
+    void *registry = nullptr;
+    void *seat = nullptr;
+    void *manager = nullptr;
+    void *keyboard = nullptr;
+    /** Functions from libwayland-client */
+    struct WaylandFns *wl = nullptr;
+
+    void close() noexcept;
+
+    /** Upload the keymap to the compositor. */
+    void sendKeymap(const std::string &layout, const std::string &variant);
+
+public:
+    /** Connect to the compositor in $WAYLAND_DISPLAY.
+     *
+     * @throws SystemError if there is no compositor, or it does not
+     *         support the virtual keyboard protocol.
+     */
+    WaylandUDevice();
+
+    virtual ~WaylandUDevice();
+
+    /** Called for globals announced by the compositor. */
+    void global(uint32_t name, const char *interface, uint32_t version);
+
+    virtual void emit(const input_event *send_event) override;
+
+    virtual void emit(int type, int code, int val) override;
+
+    /** Wait until the compositor has processed the events. */
+    virtual void flush() override;
+
+    virtual void done() override;
+};
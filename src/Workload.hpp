@@ -0,0 +1,383 @@
+/* =====================================================================================
+ * Synthetic keyboard workloads.
+ *
+ * Copyright (C) 2018 Jonas Møller (no) <jonasmo441@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * =====================================================================================
+ */
+
+/** @file Workload.hpp
+ *
+ * @brief Model of keyboard input used by hawck-workload to generate
+ *        traces.
+ */
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <algorithm>
+#include <stdexcept>
+#include <random>
+#include <cmath>
+
+extern "C" {
+    #include <ctype.h>
+    #include <linux/input.h>
+}
+
+#include "EventCodes.hpp"
+
+/**
+ * Random number generation with fixed algorithms, the distributions in
+ * <random> are implementation defined, and would make traces differ
+ * between standard libraries.
+ */
+class Rng {
+private:
+    std::mt19937_64 gen;
+
+public:
+    explicit Rng(uint64_t seed) : gen(seed) {}
+
+    /** Uniform in [0, 1) */
+    double uniform() {
+        return (gen() >> 11) * (1.0 / 9007199254740992.0);
+    }
+
+    /** Exponentially distributed with the given mean. */
+    double exponential(double mean) {
+        return -std::log(1.0 - uniform()) * mean;
+    }
+
+    /** Normally distributed, using the Box-Muller transform. */
+    double normal(double mean, double stddev) {
+        double u = 1.0 - uniform(), v = uniform();
+        return mean + stddev * std::sqrt(-2.0 * std::log(u)) * std::cos(2.0 * M_PI * v);
+    }
+
+    bool chance(double p) {
+        return uniform() < p;
+    }
+
+    size_t index(size_t n) {
+        return std::min((size_t) (uniform() * n), n - 1);
+    }
+};
+
+/** Character n-gram model used to choose which key to press next. */
+class NGramModel {
+private:
+    using Counts = std::vector<std::pair<char, uint32_t>>;
+    size_t n;
+    /** Maps contexts of up to n-1 characters to next-character counts. */
+    std::unordered_map<std::string, Counts> table;
+
+    static void count(Counts &counts, char c) {
+        for (auto &[chr, num] : counts)
+            if (chr == c) {
+                num++;
+                return;
+            }
+        counts.push_back({c, 1});
+    }
+
+public:
+    explicit NGramModel(size_t n) : n(std::max((size_t) 1, n)) {}
+
+    void train(const std::string &text) {
+        std::string hist;
+        for (char c : text) {
+            for (size_t len = 0; len <= hist.size(); len++)
+                count(table[hist.substr(hist.size() - len)], c);
+            hist += c;
+            if (hist.size() >= n)
+                hist.erase(0, 1);
+        }
+    }
+
+    /** Sample the next character, backs off to shorter contexts
+     *  when the full context was never seen. */
+    char sample(Rng &rng, const std::string &hist) {
+        std::string ctx = hist.substr(hist.size() - std::min(hist.size(), n - 1));
+        for (;; ctx.erase(0, 1)) {
+            auto it = table.find(ctx);
+            if (it == table.end())
+                continue;
+            uint64_t total = 0;
+            for (const auto &[_, num] : it->second)
+                total += num;
+            double r = rng.uniform() * total;
+            for (const auto &[chr, num] : it->second)
+                if ((r -= num) < 0)
+                    return chr;
+            return it->second.back().first;
+        }
+    }
+
+    bool empty() const {
+        return table.empty();
+    }
+};
+
+/** Key and whether shift is needed to type a character on a US layout. */
+struct KeyStroke {
+    int code;
+    bool shift;
+};
+
+inline int keyCode(const std::string &name) {
+    const EventCodes::Entry *e = EventCodes::find(name);
+    return (e && e->type == EV_KEY) ? e->code : -1;
+}
+
+inline KeyStroke charKey(char c) {
+    static const std::unordered_map<char, KeyStroke> special = {
+        {' ', {KEY_SPACE, false}},      {'\n', {KEY_ENTER, false}},
+        {'\t', {KEY_TAB, false}},       {',', {KEY_COMMA, false}},
+        {'.', {KEY_DOT, false}},        {'/', {KEY_SLASH, false}},
+        {';', {KEY_SEMICOLON, false}},  {'\'', {KEY_APOSTROPHE, false}},
+        {'-', {KEY_MINUS, false}},      {'=', {KEY_EQUAL, false}},
+        {'[', {KEY_LEFTBRACE, false}},  {']', {KEY_RIGHTBRACE, false}},
+        {'\\', {KEY_BACKSLASH, false}}, {'`', {KEY_GRAVE, false}},
+        {'<', {KEY_COMMA, true}},       {'>', {KEY_DOT, true}},
+        {'?', {KEY_SLASH, true}},       {':', {KEY_SEMICOLON, true}},
+        {'"', {KEY_APOSTROPHE, true}},  {'_', {KEY_MINUS, true}},
+        {'+', {KEY_EQUAL, true}},       {'{', {KEY_LEFTBRACE, true}},
+        {'}', {KEY_RIGHTBRACE, true}},  {'|', {KEY_BACKSLASH, true}},
+        {'~', {KEY_GRAVE, true}},       {'!', {KEY_1, true}},
+        {'@', {KEY_2, true}},           {'#', {KEY_3, true}},
+        {'$', {KEY_4, true}},           {'%', {KEY_5, true}},
+        {'^', {KEY_6, true}},           {'&', {KEY_7, true}},
+        {'*', {KEY_8, true}},           {'(', {KEY_9, true}},
+        {')', {KEY_0, true}},
+    };
+    auto it = special.find(c);
+    if (it != special.end())
+        return it->second;
+    if (isalnum((unsigned char) c))
+        return {keyCode(std::string("KEY_") + (char) toupper(c)), (bool) isupper(c)};
+    return {-1, false};
+}
+
+/** Parameters of the workload model. */
+struct Workload {
+    uint64_t seed = 1;
+    double duration_s = 60;
+    /** Mean keystrokes per minute, arrivals are a Poisson process. */
+    double rate_kpm = 300;
+    size_t ngram = 3;
+    double hold_mean_ms = 90;
+    double hold_stddev_ms = 25;
+    /** Probability of holding a key long enough for it to repeat. */
+    double repeat_prob = 0.01;
+    double repeat_hold_ms = 800;
+    double repeat_delay_ms = 250;
+    double repeat_period_ms = 33;
+    /** Probability of a modifier chord instead of a character. */
+    double chord_prob = 0.03;
+    /** Probability of a burst of presses on one macro key. */
+    double hammer_prob = 0;
+    int hammer_count = 20;
+    double hammer_hz = 15;
+};
+
+/** An event at a time in microseconds, before sorting. */
+struct TimedEvent {
+    int64_t t_us;
+    uint64_t seq;
+    int code;
+    int value;
+};
+
+class Generator {
+private:
+    const Workload &w;
+    Rng rng;
+    NGramModel model;
+    std::vector<TimedEvent> evs;
+    uint64_t seq = 0;
+    size_t num_strokes = 0;
+    /** When each key that has been pressed was last released. */
+    std::unordered_map<int, int64_t> up_at;
+    /** Shortest time between the release of a key and its next press. */
+    static constexpr int64_t min_gap_us = 10000;
+
+    void key(int64_t t_us, int code, int value) {
+        evs.push_back({t_us, seq++, code, value});
+        if (value == 0)
+            up_at[code] = t_us;
+    }
+
+    /** Get the earliest time from t_us at which a key can be pressed,
+     *  a key that is still held has to be released first. */
+    int64_t freeAt(int code, int64_t t_us) {
+        auto it = up_at.find(code);
+        if (it == up_at.end())
+            return t_us;
+        return std::max(t_us, it->second + min_gap_us);
+    }
+
+    /** Press and release a key, with key repeats if it is held past
+     *  the repeat delay. The press is delayed until the key has been
+     *  released, if it is still held.
+     *
+     * @return Release time.
+     */
+    int64_t stroke(int64_t t_us, int code, double hold_ms) {
+        t_us = freeAt(code, t_us);
+        int64_t up_us = t_us + (int64_t) (hold_ms * 1000);
+        key(t_us, code, 1);
+        for (double r = w.repeat_delay_ms; t_us + r * 1000 < up_us; r += w.repeat_period_ms)
+            key(t_us + (int64_t) (r * 1000), code, 2);
+        key(up_us, code, 0);
+        num_strokes++;
+        return up_us;
+    }
+
+    double holdTime() {
+        if (rng.chance(w.repeat_prob))
+            return rng.exponential(w.repeat_hold_ms) + w.repeat_delay_ms;
+        return std::max(20.0, rng.normal(w.hold_mean_ms, w.hold_stddev_ms));
+    }
+
+    /** Type a character, with shift if needed. */
+    void typeChar(int64_t t_us, char c) {
+        KeyStroke ks = charKey(c);
+        if (ks.code < 0)
+            return;
+        if (!ks.shift) {
+            stroke(t_us, ks.code, holdTime());
+            return;
+        }
+        t_us = freeAt(KEY_LEFTSHIFT, t_us);
+        key(t_us, KEY_LEFTSHIFT, 1);
+        int64_t up_us = stroke(t_us + 30000, ks.code, holdTime());
+        key(up_us + 20000, KEY_LEFTSHIFT, 0);
+    }
+
+    /** Press a modifier chord, like ctrl+s or ctrl+shift+t. */
+    void chord(int64_t t_us) {
+        static const std::vector<std::pair<std::vector<int>, double>> mods = {
+            {{KEY_LEFTCTRL}, 0.55},
+            {{KEY_LEFTALT}, 0.2},
+            {{KEY_LEFTMETA}, 0.1},
+            {{KEY_LEFTCTRL, KEY_LEFTSHIFT}, 0.15},
+        };
+        double r = rng.uniform();
+        const std::vector<int> *held = &mods.back().first;
+        for (const auto &[m, p] : mods)
+            if ((r -= p) < 0) {
+                held = &m;
+                break;
+            }
+        int code = charKey('a' + rng.index(26)).code;
+        for (int mod : *held) {
+            t_us = freeAt(mod, t_us);
+            key(t_us, mod, 1);
+            t_us += 40000;
+        }
+        t_us = stroke(t_us, code, std::max(20.0, rng.normal(w.hold_mean_ms, w.hold_stddev_ms)));
+        for (auto it = held->rbegin(); it != held->rend(); it++) {
+            t_us += 30000;
+            key(t_us, *it, 0);
+        }
+    }
+
+    /** Hammer a macro pad key, F13-F24 are common on macro pads.
+     *
+     * @return Time of the last release.
+     */
+    int64_t hammer(int64_t t_us) {
+        int code = KEY_F13 + rng.index(12);
+        double period_ms = 1000.0 / w.hammer_hz;
+        for (int i = 0; i < w.hammer_count; i++) {
+            double hold_ms = std::max(10.0, rng.normal(period_ms / 2, period_ms / 8));
+            stroke(t_us, code, std::min(hold_ms, period_ms - 5));
+            t_us += (int64_t) (std::max(period_ms, rng.normal(period_ms, period_ms / 6)) * 1000);
+        }
+        return t_us;
+    }
+
+public:
+    Generator(const Workload &w, const std::string &corpus)
+        : w(w),
+          rng(w.seed),
+          model(w.ngram)
+    {
+        model.train(corpus);
+        if (model.empty())
+            throw std::runtime_error("The corpus is empty");
+    }
+
+    std::vector<struct input_event> run() {
+        int64_t end_us = (int64_t) (w.duration_s * 1e6);
+        double mean_gap_ms = 60000.0 / w.rate_kpm;
+        std::string hist;
+
+        for (int64_t t_us = 0;; ) {
+            t_us += (int64_t) (rng.exponential(mean_gap_ms) * 1000);
+            if (t_us >= end_us)
+                break;
+            if (rng.chance(w.hammer_prob)) {
+                t_us = hammer(t_us);
+            } else if (rng.chance(w.chord_prob)) {
+                chord(t_us);
+            } else {
+                char c = model.sample(rng, hist);
+                hist += c;
+                if (hist.size() > w.ngram)
+                    hist.erase(0, 1);
+                typeChar(t_us, c);
+            }
+        }
+
+        // Keys overlap when typing fast, order everything by time and
+        // end every event with a SYN_REPORT like a keyboard would.
+        std::sort(evs.begin(), evs.end(), [](const TimedEvent &a, const TimedEvent &b) {
+                                         return (a.t_us != b.t_us) ? a.t_us < b.t_us
+                                                                   : a.seq < b.seq;
+                                     });
+        std::vector<struct input_event> out;
+        out.reserve(evs.size() * 2);
+        for (const auto &te : evs) {
+            struct input_event ev = {};
+            ev.time.tv_sec = te.t_us / 1000000;
+            ev.time.tv_usec = te.t_us % 1000000;
+            ev.type = EV_KEY;
+            ev.code = te.code;
+            ev.value = te.value;
+            out.push_back(ev);
+            ev.type = EV_SYN;
+            ev.code = SYN_REPORT;
+            ev.value = 0;
+            out.push_back(ev);
+        }
+        return out;
+    }
+
+    size_t numStrokes() const {
+        return num_strokes;
+    }
+};
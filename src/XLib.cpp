@@ -0,0 +1,99 @@
+/* =====================================================================================
+ * Runtime loading of libX11.
+ *
+ * Copyright (C) 2018 Jonas Møller (no) <jonasmo441@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * =====================================================================================
+ */
+
+#include <mutex>
+
+#if MESON_COMPILE
+#include <hawck_config.h>
+#else
+#define USE_X11 0
+#endif
+
+#if USE_X11
+
+extern "C" {
+    #include <dlfcn.h>
+    #include <syslog.h>
+}
+
+#include "XLib.hpp"
+
+using namespace std;
+
+/** Sonames to try, in order. */
+static const char *libx11_names[] = {
+    "libX11.so.6",
+    "libX11.so",
+};
+
+template <class T>
+static inline bool resolve(void *lib, const char *name, T *fn) {
+    *fn = (T) dlsym(lib, name);
+    if (*fn == nullptr) {
+        syslog(LOG_ERR, "Unable to resolve %s: %s", name, dlerror());
+        return false;
+    }
+    return true;
+}
+
+/** Resolve the functions from libX11, it is never unloaded. */
+static bool load(XLib &x) {
+    void *lib = nullptr;
+    for (const char *name : libx11_names)
+        if ((lib = dlopen(name, RTLD_NOW | RTLD_LOCAL)))
+            break;
+    if (lib == nullptr) {
+        syslog(LOG_WARNING, "Unable to load libX11: %s", dlerror());
+        return false;
+    }
+
+    bool ok = resolve(lib, "XOpenDisplay", &x.OpenDisplay)
+        && resolve(lib, "XCloseDisplay", &x.CloseDisplay)
+        && resolve(lib, "XSync", &x.Sync)
+        && resolve(lib, "XPending", &x.Pending)
+        && resolve(lib, "XNextEvent", &x.NextEvent)
+        && resolve(lib, "XSelectInput", &x.SelectInput)
+        && resolve(lib, "XInternAtom", &x.InternAtom)
+        && resolve(lib, "XGetWindowProperty", &x.GetWindowProperty)
+        && resolve(lib, "XGetClassHint", &x.GetClassHint)
+        && resolve(lib, "XFree", &x.Free)
+        && resolve(lib, "XSetErrorHandler", &x.SetErrorHandler);
+    if (!ok)
+        dlclose(lib);
+    return ok;
+}
+
+const XLib *XLib::get() {
+    static XLib x;
+    static bool loaded = false;
+    static once_flag load_flag;
+    call_once(load_flag, []() { loaded = load(x); });
+    return loaded ? &x : nullptr;
+}
+
+#endif
@@ -0,0 +1,74 @@
+/* =====================================================================================
+ * Runtime loading of libX11.
+ *
+ * Copyright (C) 2018 Jonas Møller (no) <jonasmo441@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * =====================================================================================
+ */
+
+/** @file XLib.hpp
+ *
+ * @brief Functions from libX11, loaded at runtime.
+ *
+ * Only include this when USE_X11 is set, the X11 headers are still
+ * needed for the types and macros.
+ */
+
+#pragma once
+
+extern "C" {
+    #include <X11/Xlib.h>
+    #include <X11/Xutil.h>
+    #include <X11/Xatom.h>
+}
+
+/** The parts of libX11 used by FocusWatcher and XTestUDevice.
+ *
+ * MacroD does not link with libX11, so that it starts on machines
+ * without X11, and does not map it when running under Wayland.
+ *
+ * Example:
+ *
+ *   const XLib *x = XLib::get();
+ *   if (x && (dpy = x->OpenDisplay(nullptr)))
+ *       ...
+ */
+struct XLib {
+    decltype(&XOpenDisplay) OpenDisplay;
+    decltype(&XCloseDisplay) CloseDisplay;
+    decltype(&XSync) Sync;
+    decltype(&XPending) Pending;
+    decltype(&XNextEvent) NextEvent;
+    decltype(&XSelectInput) SelectInput;
+    decltype(&XInternAtom) InternAtom;
+    decltype(&XGetWindowProperty) GetWindowProperty;
+    decltype(&XGetClassHint) GetClassHint;
+    decltype(&XFree) Free;
+    decltype(&XSetErrorHandler) SetErrorHandler;
+
+    /** Load libX11 the first time this is called.
+     *
+     * @return The functions, or nullptr if libX11 could not be loaded.
+     */
+    static const XLib *get();
+};
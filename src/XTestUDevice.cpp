@@ -0,0 +1,122 @@
+/* =====================================================================================
+ * Output through the X11 XTEST extension.
+ *
+ * Copyright (C) 2018 Jonas Møller (no) <jonasmo441@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * =====================================================================================
+ */
+
+#if MESON_COMPILE
+#include <hawck_config.h>
+#else
+#define USE_X11 0
+#endif
+
+extern "C" {
+    #include <dlfcn.h>
+}
+
+#include "XTestUDevice.hpp"
+#include "SystemError.hpp"
+#if USE_X11
+#include "XLib.hpp"
+#endif
+
+using namespace std;
+
+/** Sonames to try, in order. */
+static const char *libxtst_names[] = {
+    "libXtst.so.6",
+    "libXtst.so",
+};
+
+/** X11 keycodes are offset from evdev codes by 8. */
+static constexpr int EVDEV_OFFSET = 8;
+
+XTestUDevice::XTestUDevice() {
+#if USE_X11
+    const XLib *x = XLib::get();
+    if (!x)
+        throw SystemError("Unable to load libX11");
+    if (!(dpy = x->OpenDisplay(nullptr)))
+        throw SystemError("Unable to open X11 display");
+
+    for (const char *name : libxtst_names)
+        if ((lib = dlopen(name, RTLD_NOW | RTLD_LOCAL)))
+            break;
+    if (!lib) {
+        string err(dlerror());
+        close();
+        throw SystemError("Unable to load libXtst: " + err);
+    }
+
+    auto query = (Bool (*)(Display *, int *, int *, int *, int *))
+        dlsym(lib, "XTestQueryExtension");
+    fake_key = (decltype(fake_key)) dlsym(lib, "XTestFakeKeyEvent");
+    int ev_base, err_base, major, minor;
+    if (!query || !fake_key ||
+        !query((Display *) dpy, &ev_base, &err_base, &major, &minor))
+    {
+        close();
+        throw SystemError("The X11 display does not support XTEST");
+    }
+#else
+    throw SystemError("Hawck was built without X11 support");
+#endif
+}
+
+XTestUDevice::~XTestUDevice() {
+    close();
+}
+
+void XTestUDevice::close() noexcept {
+#if USE_X11
+    if (dpy)
+        XLib::get()->CloseDisplay((Display *) dpy);
+#endif
+    if (lib)
+        dlclose(lib);
+    dpy = lib = nullptr;
+}
+
+void XTestUDevice::emit(const input_event *send_event) {
+    emit(send_event->type, send_event->code, send_event->value);
+}
+
+void XTestUDevice::emit(int type, int code, int val) {
+    // The X server generates its own key repeats, and has no use for
+    // SYN_REPORT.
+    if (type != EV_KEY || val == 2)
+        return;
+    fake_key(dpy, code + EVDEV_OFFSET, val != 0, 0);
+}
+
+void XTestUDevice::flush() {
+#if USE_X11
+    XLib::get()->Sync((Display *) dpy, False);
+#endif
+}
+
+void XTestUDevice::done() {
+    flush();
+}
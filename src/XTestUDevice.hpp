@@ -0,0 +1,76 @@
+/* =====================================================================================
+ * Output through the X11 XTEST extension.
+ *
+ * Copyright (C) 2018 Jonas Møller (no) <jonasmo441@gmail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * =====================================================================================
+ */
+
+/** @file XTestUDevice.hpp
+ *
+ * @brief Output through the X11 XTEST extension.
+ */
+
+#pragma once
+
+#include "IUDevice.hpp"
+
+/** Virtual device that fakes key events on an X11 display with XTEST.
+ *
+ * Events are handed straight to the X server instead of going through
+ * uinput and libinput, so they do not need any pacing. Only X11
+ * clients receive them, under Wayland use WaylandUDevice.
+ *
+ * libX11 and libXtst are loaded at runtime, they are not needed
+ * unless this device is used.
+ */
+class XTestUDevice : public IUDevice {
+private:
+    /** Display connection, opaque so that users of this class
+     *  do not have to include the X11 headers. */
+    void *dpy = nullptr;
+    void *lib = nullptr;
+    int (*fake_key)(void *dpy, unsigned int keycode, int is_press,
+                    unsigned long delay) = nullptr;
+
+    void close() noexcept;
+
+public:
+    /** Connect to the display in $DISPLAY.
+     *
+     * @throws SystemError if there is no display, or it does not
+     *         support XTEST.
+     */
+    XTestUDevice();
+
+    virtual ~XTestUDevice();
+
+    virtual void emit(const input_event *send_event) override;
+
+    virtual void emit(int type, int code, int val) override;
+
+    /** Wait until the X server has processed the events. */
+    virtual void flush() override;
+
+    virtual void done() override;
+};
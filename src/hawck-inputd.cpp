@@ -25,6 +25,7 @@ static void handleSigPipe(int) {
 }
 
 static int no_fork;
+static int probe_delivery;
 
 auto varToOption(string opt) {
     replace(opt.begin(), opt.end(), '_', '-');
@@ -57,7 +58,7 @@ int main(int argc, char *argv[]) {
     signal(SIGPIPE, handleSigPipe);
 
     string HELP =
-        "Usage: hawck-inputd [--udev-event-delay <us>] [--no-fork] [--socket-timeout] -k <device>\n"
+        "Usage: hawck-inputd [--udev-event-delay <us>] [--no-fork] [--socket-timeout] [--order <policy>] -k <device>\n"
         "\n"
         "Examples:\n"
         "  hawck-inputd --kbd-device /dev/input/event13            Listen on a single device.\n\n"
@@ -70,6 +71,24 @@ int main(int argc, char *argv[]) {
         "  -k, --kbd-device    Add a keyboard to listen to.\n"
         "  --udev-event-delay  Delay between events sent on the udevice in us.\n"
         "  --socket-timeout    Time in milliseconds until timeout on sockets.\n"
+        "  --order             How keys are ordered while MacroD is busy, \"strict\"\n"
+        "                      keeps the order they were typed in, \"fastlane\" lets\n"
+        "                      keys that do not depend on a running macro through.\n"
+        "  --macro-rate        Events per second that MacroD may emit, 0 for no limit.\n"
+        "  --macro-burst       Events that MacroD may emit at once.\n"
+        "  --rate-policy       What to do with MacroD events beyond the rate, \"defer\"\n"
+        "                      emits them later and \"drop\" throws them away.\n"
+        "  --input-rate        Key repeats per second from keyboards, 0 for no limit.\n"
+        "  --input-burst       Key repeats from keyboards that may be emitted at once.\n"
+        "  --lag-depth         Number of events waiting for MacroD before it is\n"
+        "                      considered to be behind, stale key repeats are\n"
+        "                      dropped while it is.\n"
+        "  --lag-time          Time in milliseconds before an unanswered event means\n"
+        "                      that MacroD is behind.\n"
+        "  --watchdog          Time in milliseconds that the event loop may stall\n"
+        "                      before the keyboards are released, 0 to disable.\n"
+        "  --probe-delivery    Measure how long emitted events take to be delivered\n"
+        "                      by the kernel, logged on SIGUSR1.\n"
     ;
 
     //daemonize("/var/log/hawck-input/log");
@@ -77,8 +96,18 @@ int main(int argc, char *argv[]) {
         {
             /* These options set a flag. */
             {"no-fork", no_argument,       &no_fork, 1},
+            {"probe-delivery", no_argument,       &probe_delivery, 1},
             {"udev-event-delay", required_argument,       0, 0},
             {"socket-timeout", required_argument,       0, 0},
+            {"order", required_argument,       0, 0},
+            {"macro-rate", required_argument,       0, 0},
+            {"macro-burst", required_argument,       0, 0},
+            {"rate-policy", required_argument,       0, 0},
+            {"input-rate", required_argument,       0, 0},
+            {"input-burst", required_argument,       0, 0},
+            {"lag-depth", required_argument,       0, 0},
+            {"lag-time", required_argument,       0, 0},
+            {"watchdog", required_argument,       0, 0},
             {"version", no_argument, 0, 0},
             /* These options don’t set a flag.
                We distinguish them by their indices. */
@@ -92,6 +121,15 @@ int main(int argc, char *argv[]) {
 
     int udev_event_delay = 3800;
     int socket_timeout = 1024;
+    string order = "strict";
+    int macro_rate = 256;
+    int macro_burst = 512;
+    string rate_policy = "defer";
+    int input_rate = 1000;
+    int input_burst = 200;
+    int lag_depth = 8;
+    int lag_time = 100;
+    int watchdog = 300;
     vector<string> kbd_names;
     vector<string> kbd_devices;
     unordered_map<string, function<void(const string& opt)>> long_handlers = {
@@ -101,6 +139,15 @@ int main(int argc, char *argv[]) {
                     }},
         NUM_OPTION(udev_event_delay)
         NUM_OPTION(socket_timeout)
+        NUM_OPTION(macro_rate)
+        NUM_OPTION(macro_burst)
+        NUM_OPTION(input_rate)
+        NUM_OPTION(input_burst)
+        NUM_OPTION(lag_depth)
+        NUM_OPTION(lag_time)
+        NUM_OPTION(watchdog)
+        STR_OPTION(order),
+        STR_OPTION(rate_policy)
     };
 
     do {
@@ -146,6 +193,26 @@ int main(int argc, char *argv[]) {
         }
     } while (true);
 
+    OrderPolicy order_policy;
+    if (order == "strict")
+        order_policy = OrderPolicy::STRICT;
+    else if (order == "fastlane")
+        order_policy = OrderPolicy::FASTLANE;
+    else {
+        cout << "--order: Expected \"strict\" or \"fastlane\"" << endl;
+        exit(0);
+    }
+
+    RatePolicy rate_pol;
+    if (rate_policy == "defer")
+        rate_pol = RatePolicy::DEFER;
+    else if (rate_policy == "drop")
+        rate_pol = RatePolicy::DROP;
+    else {
+        cout << "--rate-policy: Expected \"defer\" or \"drop\"" << endl;
+        exit(0);
+    }
+
     if (kbd_devices.size() == 0) {
         cout << "Unable to start Hawck InputD without any keyboard devices." << endl;
         exit(0);
@@ -178,6 +245,13 @@ int main(int argc, char *argv[]) {
             daemon.addDevice(dev);
         daemon.setEventDelay(udev_event_delay);
         daemon.setSocketTimeout(socket_timeout);
+        daemon.setOrderPolicy(order_policy);
+        daemon.setMacroRate(macro_rate, macro_burst, rate_pol);
+        daemon.setInputRate(input_rate, input_burst);
+        daemon.setLagLimits(lag_depth, lag_time);
+        daemon.setWatchdog(watchdog);
+        if (probe_delivery)
+            daemon.setDeliveryProbe(true);
         syslog(LOG_INFO, "Running Hawck InputD ...");
         cout << "Running ..." << endl;
         daemon.run();
@@ -18,12 +18,22 @@ static int no_fork;
 
 int main(int argc, char *argv[]) {
     string HELP =
-        "Usage: hawck-macrod [--no-fork]\n"
+        "Usage: hawck-macrod [--no-fork] [--output <backend>] [--replay <trace>]\n"
         "\n"
         "Options:\n"
-        "  --no-fork   Don't daemonize/fork.\n"
-        "  -h, --help  Display this help information.\n"
-        "  --version   Display version and exit.\n"
+        "  --no-fork          Don't daemonize/fork.\n"
+        "  --replay <trace>   Run the key events in a trace through the enabled\n"
+        "                     scripts without connecting to InputD, then print\n"
+        "                     timing statistics and exit. Traces can be made\n"
+        "                     with hawck-workload.\n"
+        "  --output <backend> How key events are output, \"uinput\" sends them to\n"
+        "                     InputD, \"xtest\" and \"wayland\" apply them on the\n"
+        "                     display directly. \"auto\" picks one of the latter\n"
+        "                     depending on the session, with uinput as the\n"
+        "                     fallback. Defaults to uinput, as the others\n"
+        "                     bypass InputD.\n"
+        "  -h, --help         Display this help information.\n"
+        "  --version          Display version and exit.\n"
     ;
 
     //daemonize("/var/log/hawck-input/log");
@@ -32,6 +42,8 @@ int main(int argc, char *argv[]) {
             /* These options set a flag. */
             {"no-fork", no_argument,       &no_fork, 1},
             {"version", no_argument, 0, 0},
+            {"replay", required_argument, 0, 0},
+            {"output", required_argument, 0, 0},
             /* These options don’t set a flag.
                We distinguish them by their indices. */
             {"help",         no_argument,       0, 'h'},
@@ -39,12 +51,25 @@ int main(int argc, char *argv[]) {
         };
     /* getopt_long stores the option index here. */
     int option_index = 0;
+    string replay_path;
+    string output = "uinput";
 
     unordered_map<string, function<void(const string& opt)>> long_handlers = {
         {"version", [&](const string&) {
                         cout << "Hawck InputD v" MACROD_VERSION << endl;
                         exit(0);
                     }},
+        {"replay", [&](const string& path) {
+                       replay_path = path;
+                   }},
+        {"output", [&](const string& name) {
+                       if (name != "auto" && name != "uinput" &&
+                           name != "xtest" && name != "wayland") {
+                           cout << "--output: Expected auto, uinput, xtest or wayland" << endl;
+                           exit(0);
+                       }
+                       output = name;
+                   }},
     };
 
     do {
@@ -81,6 +106,17 @@ int main(int argc, char *argv[]) {
         }
     } while (true);
 
+    if (!replay_path.empty()) {
+        try {
+            MacroDaemon daemon;
+            daemon.replay(replay_path);
+        } catch (exception &e) {
+            cout << e.what() << endl;
+            return EXIT_FAILURE;
+        }
+        return EXIT_SUCCESS;
+    }
+
     cout << "hawck-macrod v" MACROD_VERSION " forking ..." << endl;
 
     if (!no_fork) {
@@ -96,6 +132,7 @@ int main(int argc, char *argv[]) {
 
     MacroDaemon daemon;
     try {
+        daemon.setOutput(output);
         daemon.run();
     } catch (exception &e) {
         cout << e.what() << endl;
@@ -0,0 +1,162 @@
+--[====================================================================================[
+   Generate the keymap alias index.
+
+   Usage: lua5.3 gen-aliases.lua <output> [keysymdef.h]
+
+   Computes which key name produces each character in every installed
+   keymap, using the parsed keymap tables and the Unicode values listed
+   in X11/keysymdef.h. The result is written as an index that
+   Keymap.lua and hawck-ui read a single keymap from, see
+   kbmap.readAliases for the format.
+
+   Requires Keymap.lua and keymaps/aliases.lua on the LUA_PATH.
+
+   Copyright (C) 2018 Jonas Møller (no) <jonasmo441@gmail.com>
+   All rights reserved.
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions are met:
+
+   1. Redistributions of source code must retain the above copyright notice, this
+      list of conditions and the following disclaimer.
+   2. Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+
+   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+   ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+   WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+   DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+   FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+   DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+   SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+   CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+   OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+   OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+--]====================================================================================]
+
+local kbmap = require "Keymap"
+local BUILTIN_ALIASES = require "keymaps/aliases"
+
+local out_path = arg[1]
+local keysymdef_path = arg[2] or "/usr/include/X11/keysymdef.h"
+
+if not out_path then
+  io.stderr:write("Usage: gen-aliases.lua <output> [keysymdef.h]\n")
+  os.exit(1)
+end
+
+-- Keys that produce characters, but have no Unicode value in keysymdef.h
+local SPECIAL = {
+  Return = "\n",
+  Tab = "\t",
+}
+
+--- Read key name to character mappings from keysymdef.h, falls back
+--  to the builtin aliases when keysymdef.h is not installed.
+local function readKeysyms(path)
+  local keysyms = {}
+  local file = io.open(path)
+  if not file then
+    io.stderr:write(("Unable to open %s, using builtin aliases\n"):format(path))
+    for chr, name in pairs(BUILTIN_ALIASES) do
+      keysyms[name] = chr
+    end
+    return keysyms
+  end
+  for line in file:lines() do
+    local name, hex = line:match("^#define XK_([%w_]+)%s+0x%x+%s*/%*%s*%(?U%+(%x+)")
+    if name then
+      keysyms[name] = utf8.char(tonumber(hex, 16))
+    end
+  end
+  file:close()
+  for name, chr in pairs(SPECIAL) do
+    keysyms[name] = chr
+  end
+  return keysyms
+end
+
+--- Get the character produced by a key name, or nil.
+local function symChar(keysyms, name)
+  -- Keymaps may use Unicode names directly, i.e U+00e5
+  local hex = name:match("^U%+(%x+)$")
+  if hex then
+    return utf8.char(tonumber(hex, 16))
+  end
+  if utf8.len(name) == 1 then
+    return name
+  end
+  return keysyms[name]
+end
+
+local function sortedNames(t)
+  local names = {}
+  for name, _ in pairs(t) do
+    if type(name) == "string" then
+      table.insert(names, name)
+    end
+  end
+  table.sort(names)
+  return names
+end
+
+--- Compute the character to key name aliases of a keymap, keys
+--  that can be typed without modifiers take precedence.
+local function keymapAliases(keysyms, map)
+  local aliases = {}
+  local function add(name)
+    local chr = symChar(keysyms, name)
+    if chr and chr ~= name and not aliases[chr] then
+      aliases[chr] = name
+    end
+  end
+  for _, name in ipairs(sortedNames(map.keymap)) do
+    add(name)
+  end
+  for _, name in ipairs(sortedNames(map.combo_map)) do
+    add(name)
+  end
+  return aliases
+end
+
+--- Format the aliases of a keymap as a section of the index.
+local function formatSection(aliases)
+  local codes = {}
+  for chr, _ in pairs(aliases) do
+    table.insert(codes, utf8.codepoint(chr))
+  end
+  table.sort(codes)
+  local lines = {}
+  for _, code in ipairs(codes) do
+    table.insert(lines, ("%04x\t%s\n"):format(code, aliases[utf8.char(code)]))
+  end
+  return table.concat(lines)
+end
+
+local keysyms = readKeysyms(keysymdef_path)
+local maps = kbmap.getall()
+local index = {}
+local sections = {}
+local offset = 0
+
+for _, lang in ipairs(sortedNames(maps)) do
+  local succ, map = pcall(kbmap.load, maps[lang])
+  if succ then
+    local section = formatSection(keymapAliases(keysyms, map))
+    table.insert(index, ("%s %d %d\n"):format(lang, offset, #section))
+    table.insert(sections, section)
+    offset = offset + #section
+  else
+    io.stderr:write(("Unable to load keymap %s: %s\n"):format(lang, map))
+  end
+end
+
+local out = assert(io.open(out_path, "wb"))
+out:write("HWKALIAS 1\n")
+out:write(table.concat(index))
+out:write("\n")
+out:write(table.concat(sections))
+out:close()
+
+print(("Wrote aliases for %d keymaps to %s"):format(#index, out_path))
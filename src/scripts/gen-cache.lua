@@ -0,0 +1,164 @@
+--[====================================================================================[
+   Generate the module cache.
+
+   Usage: lua5.3 gen-cache.lua <output> <LLib directory> <keymaps directory>
+
+   Precompiles the LLib modules, the Lua modules in the keymaps
+   directory and every installed keymap to bytecode, and writes them to
+   a cache that MacroD maps read-only and loads modules from, see
+   ModuleCache.hpp for the format. Keymaps are stored as the tables that
+   kbmap.load produces, so they are not parsed again by every script.
+
+   Requires Keymap.lua and utils.lua on the LUA_PATH.
+
+   Copyright (C) 2018 Jonas Møller (no) <jonasmo441@gmail.com>
+   All rights reserved.
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions are met:
+
+   1. Redistributions of source code must retain the above copyright notice, this
+      list of conditions and the following disclaimer.
+   2. Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+
+   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+   ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+   WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+   DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+   FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+   DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+   SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+   CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+   OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+   OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+--]====================================================================================]
+
+local kbmap = require "Keymap"
+local u = require "utils"
+
+local out_path, llib_dir, keymaps_dir = arg[1], arg[2], arg[3]
+
+if not (out_path and llib_dir and keymaps_dir) then
+  io.stderr:write("Usage: gen-cache.lua <output> <LLib directory> <keymaps directory>\n")
+  os.exit(1)
+end
+
+--- FNV-1a, must match hashFile() in ModuleCache.cpp
+local function fnv1a(data)
+  local h = 2166136261
+  for i = 1, #data do
+    h = ((h ~ data:byte(i)) * 16777619) & 0xffffffff
+  end
+  return h
+end
+
+local function readFile(path)
+  local file = assert(io.open(path, "rb"))
+  local data = file:read("a")
+  file:close()
+  return data
+end
+
+--- List the Lua files in a directory.
+local function luaFiles(dir)
+  local files = {}
+  local p = io.popen(("ls %s"):format(u.shescape(dir)))
+  for name in p:lines() do
+    if name:match("%.lua$") then
+      table.insert(files, name)
+    end
+  end
+  p:close()
+  table.sort(files)
+  return files
+end
+
+--- Format a value as a Lua expression, keys are sorted so that the
+--  same keymap always gives the same chunk.
+local function serialize(v)
+  local t = type(v)
+  if t == "table" then
+    local keys = {}
+    for k, _ in pairs(v) do
+      table.insert(keys, k)
+    end
+    table.sort(keys, function (a, b)
+      if type(a) ~= type(b) then
+        return type(a) < type(b)
+      end
+      return a < b
+    end)
+    local parts = {}
+    for _, k in ipairs(keys) do
+      table.insert(parts, ("[%s]=%s"):format(serialize(k), serialize(v[k])))
+    end
+    return "{" .. table.concat(parts, ",") .. "}"
+  elseif t == "string" then
+    return ("%q"):format(v)
+  elseif t == "number" then
+    return math.type(v) == "integer" and tostring(v) or ("%q"):format(v)
+  elseif t == "boolean" then
+    return tostring(v)
+  end
+  error("Unable to serialize a " .. t)
+end
+
+local entries = {}
+
+local function add(name, chunk, source)
+  table.insert(entries, {name = name, chunk = chunk, source = source,
+                         hash = fnv1a(readFile(source))})
+end
+
+-- Debug information is kept for modules, so that errors still point
+-- at their source.
+for _, file in ipairs(luaFiles(llib_dir)) do
+  local path = u.joinpaths({llib_dir, file})
+  add(file:gsub("%.lua$", ""), string.dump(assert(loadfile(path))), path)
+end
+for _, file in ipairs(luaFiles(keymaps_dir)) do
+  local path = u.joinpaths({keymaps_dir, file})
+  add("keymaps/" .. file:gsub("%.lua$", ""), string.dump(assert(loadfile(path))), path)
+end
+
+local maps = kbmap.getall()
+local langs = {}
+for lang, _ in pairs(maps) do
+  table.insert(langs, lang)
+end
+table.sort(langs)
+for _, lang in ipairs(langs) do
+  local succ, map = pcall(kbmap.load, maps[lang])
+  if succ then
+    local src = "return " .. serialize({keymap = map.keymap,
+                                        combo_map = map.combo_map,
+                                        mod_codes = map.mod_codes})
+    local chunk = assert(load(src, "=keymaps/compiled/" .. lang))
+    add("keymaps/compiled/" .. lang, string.dump(chunk, true), maps[lang])
+  else
+    io.stderr:write(("Unable to load keymap %s: %s\n"):format(lang, map))
+  end
+end
+
+local index = {}
+local offset = 0
+for _, e in ipairs(entries) do
+  table.insert(index, ("%s %d %d %08x %s\n"):format(e.name, offset, #e.chunk, e.hash, e.source))
+  offset = offset + #e.chunk
+end
+
+-- Written to a temporary file first, MacroD may have the old cache mapped.
+local tmp_path = out_path .. ".tmp"
+local out = assert(io.open(tmp_path, "wb"))
+out:write("HWKCACHE 1\n")
+out:write(table.concat(index))
+out:write("\n")
+for _, e in ipairs(entries) do
+  out:write(e.chunk)
+end
+out:close()
+assert(os.rename(tmp_path, out_path))
+
+print(("Wrote %d modules to %s"):format(#entries, out_path))
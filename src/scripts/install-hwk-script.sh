@@ -35,7 +35,17 @@ SCRIPTS_DIR="$HOME/.local/share/hawck/scripts/"
 script_path="$1"
 name=$(basename "$script_path" | sed -r 's/\.[^.]+$//')
 keys_filename="$name.csv"
-real_keys="/var/lib/hawck-input/keys/$keys_filename"
+## Keys are only passed to the MacroD session of the user that owns
+## the script, its uid has to be given when running as hawck-input.
+owner_uid="$2"
+if [ -z "$owner_uid" ]; then
+    if [ "$(whoami)" = "$HAWCKD_INPUT_USER" ]; then
+        echo "Usage: install-hwk-script.sh <script> <uid>" >&2
+        exit 1
+    fi
+    owner_uid=$(id -u)
+fi
+real_keys="/var/lib/hawck-input/keys/$owner_uid/$keys_filename"
 
 ## Transpile hwk script to Lua
 hwk_out=$(hwk2lua "$script_path")
@@ -82,6 +92,7 @@ end
 if ! cmp "$real_keys" "$tmp_keys" >&2; then
     ## Check if we can execute the copy command:
     if [ "$(whoami)" = "$HAWCKD_INPUT_USER" ]; then
+       mkdir -p "$(dirname "$real_keys")"
        cp "$tmp_keys" "$real_keys"
        chmod 644 "$real_keys"
     else
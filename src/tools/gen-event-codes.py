@@ -0,0 +1,184 @@
+#!/usr/bin/python3
+
+##
+## Generate constexpr event code name tables from linux/input-event-codes.h
+##
+## Usage: gen-event-codes.py <input-event-codes.h> <output.hpp>
+##
+## The output is included by EventCodes.hpp, which also holds the lookup
+## functions. The name hash used here must match EventCodes::hash().
+##
+
+import re
+import sys
+
+## Event type prefixes, mapped to the event type that the codes belong to.
+PREFIXES = {
+    "SYN": "EV_SYN",
+    "KEY": "EV_KEY",
+    "BTN": "EV_KEY",
+    "REL": "EV_REL",
+    "ABS": "EV_ABS",
+    "MSC": "EV_MSC",
+    "SW":  "EV_SW",
+    "LED": "EV_LED",
+    "SND": "EV_SND",
+    "REP": "EV_REP",
+}
+
+define_rx = re.compile(r"^#define\s+((EV|[A-Z]+)_[A-Z0-9_]+)\s+([A-Za-z0-9_]+)\b", re.MULTILINE)
+
+def parse(text):
+    """Returns ([(name, type, code, is_alias)], {type_name: type}) in the
+    order of definition, type is None for the event types themselves."""
+    values = {}
+    defs = []
+    for name, prefix, val in define_rx.findall(text):
+        if name.endswith("_MAX") or name.endswith("_CNT"):
+            continue
+        if prefix != "EV" and prefix not in PREFIXES:
+            continue
+        alias = False
+        if re.match(r"^(0x[0-9a-fA-F]+|[0-9]+)$", val):
+            code = int(val, 0)
+        elif val in values:
+            code = values[val]
+            alias = True
+        else:
+            continue
+        values[name] = code
+        defs.append((name, prefix, code, alias))
+
+    types = {name: code for name, prefix, code, _ in defs if prefix == "EV"}
+    out = []
+    for name, prefix, code, alias in defs:
+        if prefix == "EV":
+            out.append((name, None, code, alias))
+        else:
+            out.append((name, types[PREFIXES[prefix]], code, alias))
+    return out, types
+
+def fnv1a(seed, s):
+    h = (2166136261 ^ seed) & 0xffffffff
+    for c in s.encode():
+        h ^= c
+        h = (h * 16777619) & 0xffffffff
+    return h
+
+def perfect_hash(names):
+    """Hash and displace, returns (seeds, slots) such that the name
+    names[slots[fnv1a(seeds[fnv1a(0, name) % len(seeds)], name) % len(names)]]
+    is equal to name."""
+    n = len(names)
+    nbuckets = max(1, n // 4)
+    buckets = [[] for _ in range(nbuckets)]
+    for idx, name in enumerate(names):
+        buckets[fnv1a(0, name) % nbuckets].append(idx)
+
+    seeds = [0] * nbuckets
+    slots = [None] * n
+    for b in sorted(range(nbuckets), key=lambda b: -len(buckets[b])):
+        if not buckets[b]:
+            continue
+        seed = 1
+        while True:
+            taken = [fnv1a(seed, names[i]) % n for i in buckets[b]]
+            if len(set(taken)) == len(taken) and all(slots[t] is None for t in taken):
+                break
+            seed += 1
+        seeds[b] = seed
+        for i, t in zip(buckets[b], taken):
+            slots[t] = i
+    return seeds, [0 if s is None else s for s in slots]
+
+def main(src, dst):
+    with open(src) as f:
+        defs, types = parse(f.read())
+
+    entries = [(name, tp, code) for name, tp, code, _ in defs if tp is not None]
+    names = [name for name, _, _ in entries]
+    if len(set(names)) != len(names):
+        raise SystemExit("Duplicate names in %s" % src)
+    seeds, slots = perfect_hash(names)
+
+    ## Primary (first non-alias) name of every code, per event type.
+    type_names = {}
+    code_names = {}
+    for name, tp, code, alias in defs:
+        if tp is None:
+            type_names.setdefault(code, name)
+        elif not alias:
+            code_names.setdefault(tp, {}).setdefault(code, name)
+
+    out = []
+    w = out.append
+    w("// Generated by gen-event-codes.py from %s, do not edit." % src)
+    w("")
+    w("#pragma once")
+    w("")
+    w("#include <stdint.h>")
+    w("#include <stddef.h>")
+    w("")
+    w("namespace EventCodes {")
+    w("    struct Entry {")
+    w("        const char *name;")
+    w("        uint16_t type;")
+    w("        uint16_t code;")
+    w("    };")
+    w("")
+    w("    /** Every named code, aliases included. */")
+    w("    constexpr Entry entries[] = {")
+    for name, tp, code in entries:
+        w('        {"%s", %d, %d},' % (name, tp, code))
+    w("    };")
+    w("    constexpr size_t num_entries = %d;" % len(entries))
+    w("")
+    w("    /** Perfect hash displacement seeds, one per bucket. */")
+    w("    constexpr uint32_t hash_seeds[] = {")
+    for i in range(0, len(seeds), 8):
+        w("        " + " ".join("%d," % s for s in seeds[i:i+8]))
+    w("    };")
+    w("    constexpr size_t num_buckets = %d;" % len(seeds))
+    w("")
+    w("    /** Maps perfect hash slots to indices into entries. */")
+    w("    constexpr uint16_t hash_slots[] = {")
+    for i in range(0, len(slots), 12):
+        w("        " + " ".join("%d," % s for s in slots[i:i+12]))
+    w("    };")
+    w("")
+    w("    /** Event type names, indexed by type. */")
+    w("    constexpr const char *type_names[%d] = {" % (max(types.values()) + 1))
+    for tp in range(max(types.values()) + 1):
+        w('        %s,' % ('"%s"' % type_names[tp] if tp in type_names else "nullptr"))
+    w("    };")
+    w("    constexpr size_t num_types = %d;" % (max(types.values()) + 1))
+    w("")
+    for tp in sorted(code_names):
+        codes = code_names[tp]
+        w("    constexpr const char *%s_names[%d] = {" % (type_names[tp][3:].lower(), max(codes) + 1))
+        for code in range(max(codes) + 1):
+            w('        %s,' % ('"%s"' % codes[code] if code in codes else "nullptr"))
+        w("    };")
+        w("")
+    w("    /** Code names, indexed by type and then code. */")
+    w("    constexpr const char *const *code_names[num_types] = {")
+    for tp in range(max(types.values()) + 1):
+        w("        %s," % ("%s_names" % type_names[tp][3:].lower() if tp in code_names else "nullptr"))
+    w("    };")
+    w("")
+    w("    /** Number of elements in each of the code_names arrays. */")
+    w("    constexpr size_t num_codes[num_types] = {")
+    for tp in range(max(types.values()) + 1):
+        w("        %d," % (max(code_names[tp]) + 1 if tp in code_names else 0))
+    w("    };")
+    w("}")
+    w("")
+
+    with open(dst, "w") as f:
+        f.write("\n".join(out))
+
+if __name__ == "__main__":
+    if len(sys.argv) != 3:
+        print("Usage: %s <input-event-codes.h> <output.hpp>" % sys.argv[0], file=sys.stderr)
+        sys.exit(1)
+    main(sys.argv[1], sys.argv[2])
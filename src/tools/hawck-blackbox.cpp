@@ -0,0 +1,146 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * hawck-blackbox, dump the performance black box of the Hawck daemons               *
+ *                                                                                   *
+ * Copyright (C) 2018 Jonas Møller (no) <jonasmo441@gmail.com>                       *
+ * All rights reserved.                                                              *
+ *                                                                                   *
+ * Redistribution and use in source and binary forms, with or without                *
+ * modification, are permitted provided that the following conditions are met:       *
+ *                                                                                   *
+ * 1. Redistributions of source code must retain the above copyright notice, this    *
+ *    list of conditions and the following disclaimer.                               *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,      *
+ *    this list of conditions and the following disclaimer in the documentation      *
+ *    and/or other materials provided with the distribution.                         *
+ *                                                                                   *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND   *
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED     *
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE            *
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE      *
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL        *
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR        *
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER        *
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,     *
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE     *
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.              *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+/** @file */
+
+#include <string>
+#include <vector>
+#include <iostream>
+
+extern "C" {
+    #include <getopt.h>
+    #include <stdlib.h>
+    #include <stdio.h>
+    #include <time.h>
+}
+
+#include "Blackbox.hpp"
+
+using namespace std;
+
+static const char *INPUTD_BLACKBOX = "/var/lib/hawck-input/blackbox";
+static const char *MACROD_BLACKBOX = "/.local/share/hawck/blackbox";
+
+static void printTable(const vector<BlackboxRecord> &recs) {
+    printf("%-19s %7s %8s %8s %8s %5s %4s %4s %4s %4s %8s %5s %7s\n",
+           "time", "events", "p50_us", "p99_us", "max_us", "queue", "tmo",
+           "stl", "hot", "rld", "rld_us", "drop", "lua_kib");
+    for (const auto &r : recs) {
+        char tbuf[32];
+        time_t t = r.time;
+        struct tm tm;
+        strftime(tbuf, sizeof(tbuf), "%F %T", localtime_r(&t, &tm));
+        printf("%-19s %7u %8u %8u %8u %5u %4u %4u %4u %4u %8u %5u %7u\n",
+               tbuf, r.num_events, r.lat_p50_us, r.lat_p99_us, r.lat_max_us,
+               r.max_queue, r.num_timeouts, r.num_stalls, r.num_hotplug,
+               r.num_reloads, r.reload_us, r.num_dropped, r.lua_kib);
+    }
+}
+
+static void printCSV(const vector<BlackboxRecord> &recs) {
+    printf("time,events,lat_p50_us,lat_p99_us,lat_max_us,max_queue,timeouts,"
+           "stalls,hotplug,reloads,reload_us,dropped,lua_kib\n");
+    for (const auto &r : recs)
+        printf("%lld,%u,%u,%u,%u,%u,%u,%u,%u,%u,%u,%u,%u\n",
+               (long long) r.time, r.num_events, r.lat_p50_us, r.lat_p99_us,
+               r.lat_max_us, r.max_queue, r.num_timeouts, r.num_stalls,
+               r.num_hotplug, r.num_reloads, r.reload_us, r.num_dropped,
+               r.lua_kib);
+}
+
+int main(int argc, char *argv[]) {
+    bool csv = false;
+    long last = 0;
+    int c;
+
+    static const struct option long_opts[] = {
+        {"help",    no_argument,       nullptr, 'h'},
+        {"version", no_argument,       nullptr, 'v'},
+        {"csv",     no_argument,       nullptr, 'c'},
+        {"last",    required_argument, nullptr, 'n'},
+        {nullptr,   0,                 nullptr, 0},
+    };
+
+    while ((c = getopt_long(argc, argv, "hvcn:", long_opts, nullptr)) != -1)
+        switch (c) {
+            case 'h':
+                cout <<
+                    "Usage: hawck-blackbox [options] [file ...]\n"
+                    "\n"
+                    "Dump the per-second performance records kept by hawck-inputd and\n"
+                    "hawck-macrod. Without files, both of their black boxes are read.\n"
+                    "\n"
+                    "Options:\n"
+                    "  -h, --help            Display this help info.\n"
+                    "  -v, --version         Display version.\n"
+                    "  -c, --csv             Print comma separated values.\n"
+                    "  -n, --last            Only print the last N records.\n";
+                return EXIT_SUCCESS;
+            case 'v':
+                printf("hawck-blackbox v0.1\n");
+                return EXIT_SUCCESS;
+            case 'c': csv = true; break;
+            case 'n':
+                last = strtol(optarg, nullptr, 10);
+                if (last <= 0) {
+                    cerr << "--last must be a positive number" << endl;
+                    return EXIT_FAILURE;
+                }
+                break;
+            default:
+                return EXIT_FAILURE;
+        }
+
+    vector<string> paths(argv + optind, argv + argc);
+    if (paths.empty()) {
+        paths.push_back(INPUTD_BLACKBOX);
+        if (const char *home = getenv("HOME"))
+            paths.push_back(string(home) + MACROD_BLACKBOX);
+    }
+
+    int ret = EXIT_SUCCESS;
+    for (size_t i = 0; i < paths.size(); i++) {
+        vector<BlackboxRecord> recs;
+        try {
+            recs = Blackbox::read(paths[i]);
+        } catch (const exception &e) {
+            cerr << e.what() << endl;
+            ret = EXIT_FAILURE;
+            continue;
+        }
+        if (last && recs.size() > (size_t) last)
+            recs.erase(recs.begin(), recs.end() - last);
+        if (paths.size() > 1)
+            printf("%s# %s\n", i ? "\n" : "", paths[i].c_str());
+        if (csv)
+            printCSV(recs);
+        else
+            printTable(recs);
+    }
+
+    return ret;
+}
@@ -0,0 +1,493 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * hawck-test, run test cases against Hawck scripts                                  *
+ *                                                                                   *
+ * Copyright (C) 2018 Jonas Møller (no) <jonasmo441@gmail.com>                       *
+ * All rights reserved.                                                              *
+ *                                                                                   *
+ * Redistribution and use in source and binary forms, with or without                *
+ * modification, are permitted provided that the following conditions are met:       *
+ *                                                                                   *
+ * 1. Redistributions of source code must retain the above copyright notice, this    *
+ *    list of conditions and the following disclaimer.                               *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,      *
+ *    this list of conditions and the following disclaimer in the documentation      *
+ *    and/or other materials provided with the distribution.                         *
+ *                                                                                   *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND   *
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED     *
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE            *
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE      *
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL        *
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR        *
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER        *
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,     *
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE     *
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.              *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+/** @file */
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <sstream>
+#include <algorithm>
+#include <stdexcept>
+
+extern "C" {
+    #include <ctype.h>
+    #include <getopt.h>
+    #include <stdlib.h>
+    #include <string.h>
+    #include <linux/input.h>
+    #include <lua.h>
+    #include <lauxlib.h>
+    #include <lualib.h>
+}
+
+#include "SystemError.hpp"
+#include "LuaUtils.hpp"
+#include "LuaEventCodes.hpp"
+#include "LuaSharedState.hpp"
+#include "LuaModuleCache.hpp"
+#include "EventCodes.hpp"
+#include "IUDevice.hpp"
+#include "RemoteUDevice.hpp"
+#include "MacroRecorder.hpp"
+#include "SharedState.hpp"
+#include "ModuleCache.hpp"
+#include "utils.hpp"
+
+using namespace std;
+using namespace std::chrono;
+
+/** Stands in for MacroD's launcher, so that tests never start any
+ *  applications. */
+static const char LAUNCHER_STUB[] =
+    "launcher = { spawned = {} }\n"
+    "function launcher:exec(name, action)\n"
+    "  return action == '' and name or name .. ' ' .. action\n"
+    "end\n"
+    "function launcher:spawn(cmd)\n"
+    "  table.insert(self.spawned, cmd)\n"
+    "end\n";
+
+/** Keeps the events emitted by a script. */
+class CaptureUDevice : public IUDevice {
+public:
+    vector<input_event> events;
+
+    virtual void emit(const input_event *ev) override {
+        events.push_back(*ev);
+    }
+
+    virtual void emit(int type, int code, int val) override {
+        input_event ev = {};
+        ev.type = type;
+        ev.code = code;
+        ev.value = val;
+        events.push_back(ev);
+    }
+
+    virtual void done() override {}
+
+    virtual void flush() override {}
+};
+
+struct TestCase {
+    /** Test file the case was read from. */
+    string file;
+    /** Absolute path of the script under test. */
+    string script;
+    string name;
+    vector<input_event> input;
+    vector<input_event> output;
+    /** Commands that app launchers are expected to spawn. */
+    bool check_spawns = false;
+    vector<string> spawns;
+    /** Longest time a single input event may take, 0 for no limit. */
+    long budget_us = 0;
+};
+
+struct TestResult {
+    bool ok = false;
+    string msg;
+    /** Longest time that a single input event took. */
+    long max_us = 0;
+};
+
+/** Parse events written as "+a -a =a", i.e a press, release and
+ *  repeat of the A key. */
+static vector<input_event> parseEvents(const string &spec) {
+    vector<input_event> evs;
+    istringstream ss(spec);
+    string tok;
+    while (ss >> tok) {
+        input_event ev = {};
+        ev.type = EV_KEY;
+        switch (tok[0]) {
+            case '+': ev.value = 1; break;
+            case '-': ev.value = 0; break;
+            case '=': ev.value = 2; break;
+            default:
+                throw invalid_argument("Expected +key, -key or =key, got: " + tok);
+        }
+        string name = tok.substr(1);
+        if (!name.empty() && all_of(name.begin(), name.end(), ::isdigit)) {
+            ev.code = stoi(name);
+        } else {
+            // Same names as keymaps/default_linux, e.g "esc" or "btn_left"
+            string full = name.compare(0, 4, "btn_") ? "KEY_" : "";
+            for (char c : name)
+                full += toupper(c);
+            const EventCodes::Entry *e = EventCodes::find(full);
+            if (!e || e->type != EV_KEY)
+                throw invalid_argument("Unknown key: " + name);
+            ev.code = e->code;
+        }
+        evs.push_back(ev);
+    }
+    return evs;
+}
+
+static string fmtEvents(const vector<input_event> &evs) {
+    string s;
+    for (const auto &ev : evs) {
+        if (!s.empty())
+            s += ' ';
+        s += (ev.value == 1) ? '+' : (ev.value == 0) ? '-' : '=';
+        const char *name = EventCodes::codeName(EV_KEY, ev.code);
+        if (!name) {
+            s += to_string(ev.code);
+            continue;
+        }
+        if (!strncmp(name, "KEY_", 4))
+            name += 4;
+        for (; *name; name++)
+            s += tolower(*name);
+    }
+    return s;
+}
+
+static string joinStrings(const vector<string> &strs) {
+    string s;
+    for (const auto &str : strs)
+        s += (s.empty() ? "\"" : ", \"") + str + "\"";
+    return "{" + s + "}";
+}
+
+/** Get a string field of the table on top of the stack. */
+static bool getString(lua_State *L, const char *key, string &out) {
+    lua_getfield(L, -1, key);
+    bool found = lua_type(L, -1) == LUA_TSTRING;
+    if (found)
+        out = lua_tostring(L, -1);
+    lua_pop(L, 1);
+    return found;
+}
+
+/** Get an integer field of the table on top of the stack. */
+static long getInteger(lua_State *L, const char *key, long def) {
+    lua_getfield(L, -1, key);
+    long val = lua_isinteger(L, -1) ? lua_tointeger(L, -1) : def;
+    lua_pop(L, 1);
+    return val;
+}
+
+/** Read the cases of a test file.
+ *
+ * A test file is a Lua chunk that returns a table:
+ *
+ *   return {
+ *     script = "caps-to-esc.lua",
+ *     budget_us = 500,
+ *     cases = {
+ *       { name = "Caps is escape", input = "+capslock -capslock",
+ *         output = "+esc -esc" },
+ *     },
+ *   }
+ */
+static vector<TestCase> loadTests(const string &path, long budget_us) {
+    auto state = unique_ptr<lua_State, decltype(&lua_close)>(luaL_newstate(), &lua_close);
+    lua_State *L = state.get();
+    luaL_openlibs(L);
+    if (luaL_dofile(L, path.c_str()) != LUA_OK)
+        throw runtime_error(lua_tostring(L, -1));
+    if (!lua_istable(L, -1))
+        throw runtime_error(path + ": Expected a table of tests");
+
+    string script;
+    if (!getString(L, "script", script))
+        throw runtime_error(path + ": No script given");
+    // Scripts are relative to the test file.
+    if (script[0] != '/')
+        script = pathDirname(path) + "/" + script;
+    char *rpath = realpath(script.c_str(), nullptr);
+    if (!rpath)
+        throw SystemError("Unable to find script " + script + ": ", errno);
+    script = rpath;
+    free(rpath);
+    budget_us = getInteger(L, "budget_us", budget_us);
+
+    vector<TestCase> cases;
+    lua_getfield(L, -1, "cases");
+    if (!lua_istable(L, -1))
+        throw runtime_error(path + ": No cases given");
+    size_t len = lua_rawlen(L, -1);
+    for (size_t i = 1; i <= len; i++) {
+        lua_rawgeti(L, -1, i);
+        TestCase tc;
+        tc.file = path;
+        tc.script = script;
+        if (!getString(L, "name", tc.name))
+            tc.name = "#" + to_string(i);
+        string input, output;
+        if (!getString(L, "input", input) || !getString(L, "output", output))
+            throw runtime_error(path + ": " + tc.name + ": Cases need an input and an output");
+        try {
+            tc.input = parseEvents(input);
+            tc.output = parseEvents(output);
+        } catch (const invalid_argument &e) {
+            throw runtime_error(path + ": " + tc.name + ": " + e.what());
+        }
+        tc.budget_us = getInteger(L, "budget_us", budget_us);
+        lua_getfield(L, -1, "spawns");
+        if ((tc.check_spawns = lua_istable(L, -1))) {
+            size_t n = lua_rawlen(L, -1);
+            for (size_t j = 1; j <= n; j++) {
+                lua_rawgeti(L, -1, j);
+                if (lua_type(L, -1) == LUA_TSTRING)
+                    tc.spawns.push_back(lua_tostring(L, -1));
+                lua_pop(L, 1);
+            }
+        }
+        lua_pop(L, 2);
+        cases.push_back(tc);
+    }
+    return cases;
+}
+
+/** Get the commands that were passed to the launcher stub. */
+static vector<string> spawnedCommands(lua_State *L) {
+    vector<string> cmds;
+    lua_getglobal(L, "launcher");
+    lua_getfield(L, -1, "spawned");
+    size_t n = lua_rawlen(L, -1);
+    for (size_t i = 1; i <= n; i++) {
+        lua_rawgeti(L, -1, i);
+        cmds.push_back(lua_tostring(L, -1));
+        lua_pop(L, 1);
+    }
+    lua_pop(L, 2);
+    return cmds;
+}
+
+/** Run a test case on a fresh instance of its script, loaded the same
+ *  way as MacroDaemon::loadScript() does it. */
+static TestResult runCase(const TestCase &tc, const ModuleCache &cache) {
+    TestResult res;
+    CaptureUDevice out;
+    RemoteUDevice udev;
+    MacroRecorder recorder(&udev);
+    SharedState shared_state;
+    udev.setBackend(&out);
+    udev.setRecorder(&recorder);
+
+    Lua::Script sc;
+    try {
+        lua_State *L = sc.getL();
+        if (luaL_dostring(L, LAUNCHER_STUB) != LUA_OK)
+            throw Lua::LuaError(lua_tostring(L, -1));
+        Lua::openEventCodes(L);
+        Lua::openSharedState(L, &shared_state);
+        Lua::openModuleCache(L, &cache);
+        sc.call("require", "init");
+        sc.open(&udev, "udev");
+        sc.open(&recorder, "macros");
+        sc.from(tc.script);
+    } catch (const Lua::LuaError &e) {
+        res.msg = string("Unable to load script: ") + e.what();
+        return res;
+    }
+
+    // Mirrors MacroDaemon::processEvent()
+    uint64_t notified_gen = shared_state.generation();
+    for (const auto &ev : tc.input) {
+        auto t_start = steady_clock::now();
+        bool repeat = true;
+        try {
+            auto [succ] = sc.call<bool>("__match", (int) ev.value, (int) ev.code, (int) ev.type);
+            repeat = !succ;
+            if (shared_state.generation() != notified_gen) {
+                notified_gen = shared_state.generation();
+                sc.call("__stateChanged");
+            }
+        } catch (const Lua::LuaError &e) {
+            res.msg = "Lua error: " + e.fmtReport();
+            return res;
+        }
+        if (repeat)
+            udev.emit(&ev);
+        udev.done();
+        long us = duration_cast<microseconds>(steady_clock::now() - t_start).count();
+        res.max_us = max(res.max_us, us);
+    }
+
+    vector<input_event> got;
+    for (const auto &ev : out.events)
+        if (ev.type == EV_KEY)
+            got.push_back(ev);
+    string want_s = fmtEvents(tc.output), got_s = fmtEvents(got);
+    if (want_s != got_s) {
+        res.msg = "Expected \"" + want_s + "\", got \"" + got_s + "\"";
+        return res;
+    }
+
+    if (tc.check_spawns) {
+        auto spawned = spawnedCommands(sc.getL());
+        if (spawned != tc.spawns) {
+            res.msg = "Expected spawns " + joinStrings(tc.spawns) +
+                      ", got " + joinStrings(spawned);
+            return res;
+        }
+    }
+
+    if (tc.budget_us && res.max_us > tc.budget_us) {
+        res.msg = "Over budget, an event took " + to_string(res.max_us) +
+                  "us of " + to_string(tc.budget_us) + "us";
+        return res;
+    }
+
+    res.ok = true;
+    return res;
+}
+
+static long parseNum(const char *opt, const char *arg, long min_val) {
+    char *end;
+    long val = strtol(arg, &end, 10);
+    if (*arg == '\0' || *end != '\0' || val < min_val) {
+        cerr << opt << ": Expected a number >= " << min_val << ", got: " << arg << endl;
+        exit(EXIT_FAILURE);
+    }
+    return val;
+}
+
+int main(int argc, char *argv[]) {
+    long jobs = thread::hardware_concurrency();
+    long budget_us = 0;
+    bool verbose = false;
+    string lib_dir;
+    int c;
+
+    static const struct option long_opts[] = {
+        {"help",    no_argument,       nullptr, 'h'},
+        {"version", no_argument,       nullptr, 'v'},
+        {"jobs",    required_argument, nullptr, 'j'},
+        {"budget",  required_argument, nullptr, 'b'},
+        {"lib",     required_argument, nullptr, 'L'},
+        {"verbose", no_argument,       nullptr, 'V'},
+        {nullptr,   0,                 nullptr, 0},
+    };
+
+    while ((c = getopt_long(argc, argv, "hvj:b:L:V", long_opts, nullptr)) != -1)
+        switch (c) {
+            case 'h':
+                cout <<
+                    "Usage: hawck-test [options] <test.lua> ...\n"
+                    "\n"
+                    "Run test cases against Hawck scripts, with the emitted events\n"
+                    "captured instead of being sent to InputD. Cases are run in\n"
+                    "parallel, each on a fresh instance of its script.\n"
+                    "\n"
+                    "Options:\n"
+                    "  -h, --help            Display this help info.\n"
+                    "  -v, --version         Display version.\n"
+                    "  -j, --jobs            Number of cases to run at once, defaults to\n"
+                    "                        the number of CPUs.\n"
+                    "  -b, --budget          Longest time in µs that a single event may\n"
+                    "                        take, for test files that do not set a\n"
+                    "                        budget_us. Default 0, no limit.\n"
+                    "  -L, --lib             Directory with init.lua, LLib and keymaps,\n"
+                    "                        default ~/.local/share/hawck/scripts.\n"
+                    "  -V, --verbose         Also list the cases that passed.\n";
+                return EXIT_SUCCESS;
+            case 'v':
+                printf("hawck-test v0.1\n");
+                return EXIT_SUCCESS;
+            case 'j': jobs = parseNum("--jobs", optarg, 1); break;
+            case 'b': budget_us = parseNum("--budget", optarg, 0); break;
+            case 'L': lib_dir = optarg; break;
+            case 'V': verbose = true; break;
+            default:
+                return EXIT_FAILURE;
+        }
+
+    if (optind == argc) {
+        cerr << "No test files given, see --help" << endl;
+        return EXIT_FAILURE;
+    }
+
+    // The module cache is built from the installed LLib, so it is not
+    // used when testing against another one.
+    ModuleCache cache;
+    if (lib_dir.empty()) {
+        const char *home = getenv("HOME");
+        if (!home) {
+            cerr << "Unable to find home directory, use --lib" << endl;
+            return EXIT_FAILURE;
+        }
+        lib_dir = string(home) + "/.local/share/hawck/scripts";
+        try {
+            cache.open(MODULE_CACHE_PATH);
+        } catch (const SystemError &) {}
+    }
+
+    vector<TestCase> cases;
+    try {
+        for (int i = optind; i < argc; i++) {
+            auto file_cases = loadTests(argv[i], budget_us);
+            cases.insert(cases.end(), file_cases.begin(), file_cases.end());
+        }
+        // Scripts require init.lua and the keymaps relative to the
+        // working directory, and all paths are absolute by now.
+        if (chdir(lib_dir.c_str()) == -1)
+            throw SystemError("Unable to chdir(" + lib_dir + "): ", errno);
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    vector<TestResult> results(cases.size());
+    atomic<size_t> next = 0;
+    auto worker = [&]() {
+                      for (size_t i; (i = next++) < cases.size();)
+                          results[i] = runCase(cases[i], cache);
+                  };
+    vector<thread> workers;
+    auto t_start = steady_clock::now();
+    for (long i = 0; i < min<long>(jobs, cases.size()); i++)
+        workers.emplace_back(worker);
+    for (auto &t : workers)
+        t.join();
+    double total_ms = duration<double, milli>(steady_clock::now() - t_start).count();
+
+    size_t num_failed = 0;
+    for (size_t i = 0; i < cases.size(); i++) {
+        const auto &tc = cases[i];
+        const auto &res = results[i];
+        if (!res.ok) {
+            num_failed++;
+            printf("FAIL %s: %s: %s\n", tc.file.c_str(), tc.name.c_str(), res.msg.c_str());
+        } else if (verbose) {
+            printf("ok   %s: %s (%ldus)\n", tc.file.c_str(), tc.name.c_str(), res.max_us);
+        }
+    }
+    printf("%zu passed, %zu failed in %.0f ms\n",
+           cases.size() - num_failed, num_failed, total_ms);
+
+    return num_failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
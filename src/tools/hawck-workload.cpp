@@ -0,0 +1,184 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * hawck-workload, generate synthetic input event traces                             *
+ *                                                                                   *
+ * Copyright (C) 2018 Jonas Møller (no) <jonasmo441@gmail.com>                       *
+ * All rights reserved.                                                              *
+ *                                                                                   *
+ * Redistribution and use in source and binary forms, with or without                *
+ * modification, are permitted provided that the following conditions are met:       *
+ *                                                                                   *
+ * 1. Redistributions of source code must retain the above copyright notice, this    *
+ *    list of conditions and the following disclaimer.                               *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,      *
+ *    this list of conditions and the following disclaimer in the documentation      *
+ *    and/or other materials provided with the distribution.                         *
+ *                                                                                   *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND   *
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED     *
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE            *
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE      *
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL        *
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR        *
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER        *
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,     *
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE     *
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.              *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+/** @file */
+
+#include <string>
+#include <vector>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+
+extern "C" {
+    #include <getopt.h>
+    #include <stdlib.h>
+    #include <linux/input.h>
+}
+
+#include "SystemError.hpp"
+#include "InputTrace.hpp"
+#include "Workload.hpp"
+
+using namespace std;
+
+/** Used when no corpus is given. */
+static const char DEFAULT_CORPUS[] =
+    "The quick brown fox jumps over the lazy dog. "
+    "Most of what people type is ordinary prose, a few words at a time with "
+    "short pauses in between, and the occasional burst when they know exactly "
+    "what they want to say. Numbers like 42 and 2018 show up now and then, as "
+    "do commas, periods, and the odd question? Editors see a lot of saving, "
+    "undoing and copying, which is where the modifier chords come from. "
+    "There is also the person who holds down a key until the screen fills "
+    "up, and the one who hammers the same button on a macro pad as fast as "
+    "they possibly can. A good benchmark should have a bit of all of it.\n"
+    "If you want to measure something specific, train the model on text that "
+    "looks like what your users actually type, for instance source code, "
+    "chat logs or email.\n";
+
+static string readFile(const string &path) {
+    ifstream in(path);
+    if (!in)
+        throw SystemError("Unable to open " + path + ": ", errno);
+    stringstream ss;
+    ss << in.rdbuf();
+    return ss.str();
+}
+
+static double parseNum(const char *opt, const char *arg, double min_val) {
+    char *end;
+    double val = strtod(arg, &end);
+    if (*end || val < min_val) {
+        cerr << "Invalid value for " << opt << ": " << arg << endl;
+        exit(EXIT_FAILURE);
+    }
+    return val;
+}
+
+int main(int argc, char *argv[]) {
+    Workload w;
+    string out_path, corpus_path;
+    int c;
+
+    enum {
+        OPT_HOLD_MS = 256,
+        OPT_REPEAT_PROB,
+        OPT_REPEAT_HOLD_MS,
+        OPT_CHORD_PROB,
+        OPT_HAMMER_PROB,
+        OPT_HAMMER_COUNT,
+        OPT_HAMMER_HZ,
+    };
+
+    static const struct option long_opts[] = {
+        {"help",           no_argument,       nullptr, 'h'},
+        {"version",        no_argument,       nullptr, 'v'},
+        {"output",         required_argument, nullptr, 'o'},
+        {"seed",           required_argument, nullptr, 's'},
+        {"duration",       required_argument, nullptr, 'd'},
+        {"rate",           required_argument, nullptr, 'r'},
+        {"ngram",          required_argument, nullptr, 'n'},
+        {"corpus",         required_argument, nullptr, 'c'},
+        {"hold-ms",        required_argument, nullptr, OPT_HOLD_MS},
+        {"repeat-prob",    required_argument, nullptr, OPT_REPEAT_PROB},
+        {"repeat-hold-ms", required_argument, nullptr, OPT_REPEAT_HOLD_MS},
+        {"chord-prob",     required_argument, nullptr, OPT_CHORD_PROB},
+        {"hammer-prob",    required_argument, nullptr, OPT_HAMMER_PROB},
+        {"hammer-count",   required_argument, nullptr, OPT_HAMMER_COUNT},
+        {"hammer-hz",      required_argument, nullptr, OPT_HAMMER_HZ},
+        {nullptr,          0,                 nullptr, 0},
+    };
+
+    while ((c = getopt_long(argc, argv, "hvo:s:d:r:n:c:", long_opts, nullptr)) != -1)
+        switch (c) {
+            case 'h':
+                cout <<
+                    "Usage: hawck-workload -o <trace> [options]\n"
+                    "\n"
+                    "Generate a trace of synthetic keyboard input. The same options and\n"
+                    "seed always produce the same trace.\n"
+                    "\n"
+                    "Options:\n"
+                    "  -h, --help            Display this help info.\n"
+                    "  -v, --version         Display version.\n"
+                    "  -o, --output          Trace file to write.\n"
+                    "  -s, --seed            Random seed, default 1.\n"
+                    "  -d, --duration        Length of the trace in seconds, default 60.\n"
+                    "  -r, --rate            Mean keystrokes per minute, default 300.\n"
+                    "  -n, --ngram           Order of the character n-gram model used to\n"
+                    "                        choose keys, default 3.\n"
+                    "  -c, --corpus          Text file to train the n-gram model on.\n"
+                    "  --hold-ms             Mean time a key is held down, default 90.\n"
+                    "  --repeat-prob         Probability of holding a key until it repeats,\n"
+                    "                        default 0.01.\n"
+                    "  --repeat-hold-ms      Mean time of such holds after the repeat delay,\n"
+                    "                        default 800.\n"
+                    "  --chord-prob          Probability of a modifier chord, default 0.03.\n"
+                    "  --hammer-prob         Probability of a burst of presses on a macro\n"
+                    "                        pad key (F13-F24), default 0.\n"
+                    "  --hammer-count        Presses in a burst, default 20.\n"
+                    "  --hammer-hz           Presses per second in a burst, default 15.\n";
+                return EXIT_SUCCESS;
+            case 'v':
+                printf("hawck-workload v0.1\n");
+                return EXIT_SUCCESS;
+            case 'o': out_path = optarg; break;
+            case 's': w.seed = strtoull(optarg, nullptr, 0); break;
+            case 'd': w.duration_s = parseNum("--duration", optarg, 0); break;
+            case 'r': w.rate_kpm = parseNum("--rate", optarg, 1); break;
+            case 'n': w.ngram = parseNum("--ngram", optarg, 1); break;
+            case 'c': corpus_path = optarg; break;
+            case OPT_HOLD_MS: w.hold_mean_ms = parseNum("--hold-ms", optarg, 1); break;
+            case OPT_REPEAT_PROB: w.repeat_prob = parseNum("--repeat-prob", optarg, 0); break;
+            case OPT_REPEAT_HOLD_MS: w.repeat_hold_ms = parseNum("--repeat-hold-ms", optarg, 0); break;
+            case OPT_CHORD_PROB: w.chord_prob = parseNum("--chord-prob", optarg, 0); break;
+            case OPT_HAMMER_PROB: w.hammer_prob = parseNum("--hammer-prob", optarg, 0); break;
+            case OPT_HAMMER_COUNT: w.hammer_count = parseNum("--hammer-count", optarg, 1); break;
+            case OPT_HAMMER_HZ: w.hammer_hz = parseNum("--hammer-hz", optarg, 1); break;
+            default:
+                return EXIT_FAILURE;
+        }
+
+    if (out_path.empty()) {
+        cerr << "No output file given, see --help" << endl;
+        return EXIT_FAILURE;
+    }
+
+    try {
+        string corpus = corpus_path.empty() ? DEFAULT_CORPUS : readFile(corpus_path);
+        Generator gen(w, corpus);
+        auto evs = gen.run();
+        writeTrace(out_path, evs);
+        cerr << "Wrote " << gen.numStrokes() << " keystrokes, " << evs.size()
+             << " events to " << out_path << endl;
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -33,6 +33,8 @@
 #include <memory>
 #include <vector>
 #include <functional>
+#include <algorithm>
+#include <chrono>
 
 extern "C" {
     #include <unistd.h>
@@ -42,10 +44,13 @@ extern "C" {
     #include <linux/uinput.h>
     #include <sys/stat.h>
     #include <stdlib.h>
+    #include <getopt.h>
+    #include <poll.h>
 }
 
 #include "SystemError.hpp"
 #include "utils.hpp"
+#include "EventCodes.hpp"
 
 using namespace std;
 
@@ -104,6 +109,27 @@ vector<string> *getLinksTo(const string& target_rel, const string& dirpath) {
     return vec.release();
 }
 
+/**
+ * Print the names of the event types that a device supports.
+ *
+ * @param fd File descriptor of the device.
+ */
+static inline void printEventTypes(int fd) {
+    unsigned long bits[EV_CNT / (8 * sizeof(unsigned long)) + 1] = {0};
+    if (ioctl(fd, EVIOCGBIT(0, sizeof(bits)), bits) < 0)
+        return;
+    cout << "    events:";
+    const size_t nbits = 8 * sizeof(unsigned long);
+    for (int type = 0; type < EV_CNT; type++) {
+        if (!(bits[type / nbits] & (1UL << (type % nbits))))
+            continue;
+        const char *name = EventCodes::typeName(type);
+        if (name)
+            cout << " " << (name + 3);
+    }
+    cout << endl;
+}
+
 using PrintLinkFn = function<void(const string& dir_base,
                                  const string& lnk)>;
 
@@ -122,55 +148,355 @@ static inline void printLinks(const string& path,
     }
 }
 
-int main(int argc, char *argv[]) {
+/** Get the paths of all /dev/input/event* devices, sorted by number. */
+static vector<string> listDevices(const string& devdir) {
+    vector<string> paths;
+    auto dir = shared_ptr<DIR>(opendir(devdir.c_str()), [](DIR *d) {
+                                                            if (d) closedir(d);
+                                                        });
+    if (dir == nullptr)
+        throw SystemError("Unable to open " + devdir + " directory: ", errno);
+
+    struct dirent *entry;
+    while ((entry = readdir(dir.get()))) {
+        string filename(entry->d_name);
+        if (filename.substr(0, 5) != "event")
+            continue;
+        paths.push_back(devdir + "/" + filename);
+    }
+
+    sort(paths.begin(), paths.end(), [](const string& a, const string& b) {
+                                         if (a.size() != b.size())
+                                             return a.size() < b.size();
+                                         return a < b;
+                                     });
+    return paths;
+}
+
+static string deviceName(int fd) {
     char buf[256];
+    int ret = ioctl(fd, EVIOCGNAME(sizeof(buf)), buf);
+    return (ret > 0) ? string(buf, strnlen(buf, ret)) : "unknown";
+}
+
+static constexpr size_t LONG_BITS = 8 * sizeof(unsigned long);
+
+static inline bool testBit(const unsigned long *bits, size_t bit) {
+    return bits[bit / LONG_BITS] & (1UL << (bit % LONG_BITS));
+}
+
+static string jsonEscape(const string& str) {
+    stringstream ss;
+    for (unsigned char c : str) {
+        switch (c) {
+            case '"':  ss << "\\\""; break;
+            case '\\': ss << "\\\\"; break;
+            case '\n': ss << "\\n"; break;
+            case '\t': ss << "\\t"; break;
+            default:
+                if (c < 0x20) {
+                    char esc[8];
+                    snprintf(esc, sizeof(esc), "\\u%04x", c);
+                    ss << esc;
+                } else {
+                    ss << c;
+                }
+        }
+    }
+    return ss.str();
+}
+
+/**
+ * Format a capability bitmap the same way as the capabilities files
+ * in sysfs, i.e as space separated hexadecimal longs, most significant
+ * long first, with leading zero longs removed.
+ */
+static string fmtBitmap(const unsigned long *bits, size_t nlongs) {
+    while (nlongs > 1 && bits[nlongs - 1] == 0)
+        nlongs--;
+    stringstream ss;
+    ss << hex;
+    for (size_t i = nlongs; i-- > 0;)
+        ss << bits[i] << ((i == 0) ? "" : " ");
+    return ss.str();
+}
+
+/** Maximum code of an event type, or 0 if it has no capability bitmap. */
+static int maxCode(int type) {
+    switch (type) {
+        case EV_SYN: return SYN_MAX;
+        case EV_KEY: return KEY_MAX;
+        case EV_REL: return REL_MAX;
+        case EV_ABS: return ABS_MAX;
+        case EV_MSC: return MSC_MAX;
+        case EV_SW:  return SW_MAX;
+        case EV_LED: return LED_MAX;
+        case EV_SND: return SND_MAX;
+        case EV_REP: return REP_MAX;
+        case EV_FF:  return FF_MAX;
+        default:     return 0;
+    }
+}
+
+/**
+ * Print a JSON inventory of all input devices, with the capability
+ * bitmaps of every event type that they support.
+ *
+ * The "maskable" list holds the event types that a consumer only
+ * interested in key events could filter out with EVIOCSMASK.
+ */
+static void printJSON(const vector<string>& paths) {
+    bool first_dev = true;
+    cout << "[";
+    for (const auto& path : paths) {
+        int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC | O_NONBLOCK);
+        if (fd < 0)
+            continue;
+
+        struct input_id id = {};
+        ioctl(fd, EVIOCGID, &id);
+        unsigned long types[EV_CNT / LONG_BITS + 1] = {0};
+        ioctl(fd, EVIOCGBIT(0, sizeof(types)), types);
+
+        cout << (first_dev ? "\n" : ",\n");
+        first_dev = false;
+        cout << "  {\n"
+             << "    \"path\": \"" << jsonEscape(path) << "\",\n"
+             << "    \"name\": \"" << jsonEscape(deviceName(fd)) << "\",\n"
+             << "    \"bustype\": " << id.bustype << ",\n"
+             << "    \"vendor\": " << id.vendor << ",\n"
+             << "    \"product\": " << id.product << ",\n"
+             << "    \"version\": " << id.version << ",\n";
+
+        cout << "    \"links\": [";
+        bool first_lnk = true;
+        auto lnk_fn = [&](const string&, const string& lnk) {
+                          cout << (first_lnk ? "" : ", ") << "\"" << jsonEscape(lnk) << "\"";
+                          first_lnk = false;
+                      };
+        printLinks(path, "/dev/input/by-path", lnk_fn);
+        printLinks(path, "/dev/input/by-id", lnk_fn);
+        cout << "],\n";
+
+        vector<string> maskable;
+        cout << "    \"capabilities\": {";
+        bool first_cap = true;
+        for (int type = 0; type < EV_CNT; type++) {
+            const char *type_name = EventCodes::typeName(type);
+            if (!testBit(types, type) || !type_name)
+                continue;
+            if (type != EV_SYN && type != EV_KEY)
+                maskable.push_back(type_name);
+
+            unsigned long codes[KEY_CNT / LONG_BITS + 1] = {0};
+            size_t nlongs = 0, count = 0;
+            if (int max_code = maxCode(type)) {
+                nlongs = max_code / LONG_BITS + 1;
+                ioctl(fd, EVIOCGBIT(type, nlongs * sizeof(unsigned long)), codes);
+                for (int code = 0; code <= max_code; code++)
+                    count += testBit(codes, code);
+            }
+
+            cout << (first_cap ? "\n" : ",\n");
+            first_cap = false;
+            cout << "      \"" << type_name << "\": {"
+                 << "\"count\": " << count << ", "
+                 << "\"bitmap\": \"" << (nlongs ? fmtBitmap(codes, nlongs) : "") << "\"}";
+        }
+        cout << (first_cap ? "},\n" : "\n    },\n");
+
+        cout << "    \"maskable\": [";
+        for (size_t i = 0; i < maskable.size(); i++)
+            cout << (i ? ", " : "") << "\"" << maskable[i] << "\"";
+        cout << "]\n  }";
+
+        close(fd);
+    }
+    cout << (first_dev ? "]" : "\n]") << endl;
+}
+
+struct MonitoredDevice {
+    string path;
+    string name;
+    int fd;
+    unsigned long counts[EV_CNT];
+    unsigned long total;
+};
+
+/**
+ * Read events from all devices without grabbing them, and print the
+ * number of events per second by event type for every device that
+ * produced events during the last interval.
+ *
+ * Note that events from devices grabbed by another process, e.g by
+ * hawck-inputd, are only delivered to that process, and will not show
+ * up here.
+ *
+ * @param paths Paths of the devices to monitor.
+ * @param interval_ms Length of the reporting interval.
+ */
+static int monitor(const vector<string>& paths, int interval_ms) {
+    using namespace std::chrono;
+    vector<MonitoredDevice> devs;
+    for (const auto& path : paths) {
+        int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC | O_NONBLOCK);
+        if (fd < 0) {
+            cerr << "Unable to open " << path << ": " << strerror(errno) << endl;
+            continue;
+        }
+        devs.push_back({path, deviceName(fd), fd, {0}, 0});
+    }
+    if (devs.empty()) {
+        cerr << "No devices to monitor" << endl;
+        return EXIT_FAILURE;
+    }
+
+    vector<struct pollfd> pfds(devs.size());
+    auto t_start = steady_clock::now();
+    struct input_event evs[64];
+
+    for (;;) {
+        for (size_t i = 0; i < devs.size(); i++) {
+            pfds[i].fd = devs[i].fd;
+            pfds[i].events = POLLIN;
+            pfds[i].revents = 0;
+        }
+
+        auto elapsed = duration_cast<milliseconds>(steady_clock::now() - t_start).count();
+        int timeout = max(0L, (long) interval_ms - (long) elapsed);
+        if (poll(pfds.data(), pfds.size(), timeout) < 0 && errno != EINTR) {
+            cerr << "Error in poll(): " << strerror(errno) << endl;
+            return EXIT_FAILURE;
+        }
+
+        for (size_t i = 0; i < devs.size(); i++) {
+            if (pfds[i].revents & (POLLERR | POLLHUP | POLLNVAL)) {
+                // Device was removed, stop polling it.
+                close(devs[i].fd);
+                devs[i].fd = -1;
+                continue;
+            }
+            if (!(pfds[i].revents & POLLIN))
+                continue;
+            ssize_t n = read(devs[i].fd, evs, sizeof(evs));
+            for (ssize_t j = 0; j < n / (ssize_t) sizeof(evs[0]); j++) {
+                if (evs[j].type < EV_CNT)
+                    devs[i].counts[evs[j].type]++;
+                devs[i].total++;
+            }
+        }
+
+        auto now = steady_clock::now();
+        double secs = duration_cast<microseconds>(now - t_start).count() / 1e6;
+        if (secs * 1000 < interval_ms)
+            continue;
+        t_start = now;
+
+        vector<MonitoredDevice*> active;
+        for (auto& dev : devs)
+            if (dev.total)
+                active.push_back(&dev);
+        sort(active.begin(), active.end(), [](auto *a, auto *b) {
+                                               return a->total > b->total;
+                                           });
+
+        printf("--- %.2fs\n", secs);
+        for (auto *dev : active) {
+            printf("%-10s %8.1f/s ", pathBasename(dev->path).c_str(), dev->total / secs);
+            for (int type = 0; type < EV_CNT; type++) {
+                const char *type_name = EventCodes::typeName(type);
+                if (dev->counts[type] && type_name)
+                    printf(" %s %.1f/s", type_name + 3, dev->counts[type] / secs);
+            }
+            printf("  \"%s\"\n", dev->name.c_str());
+            memset(dev->counts, 0, sizeof(dev->counts));
+            dev->total = 0;
+        }
+        fflush(stdout);
+    }
+}
+
+int main(int argc, char *argv[]) {
     int c;
     bool small = false;
+    bool json = false;
+    bool mon = false;
+    int interval_ms = 1000;
 
-    while ((c = getopt(argc, argv, "hvs")) != -1)
+    static const struct option long_opts[] = {
+        {"help",     no_argument,       nullptr, 'h'},
+        {"version",  no_argument,       nullptr, 'v'},
+        {"small",    no_argument,       nullptr, 's'},
+        {"json",     no_argument,       nullptr, 'j'},
+        {"monitor",  no_argument,       nullptr, 'm'},
+        {"interval", required_argument, nullptr, 'i'},
+        {nullptr,    0,                 nullptr, 0},
+    };
+
+    while ((c = getopt_long(argc, argv, "hvsjmi:", long_opts, nullptr)) != -1)
         switch (c) {
             case 'h':
                 cout <<
-                    "Usage: lsinput [-hvs]\n"
+                    "Usage: lsinput [-hvsjm] [-i <ms>]\n"
                     "\n"
                     "Options:\n"
-                    "  -h    Display this help info.\n"
-                    "  -v    Display version.\n"
-                    "  -s    Print each input device on a single line, easier for\n"
-                    "        stream editors like awk and sed to deal with.\n";
+                    "  -h, --help        Display this help info.\n"
+                    "  -v, --version     Display version.\n"
+                    "  -s, --small       Print each input device on a single line, easier for\n"
+                    "                    stream editors like awk and sed to deal with.\n"
+                    "  -j, --json        Print a JSON inventory of the devices, including\n"
+                    "                    their capability bitmaps.\n"
+                    "  -m, --monitor     Print the number of events per second from each\n"
+                    "                    device, by event type. Devices are not grabbed, so\n"
+                    "                    events from devices grabbed by another process are\n"
+                    "                    not seen.\n"
+                    "  -i, --interval    Monitor reporting interval in milliseconds.\n";
                 return EXIT_SUCCESS;
             case 'v':
-                printf("lsinput v0.1\n");
+                printf("lsinput v0.2\n");
                 return EXIT_SUCCESS;
             case 's':
                 small = true;
                 break;
+            case 'j':
+                json = true;
+                break;
+            case 'm':
+                mon = true;
+                break;
+            case 'i':
+                interval_ms = atoi(optarg);
+                if (interval_ms <= 0) {
+                    cerr << "Invalid interval: " << optarg << endl;
+                    return EXIT_FAILURE;
+                }
+                break;
+            default:
+                return EXIT_FAILURE;
         }
 
-    string devdir = "/dev/input";
-    DIR *dir = opendir(devdir.c_str());
-    if (dir == nullptr) {
-        cout << "Unable to open /dev/input directory" << endl;
+    vector<string> paths;
+    try {
+        paths = listDevices("/dev/input");
+    } catch (const SystemError &e) {
+        cout << e.what() << endl;
         return EXIT_FAILURE;
     }
 
-    struct dirent *entry;
-    while ((entry = readdir(dir))) {
-        int fd, ret;
-        string filename(entry->d_name);
-        try {
-            if (filename.substr(0, 5) != "event")
-                continue;
-        } catch (out_of_range &e) {
-            continue;
-        }
-        string path = devdir + "/" + filename;
-        fd = open(path.c_str(), O_RDWR | O_CLOEXEC | O_NONBLOCK);
+    if (mon)
+        return monitor(paths, interval_ms);
+
+    if (json) {
+        printJSON(paths);
+        return EXIT_SUCCESS;
+    }
+
+    for (const auto& path : paths) {
+        int fd = open(path.c_str(), O_RDWR | O_CLOEXEC | O_NONBLOCK);
         if (fd < 0)
             continue;
 
-        ret = ioctl(fd, EVIOCGNAME(sizeof(buf)), buf);
-        string name(ret > 0 ? buf : "unknown");
+        string name = deviceName(fd);
 
         PrintLinkFn fn;
         if (small) {
@@ -183,6 +509,7 @@ int main(int argc, char *argv[]) {
             fn = [](const string& dir, const string& lnk) {
                      cout << "    " << dir << ": " << pathBasename(lnk) << endl;
                  };
+            printEventTypes(fd);
         }
 
         printLinks(path, "/dev/input/by-path", fn);
@@ -194,7 +521,5 @@ int main(int argc, char *argv[]) {
         close(fd);
     }
 
-    closedir(dir);
-
     return 0;
 }
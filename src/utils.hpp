@@ -118,3 +118,18 @@ inline std::string pathBasename(const std::string& path) {
         return std::string("");
     return std::string(bn);
 }
+
+/**
+ * Get the directory part of a path.
+ *
+ * @param path The path to get the directory of.
+ * @return Everything before the last '/', or "." if there is none.
+ */
+inline std::string pathDirname(const std::string& path) {
+    size_t pos = path.rfind('/');
+    if (pos == std::string::npos)
+        return std::string(".");
+    if (pos == 0)
+        return std::string("/");
+    return path.substr(0, pos);
+}
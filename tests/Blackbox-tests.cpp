@@ -0,0 +1,63 @@
+#include <catch2/catch.hpp>
+#include <string>
+#include "Blackbox.hpp"
+
+extern "C" {
+    #include <stdlib.h>
+    #include <unistd.h>
+}
+
+using namespace std;
+
+TEST_CASE("Black box keeps the last seconds", "[blackbox]") {
+    char path[] = "/tmp/hawck-blackbox-XXXXXX";
+    int fd = mkstemp(path);
+    REQUIRE( fd != -1 );
+    close(fd);
+
+    int64_t t = time(nullptr);
+    {
+        Blackbox bb;
+        bb.open(path, 4);
+        bb.tick(t);
+        for (int i = 1; i <= 6; i++) {
+            bb.add(Blackbox::EVENTS, i);
+            bb.latency(100);
+            bb.gauge(Blackbox::QUEUE, i);
+            bb.tick(t + i);
+        }
+        // Idle seconds are not recorded.
+        bb.tick(t + 7);
+    }
+
+    auto recs = Blackbox::read(path);
+    REQUIRE( recs.size() == 4 );
+    for (size_t i = 0; i < recs.size(); i++) {
+        REQUIRE( recs[i].num_events == i + 3 );
+        REQUIRE( recs[i].max_queue == i + 3 );
+        REQUIRE( recs[i].lat_max_us == 100 );
+        REQUIRE( recs[i].lat_p50_us >= 100 );
+    }
+    REQUIRE( recs.back().time == t + 5 );
+
+    // Reopening keeps the records, and appends to them.
+    {
+        Blackbox bb;
+        bb.open(path, 4);
+        bb.add(Blackbox::HOTPLUG);
+        bb.tick(t + 100);
+    }
+    recs = Blackbox::read(path);
+    REQUIRE( recs.size() == 4 );
+    REQUIRE( recs.back().num_hotplug == 1 );
+    REQUIRE( recs.back().num_events == 0 );
+
+    // A ring with another capacity is cleared.
+    {
+        Blackbox bb;
+        bb.open(path, 8);
+    }
+    REQUIRE( Blackbox::read(path).empty() );
+
+    unlink(path);
+}
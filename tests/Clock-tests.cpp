@@ -0,0 +1,44 @@
+#include <catch2/catch.hpp>
+#include <atomic>
+#include <thread>
+#include "Clock.hpp"
+
+using namespace std;
+using namespace std::chrono;
+
+TEST_CASE("Simulated clock wakes sleepers when advanced", "[clock]") {
+    SimClock clock;
+    auto t0 = clock.now();
+    atomic<bool> woke = false;
+    thread sleeper([&]() {
+        clock.sleepFor(milliseconds(100));
+        woke = true;
+    });
+
+    clock.waitSleepers(1);
+    clock.advance(milliseconds(99));
+    REQUIRE( !woke );
+    clock.advance(milliseconds(1));
+    sleeper.join();
+    REQUIRE( woke );
+    REQUIRE( clock.now() - t0 == milliseconds(100) );
+}
+
+TEST_CASE("Simulated clock runs periodic threads in lock step", "[clock]") {
+    SimClock clock;
+    atomic<int> ticks = 0;
+    atomic<bool> stop = false;
+    thread ticker([&]() {
+        while (!stop) {
+            clock.sleepFor(milliseconds(10));
+            ticks++;
+        }
+    });
+
+    clock.run(milliseconds(1000), milliseconds(10), 1);
+    REQUIRE( ticks == 100 );
+
+    stop = true;
+    clock.release();
+    ticker.join();
+}
@@ -0,0 +1,225 @@
+#include <catch2/catch.hpp>
+#include "EventOrder.hpp"
+
+using namespace std;
+
+/** Time at which events are sent and drained, only pauses look at it. */
+static const auto t0 = chrono::steady_clock::time_point(chrono::hours(1));
+
+static struct input_event key(int code, int value) {
+    struct input_event ev = {};
+    ev.type = EV_KEY;
+    ev.code = code;
+    ev.value = value;
+    return ev;
+}
+
+static struct input_event syn() {
+    struct input_event ev = {};
+    ev.type = EV_SYN;
+    ev.code = SYN_REPORT;
+    return ev;
+}
+
+/** Send every queued passthrough event to MacroD. */
+static void sendAll(EventOrder &order) {
+    struct input_event ev;
+    while (order.takeUnsent(ev, t0));
+}
+
+static vector<int> codes(const vector<struct input_event> &evs) {
+    vector<int> out;
+    for (const auto &ev : evs)
+        if (ev.type == EV_KEY)
+            out.push_back(ev.code);
+    return out;
+}
+
+TEST_CASE("Strict order holds everything behind MacroD", "[order]") {
+    EventOrder order(OrderPolicy::STRICT);
+    vector<struct input_event> out;
+
+    REQUIRE( order.push(key(KEY_A, 1), false) );
+    REQUIRE( !order.push(key(KEY_F13, 1), true) );
+    REQUIRE( !order.push(syn(), false) );
+    REQUIRE( !order.push(key(KEY_B, 1), false) );
+    REQUIRE( order.hasPending() );
+
+    order.drain(out, t0);
+    REQUIRE( out.empty() );
+
+    sendAll(order);
+    order.reply(key(KEY_X, 1));
+    order.reply(key(KEY_X, 0));
+    order.done();
+    order.drain(out, t0);
+    REQUIRE( codes(out) == vector<int>({KEY_X, KEY_X, KEY_B}) );
+    REQUIRE( !order.hasPending() );
+}
+
+TEST_CASE("Fast lane lets independent keys through", "[order]") {
+    EventOrder order(OrderPolicy::FASTLANE);
+    vector<struct input_event> out;
+
+    REQUIRE( !order.push(key(KEY_F13, 1), true) );
+    REQUIRE( !order.push(syn(), false) );
+    // Unrelated key, and the SYN_REPORT that follows it.
+    REQUIRE( order.push(key(KEY_B, 1), false) );
+    REQUIRE( order.push(syn(), false) );
+    // Release of the key that MacroD is handling.
+    REQUIRE( !order.push(key(KEY_F13, 0), false) );
+
+    sendAll(order);
+    order.done();
+    order.drain(out, t0);
+    REQUIRE( out.size() == 2 );
+    REQUIRE( out[0].type == EV_SYN );
+    REQUIRE( codes(out) == vector<int>({KEY_F13}) );
+}
+
+TEST_CASE("Fast lane only compares codes of the same type", "[order]") {
+    EventOrder order(OrderPolicy::FASTLANE);
+
+    struct input_event scan = {};
+    scan.type = EV_MSC;
+    scan.code = MSC_SCAN;
+    REQUIRE( !order.push(key(KEY_F13, 1), true) );
+    REQUIRE( !order.push(scan, false) );
+    REQUIRE( !order.push(syn(), false) );
+    // Same numeric codes as the queued MSC_SCAN and SYN_REPORT.
+    static_assert(MSC_SCAN == KEY_3 && SYN_REPORT == KEY_RESERVED);
+    REQUIRE( order.push(key(KEY_3, 1), false) );
+    REQUIRE( order.push(key(KEY_RESERVED, 1), false) );
+}
+
+TEST_CASE("Fast lane holds keys that share modifier state", "[order]") {
+    EventOrder order(OrderPolicy::FASTLANE);
+    vector<struct input_event> out;
+
+    REQUIRE( order.push(key(KEY_LEFTCTRL, 1), false) );
+    REQUIRE( !order.push(key(KEY_X, 1), true) );
+    // ctrl+c depends on what the ctrl+x macro does.
+    REQUIRE( !order.push(key(KEY_C, 1), false) );
+    // Releasing ctrl must wait too.
+    REQUIRE( !order.push(key(KEY_LEFTCTRL, 0), false) );
+    // No modifiers are held anymore, but the key is still queued.
+    REQUIRE( !order.push(key(KEY_C, 0), false) );
+    // Would turn into ctrl+d if it overtook the ctrl release.
+    REQUIRE( !order.push(key(KEY_D, 1), false) );
+
+    sendAll(order);
+    order.done();
+    order.drain(out, t0);
+    REQUIRE( codes(out) == vector<int>({KEY_C, KEY_LEFTCTRL, KEY_C, KEY_D}) );
+    REQUIRE( order.push(key(KEY_D, 0), false) );
+}
+
+TEST_CASE("Aborting emits the original events", "[order]") {
+    EventOrder order(OrderPolicy::STRICT);
+    vector<struct input_event> out;
+
+    REQUIRE( !order.push(key(KEY_F13, 1), true) );
+    REQUIRE( !order.push(key(KEY_F14, 1), true) );
+    sendAll(order);
+    order.reply(key(KEY_X, 1));
+    order.abort(out);
+    REQUIRE( codes(out) == vector<int>({KEY_F13, KEY_F14}) );
+    REQUIRE( !order.hasPending() );
+}
+
+TEST_CASE("Stale repeats are shed while MacroD is behind", "[order]") {
+    EventOrder order(OrderPolicy::STRICT);
+    vector<struct input_event> out;
+    struct input_event ev;
+
+    REQUIRE( !order.push(key(KEY_F13, 1), true) );
+    REQUIRE( order.takeUnsent(ev, t0) );
+    order.setLagging(true);
+
+    // The first repeat is queued, later ones collapse into it.
+    REQUIRE( !order.shed(key(KEY_F13, 2)) );
+    REQUIRE( !order.push(key(KEY_F13, 2), true) );
+    REQUIRE( !order.shed(syn()) );
+    REQUIRE( !order.push(syn(), false) );
+    for (int i = 0; i < 10; i++) {
+        REQUIRE( order.shed(key(KEY_F13, 2)) );
+        REQUIRE( order.shed(syn()) );
+    }
+    REQUIRE( order.numCollapsed() == 10 );
+
+    // Typed keys keep their place behind the backlog.
+    REQUIRE( !order.shed(key(KEY_B, 1)) );
+    REQUIRE( !order.push(key(KEY_B, 1), false) );
+
+    // The release removes the repeat that was never sent.
+    REQUIRE( !order.shed(key(KEY_F13, 0)) );
+    REQUIRE( !order.push(key(KEY_F13, 0), true) );
+    REQUIRE( order.numStale() == 1 );
+    REQUIRE( order.numInflight() == 1 );
+
+    order.setLagging(false);
+    order.done();
+    REQUIRE( order.takeUnsent(ev, t0) );
+    REQUIRE( ev.value == 0 );
+    order.done();
+    order.drain(out, t0);
+    REQUIRE( codes(out) == vector<int>({KEY_B}) );
+    REQUIRE( !order.hasPending() );
+}
+
+TEST_CASE("Aborting after a pause does not emit the original event", "[order]") {
+    EventOrder order(OrderPolicy::STRICT);
+    vector<struct input_event> out;
+
+    REQUIRE( !order.push(key(KEY_F13, 1), true) );
+    REQUIRE( !order.push(key(KEY_F14, 1), true) );
+    sendAll(order);
+    order.reply(key(KEY_X, 1));
+    order.pause(chrono::seconds(1));
+    order.reply(key(KEY_X, 0));
+    order.drain(out, t0);
+    REQUIRE( codes(out) == vector<int>({KEY_X}) );
+
+    // The first slot keeps the rest of its reply without waiting for
+    // the pause, the second one has not emitted anything and falls
+    // back to its key.
+    out.clear();
+    order.abort(out);
+    REQUIRE( codes(out) == vector<int>({KEY_X, KEY_F14}) );
+    REQUIRE( out[0].value == 0 );
+    REQUIRE( order.empty() );
+}
+
+TEST_CASE("Paused replies are emitted a part at a time", "[order]") {
+    EventOrder order(OrderPolicy::STRICT);
+    vector<struct input_event> out;
+    auto ms = [](int n) { return t0 + chrono::milliseconds(n); };
+
+    REQUIRE( !order.push(key(KEY_F13, 1), true) );
+    REQUIRE( !order.push(key(KEY_F14, 1), true) );
+    REQUIRE( !order.push(key(KEY_B, 1), false) );
+    sendAll(order);
+
+    // The pause is in the reply to the second key, which waits for
+    // the first.
+    order.reply(key(KEY_X, 1));
+    order.done();
+    order.reply(key(KEY_Y, 1));
+    order.pause(chrono::milliseconds(50));
+    order.reply(key(KEY_Z, 1));
+    order.drain(out, ms(0));
+    REQUIRE( codes(out) == vector<int>({KEY_X, KEY_Y}) );
+    REQUIRE( order.pausedUntil() == ms(50) );
+
+    // Done, but the rest of the reply and KEY_B wait for the pause.
+    out.clear();
+    order.done();
+    REQUIRE( !order.hasPending() );
+    order.drain(out, ms(49));
+    REQUIRE( out.empty() );
+
+    order.drain(out, ms(50));
+    REQUIRE( codes(out) == vector<int>({KEY_Z, KEY_B}) );
+    REQUIRE( order.empty() );
+    REQUIRE( order.pausedUntil() == chrono::steady_clock::time_point::max() );
+}
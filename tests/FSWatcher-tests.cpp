@@ -1,4 +1,6 @@
 #include <iostream>
+#include <algorithm>
+#include <mutex>
 
 #include <catch2/catch.hpp>
 #include "FSWatcher.hpp"
@@ -150,9 +152,66 @@ TEST_CASE("Watch whole directory", "[FSWatcher]") {
     vector<string> paths = mkTestFiles(num_tests, true);
     FSWatcher watcher;
     vector<FSEvent> *added = watcher.addFrom("/tmp/hwk-tests");
-    REQUIRE(added->size() == num_tests);
+    REQUIRE(added->size() == (size_t) num_tests);
     delete added;
     vector<string> cmds = mkModCMDs(paths);
     runTestsCMD(&watcher, paths, cmds);
 }
 #endif
+
+// Test FSWatcher::rescan, which is what happens on IN_Q_OVERFLOW
+TEST_CASE("Rescan after missed events", "[FSWatcher]") {
+    vector<string> paths = mkTestFiles(3, true);
+    FSWatcher watcher;
+    delete watcher.addFrom("/tmp/hwk-tests");
+
+    // Change the directory before the watcher gets a chance to see it.
+    system_s("echo 'test line' >> '" + paths[0] + "'");
+    system_s("rm '" + paths[1] + "'");
+    system_s("touch /tmp/hwk-tests/new.txt.test");
+    watcher.rescan();
+
+    mutex mtx;
+    vector<pair<uint32_t, string>> got;
+    watcher.begin([&](FSEvent &ev) {
+                      if (ev.rescanned) {
+                          lock_guard<mutex> lock(mtx);
+                          got.push_back({ev.mask, ev.path});
+                      }
+                      return true;
+                  });
+    for (int i = 0; i < 100 && watcher.isRunning(); i++) {
+        usleep(10000);
+        lock_guard<mutex> lock(mtx);
+        if (got.size() >= 3)
+            break;
+    }
+    watcher.stop();
+
+    sort(got.begin(), got.end());
+    vector<pair<uint32_t, string>> expect = {
+        {IN_MODIFY, paths[0]},
+        {IN_CREATE, "/tmp/hwk-tests/new.txt.test"},
+        {IN_DELETE_SELF, paths[1]},
+    };
+    sort(expect.begin(), expect.end());
+    REQUIRE(got == expect);
+}
+
+// Test that files renamed into a directory are picked up
+TEST_CASE("Directory file move", "[FSWatcher]") {
+    vector<string> paths = mkTestFiles(10, false);
+    system_s("mkdir -p /tmp/hwk-tests/src");
+    FSWatcher watcher;
+    watcher.add("/tmp/hwk-tests");
+    vector<string> cmds;
+    for (const string& path : paths)
+        cmds.push_back("touch /tmp/hwk-tests/src/f && mv /tmp/hwk-tests/src/f '" + path + "'");
+    // Modifying the moved files should also be reported.
+    for (string cmd : mkModCMDs(paths))
+        cmds.push_back(cmd);
+    vector<string> paths_cpy = paths;
+    for (auto path : paths_cpy)
+        paths.push_back(path);
+    runTestsCMD(&watcher, paths, cmds);
+}
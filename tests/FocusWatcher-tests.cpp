@@ -0,0 +1,82 @@
+#include <iostream>
+
+#include <catch2/catch.hpp>
+#include "FocusWatcher.hpp"
+
+extern "C" {
+    #include <unistd.h>
+    #include <stdlib.h>
+    #include <X11/Xlib.h>
+    #include <X11/Xutil.h>
+    #include <X11/Xatom.h>
+}
+
+using namespace std;
+
+/** Pretend to be a window manager and give focus to `win`. */
+static void setActiveWindow(Display *dpy, Window win) {
+    Atom active = XInternAtom(dpy, "_NET_ACTIVE_WINDOW", False);
+    XChangeProperty(dpy, DefaultRootWindow(dpy), active, XA_WINDOW, 32,
+                    PropModeReplace, (unsigned char *) &win, 1);
+    XFlush(dpy);
+}
+
+static Window mkWindow(Display *dpy, const char *cls) {
+    Window win = XCreateSimpleWindow(dpy, DefaultRootWindow(dpy),
+                                     0, 0, 10, 10, 0, 0, 0);
+    XClassHint hint;
+    hint.res_name = (char *) "hawck-test";
+    hint.res_class = (char *) cls;
+    XSetClassHint(dpy, win, &hint);
+    XFlush(dpy);
+    return win;
+}
+
+static bool waitForFocus(FocusWatcher &fw, int id) {
+    const int MAX_SLEEPS = 200;
+    for (int i = 0; i < MAX_SLEEPS && fw.current() != id; i++)
+        usleep(10000);
+    return fw.current() == id;
+}
+
+/**
+ * Run with a display, e.g `xvfb-run ./hawck-tests`.
+ */
+TEST_CASE("Focus changes", "[FocusWatcher]") {
+    if (!getenv("DISPLAY")) {
+        WARN("No DISPLAY, skipping focus tests");
+        return;
+    }
+
+    Display *dpy = XOpenDisplay(nullptr);
+    REQUIRE(dpy != nullptr);
+
+    Window a = mkWindow(dpy, "HwkTestA");
+    Window b = mkWindow(dpy, "HwkTestB");
+
+    FocusWatcher fw;
+    int id_a = fw.intern("hwktesta");
+    int id_b = fw.intern("HWKTESTB");
+    REQUIRE(id_a != id_b);
+    REQUIRE(fw.intern("HwkTestA") == id_a);
+
+    REQUIRE(fw.begin());
+
+    setActiveWindow(dpy, a);
+    REQUIRE(waitForFocus(fw, id_a));
+
+    setActiveWindow(dpy, b);
+    REQUIRE(waitForFocus(fw, id_b));
+
+    setActiveWindow(dpy, None);
+    REQUIRE(waitForFocus(fw, FOCUS_NONE));
+
+    // Focus on a window that has since been destroyed.
+    XDestroyWindow(dpy, a);
+    setActiveWindow(dpy, a);
+    REQUIRE(waitForFocus(fw, FOCUS_NONE));
+
+    fw.stop();
+    XDestroyWindow(dpy, b);
+    XCloseDisplay(dpy);
+}
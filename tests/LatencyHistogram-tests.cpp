@@ -0,0 +1,20 @@
+#include <catch2/catch.hpp>
+#include "LatencyHistogram.hpp"
+
+TEST_CASE("Latency histogram quantiles", "[latency]") {
+    LatencyHistogram hist;
+    REQUIRE( hist.quantile(0.5) == 0 );
+
+    for (int i = 0; i < 98; i++)
+        hist.add(10);
+    hist.add(1000);
+    hist.add(5000);
+
+    REQUIRE( hist.total() == 100 );
+    REQUIRE( hist.max() == 5000 );
+    // 10µs is in [8, 16)
+    REQUIRE( hist.quantile(0.5) == 16 );
+    REQUIRE( hist.quantile(0.98) == 1024 );
+    REQUIRE( hist.quantile(0.99) == 8192 );
+    REQUIRE( hist.summary() == "n=100 p50<=16us p99<=8192us max=5000us" );
+}
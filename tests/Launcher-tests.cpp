@@ -0,0 +1,77 @@
+#include <catch2/catch.hpp>
+#include <string>
+#include <fstream>
+#include <thread>
+#include "Launcher.hpp"
+
+extern "C" {
+    #include <stdlib.h>
+    #include <unistd.h>
+    #include <sys/stat.h>
+}
+
+using namespace std;
+
+/** Wait up to `ms` milliseconds for `cond` to become true. */
+template <class F>
+static bool waitFor(F cond, int ms = 3000) {
+    for (int i = 0; i < ms / 10; i++) {
+        if (cond())
+            return true;
+        this_thread::sleep_for(chrono::milliseconds(10));
+    }
+    return cond();
+}
+
+TEST_CASE("Desktop files are parsed and reparsed after a change", "[launcher]") {
+    string data_home = "/tmp/hawck-launcher-" + to_string(getpid());
+    string apps = data_home + "/applications";
+    string path = apps + "/hawck-test.desktop";
+    mkdir(data_home.c_str(), 0755);
+    mkdir(apps.c_str(), 0755);
+    setenv("XDG_DATA_HOME", data_home.c_str(), 1);
+    ofstream(path) << "[Desktop Entry]\n"
+                      "Name=Test\n"
+                      "Exec=hawck-test %U \n"
+                      "\n"
+                      "[Desktop Action new-window]\n"
+                      "Exec=hawck-test --new-window\n"
+                      "\n"
+                      "[X-Extension]\n"
+                      "Exec=not-the-entry\n";
+
+    {
+        DesktopIndex index;
+        REQUIRE( index.exec("hawck-test", "") == "hawck-test %U" );
+        REQUIRE( index.exec("hawck-test", "new-window") == "hawck-test --new-window" );
+        REQUIRE( index.exec("hawck-test", "X-Extension") == "" );
+        REQUIRE( index.exec("hawck-missing", "") == "" );
+
+        ofstream(path) << "[Desktop Entry]\n"
+                          "Exec=hawck-test --changed\n";
+        REQUIRE( waitFor([&]() {
+                     return index.exec("hawck-test", "") == "hawck-test --changed";
+                 }) );
+        REQUIRE( index.exec("hawck-test", "new-window") == "" );
+    }
+
+    unlink(path.c_str());
+    rmdir(apps.c_str());
+    rmdir(data_home.c_str());
+    unsetenv("XDG_DATA_HOME");
+}
+
+TEST_CASE("Launched commands run and are reaped", "[launcher]") {
+    string out = "/tmp/hawck-launcher-" + to_string(getpid()) + ".out";
+    unlink(out.c_str());
+
+    Launcher launcher;
+    launcher.spawn("echo launched > " + out);
+    REQUIRE( waitFor([&]() { return access(out.c_str(), F_OK) == 0; }) );
+    REQUIRE( waitFor([&]() { return launcher.numChildren() == 0; }) );
+
+    string line;
+    getline(ifstream(out), line);
+    REQUIRE( line == "launched" );
+    unlink(out.c_str());
+}
@@ -0,0 +1,101 @@
+#include <catch2/catch.hpp>
+#include <thread>
+#include <vector>
+#include "MacroRecorder.hpp"
+#include "RemoteUDevice.hpp"
+#include "EventOrder.hpp"
+
+extern "C" {
+    #include <sys/socket.h>
+}
+
+using namespace std;
+using namespace std::chrono;
+
+struct Emitted {
+    int code;
+    int value;
+    steady_clock::time_point t;
+};
+
+/** Feed the replies to a single key through an EventOrder like InputD
+ *  does, and note when each event would be written to uinput. */
+static vector<Emitted> receiveReply(UNIXSocket<KBDAction> &com) {
+    EventOrder order;
+    input_event key;
+    memset(&key, 0, sizeof(key));
+    key.type = EV_KEY;
+    key.code = KEY_F1;
+    key.value = 1;
+    order.push(key, true);
+    order.takeUnsent(key, steady_clock::now());
+
+    vector<Emitted> emitted;
+    KBDAction buf[64];
+    while (!order.empty()) {
+        if (order.hasPending()) {
+            size_t n = com.recvMany(buf, 64, milliseconds(2000));
+            for (size_t i = 0; i < n; i++) {
+                if (buf[i].done)
+                    order.done();
+                else if (buf[i].pause)
+                    order.pause(microseconds(buf[i].ev.value));
+                else
+                    order.reply(buf[i].ev);
+            }
+        } else {
+            this_thread::sleep_until(order.pausedUntil());
+        }
+        vector<input_event> evs;
+        auto now = steady_clock::now();
+        order.drain(evs, now);
+        for (auto &ev : evs)
+            emitted.push_back({ev.code, ev.value, now});
+    }
+    return emitted;
+}
+
+TEST_CASE("Timed playback keeps the pauses at uinput", "[macro]") {
+    int fds[2];
+    REQUIRE( socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0 );
+    UNIXSocket<KBDAction> a(fds[0]), b(fds[1]);
+    RemoteUDevice udev(&a);
+    MacroRecorder rec(&udev);
+    udev.setRecorder(&rec);
+
+    // Record a and b 40ms apart, InputD is not listening yet.
+    udev.setConnection(nullptr);
+    rec.record("ab");
+    udev.emit(EV_KEY, KEY_A, 1);
+    udev.emit(EV_KEY, KEY_A, 0);
+    this_thread::sleep_for(milliseconds(40));
+    udev.emit(EV_KEY, KEY_B, 1);
+    udev.emit(EV_KEY, KEY_B, 0);
+    REQUIRE( rec.stop() == 4 );
+    udev.setConnection(&a);
+
+    SECTION("Timed") {
+        // MacroD does not wait for the pauses.
+        auto start = steady_clock::now();
+        rec.playTimed("ab");
+        udev.done();
+        REQUIRE( steady_clock::now() - start < milliseconds(20) );
+        auto emitted = receiveReply(b);
+
+        REQUIRE( emitted.size() == 4 );
+        REQUIRE( emitted[0].code == KEY_A );
+        REQUIRE( emitted[2].code == KEY_B );
+        auto gap = duration_cast<milliseconds>(emitted[2].t - emitted[1].t).count();
+        REQUIRE( gap >= 35 );
+        REQUIRE( gap < 200 );
+    }
+
+    SECTION("Untimed") {
+        rec.play("ab");
+        udev.done();
+        auto emitted = receiveReply(b);
+
+        REQUIRE( emitted.size() == 4 );
+        REQUIRE( emitted[3].t == emitted[0].t );
+    }
+}
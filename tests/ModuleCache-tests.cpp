@@ -0,0 +1,61 @@
+#include <catch2/catch.hpp>
+#include <string>
+#include <fstream>
+#include "ModuleCache.hpp"
+#include "SystemError.hpp"
+
+extern "C" {
+    #include <stdint.h>
+    #include <stdio.h>
+    #include <unistd.h>
+}
+
+using namespace std;
+
+static uint32_t fnv1a(const string &s) {
+    uint32_t h = 2166136261u;
+    for (char c : s) {
+        h ^= (uint8_t) c;
+        h *= 16777619u;
+    }
+    return h;
+}
+
+TEST_CASE("Module cache serves chunks with unchanged sources", "[modulecache]") {
+    string dir = "/tmp/hawck-modcache-" + to_string(getpid());
+    string src_a = dir + ".a.lua", src_b = dir + ".b.lua", cache_path = dir + ".cache";
+    ofstream(src_a) << "return 1";
+    ofstream(src_b) << "return 2";
+
+    char hash_a[16], hash_b[16];
+    snprintf(hash_a, sizeof(hash_a), "%08x", fnv1a("return 1"));
+    // Written for an older version of b.
+    snprintf(hash_b, sizeof(hash_b), "%08x", fnv1a("return 3"));
+    ofstream(cache_path) << "HWKCACHE 1\n"
+                         << "a 0 5 " << hash_a << " " << src_a << "\n"
+                         << "b 5 3 " << hash_b << " " << src_b << "\n"
+                         << "\n"
+                         << "AAAAABBB";
+
+    ModuleCache cache;
+    cache.open(cache_path);
+    REQUIRE( cache.size() == 1 );
+    REQUIRE( cache.find("a") == "AAAAA" );
+    REQUIRE( cache.find("b").empty() );
+    REQUIRE( cache.find("c").empty() );
+
+    // Caches are replaced by renaming, never rewritten in place.
+    string bad_path = dir + ".bad";
+    ofstream(bad_path) << "HWKCACHE 1\n"
+                       << "a 0 50 " << hash_a << " " << src_a << "\n"
+                       << "\n"
+                       << "AAAAA";
+    REQUIRE_THROWS_AS( cache.open(bad_path), SystemError );
+    // A failed open keeps the old chunks.
+    REQUIRE( cache.find("a") == "AAAAA" );
+
+    unlink(src_a.c_str());
+    unlink(src_b.c_str());
+    unlink(cache_path.c_str());
+    unlink(bad_path.c_str());
+}
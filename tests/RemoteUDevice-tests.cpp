@@ -0,0 +1,52 @@
+#include <catch2/catch.hpp>
+#include <vector>
+#include "RemoteUDevice.hpp"
+#include "SystemError.hpp"
+
+extern "C" {
+    #include <sys/socket.h>
+}
+
+using namespace std;
+
+/** Backend that fails to flush whatever it was given. */
+class BrokenUDevice : public IUDevice {
+public:
+    int flushes = 0;
+
+    virtual void emit(const input_event *) override {}
+    virtual void emit(int, int, int) override {}
+    virtual void done() override {}
+    virtual void flush() override {
+        flushes++;
+        throw SystemError("Lost connection to the display");
+    }
+};
+
+TEST_CASE("Events are sent to InputD when the backend fails", "[udevice]") {
+    int fds[2];
+    REQUIRE( socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0 );
+    UNIXSocket<KBDAction> a(fds[0]), b(fds[1]);
+    RemoteUDevice udev(&a);
+    BrokenUDevice broken;
+    udev.setBackend(&broken);
+
+    udev.emit(EV_KEY, KEY_A, 1);
+    udev.emit(EV_KEY, KEY_A, 0);
+    udev.done();
+    REQUIRE( broken.flushes == 1 );
+
+    KBDAction buf[8];
+    REQUIRE( b.recvMany(buf, 8, chrono::milliseconds(1000)) == 3 );
+    REQUIRE( buf[0].ev.code == KEY_A );
+    REQUIRE( buf[0].ev.value == 1 );
+    REQUIRE( buf[1].ev.value == 0 );
+    REQUIRE( buf[2].done );
+
+    // The backend is not used again.
+    udev.emit(EV_KEY, KEY_B, 1);
+    udev.done();
+    REQUIRE( broken.flushes == 1 );
+    REQUIRE( b.recvMany(buf, 8, chrono::milliseconds(1000)) == 2 );
+    REQUIRE( buf[0].ev.code == KEY_B );
+}
@@ -0,0 +1,61 @@
+#include <catch2/catch.hpp>
+#include <thread>
+#include "SharedState.hpp"
+#include "SystemError.hpp"
+
+using namespace std;
+
+TEST_CASE("Shared state stores typed values", "[state]") {
+    SharedState st;
+    REQUIRE( st.get("mode").type == SharedState::Type::NIL );
+
+    st.set("vim", SharedState::Value::boolean(true));
+    st.set("count", SharedState::Value::integer(-42));
+    st.set("layer", SharedState::Value::string("navigation"));
+
+    REQUIRE( st.get("vim") == SharedState::Value::boolean(true) );
+    REQUIRE( st.get("count").i == -42 );
+    REQUIRE( st.get("layer").str() == "navigation" );
+
+    st.set("vim", SharedState::Value());
+    REQUIRE( st.get("vim").type == SharedState::Type::NIL );
+
+    REQUIRE_THROWS_AS( st.set("layer", SharedState::Value::string(string(25, 'x'))),
+                       SystemError );
+    REQUIRE_THROWS_AS( st.set(string(32, 'k'), SharedState::Value::integer(1)),
+                       SystemError );
+}
+
+TEST_CASE("Shared state counts changes", "[state]") {
+    SharedState st;
+    REQUIRE( st.version("a") == 0 );
+
+    st.set("a", SharedState::Value::integer(1));
+    uint64_t gen = st.generation();
+    REQUIRE( st.version("a") == 1 );
+
+    // Setting the same value is not a change.
+    st.set("a", SharedState::Value::integer(1));
+    REQUIRE( st.version("a") == 1 );
+    REQUIRE( st.generation() == gen );
+
+    st.set("a", SharedState::Value::string("1"));
+    REQUIRE( st.version("a") == 2 );
+    REQUIRE( st.generation() == gen + 1 );
+}
+
+TEST_CASE("Shared state readers see whole values", "[state]") {
+    SharedState st;
+    st.set("s", SharedState::Value::string("aaaaaaaaaaaaaaaaaaaaaaaa"));
+
+    thread writer([&]() {
+        for (int i = 0; i < 20000; i++)
+            st.set("s", SharedState::Value::string(string(24, (i & 1) ? 'b' : 'a')));
+    });
+    for (int i = 0; i < 20000; i++) {
+        auto s = st.get("s").str();
+        REQUIRE( s.size() == 24 );
+        REQUIRE( s.find_first_not_of(s[0]) == string_view::npos );
+    }
+    writer.join();
+}
@@ -0,0 +1,37 @@
+#include <catch2/catch.hpp>
+#include "TokenBucket.hpp"
+
+using namespace std;
+using namespace std::chrono;
+
+TEST_CASE("Token bucket allows bursts", "[ratelimit]") {
+    auto t = TokenBucket::SteadyClock::now();
+    TokenBucket bucket(10, 5, t);
+
+    for (int i = 0; i < 5; i++)
+        REQUIRE( bucket.take(1, t) );
+    REQUIRE( !bucket.take(1, t) );
+    REQUIRE( bucket.wait(1, t) == duration_cast<TokenBucket::SteadyClock::duration>(milliseconds(100)) );
+}
+
+TEST_CASE("Token bucket refills at its rate", "[ratelimit]") {
+    auto t = TokenBucket::SteadyClock::now();
+    TokenBucket bucket(10, 5, t);
+
+    for (int i = 0; i < 5; i++)
+        bucket.take(1, t);
+    REQUIRE( bucket.take(1, t + milliseconds(100)) );
+    REQUIRE( !bucket.take(1, t + milliseconds(150)) );
+    // Refills never go beyond the burst size.
+    for (int i = 0; i < 5; i++)
+        REQUIRE( bucket.take(1, t + seconds(10)) );
+    REQUIRE( !bucket.take(1, t + seconds(10)) );
+}
+
+TEST_CASE("Token bucket without a rate is unlimited", "[ratelimit]") {
+    auto t = TokenBucket::SteadyClock::now();
+    TokenBucket bucket(0, 0, t);
+    for (int i = 0; i < 1000; i++)
+        REQUIRE( bucket.take(1, t) );
+    REQUIRE( bucket.wait(1, t) == TokenBucket::SteadyClock::duration::zero() );
+}
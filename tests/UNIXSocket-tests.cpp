@@ -0,0 +1,71 @@
+#include <catch2/catch.hpp>
+#include <thread>
+#include <vector>
+#include "UNIXSocket.hpp"
+#include "KBDAction.hpp"
+
+extern "C" {
+    #include <sys/socket.h>
+}
+
+using namespace std;
+
+static KBDAction key(int code, int done = 0) {
+    KBDAction ac;
+    memset(&ac, 0, sizeof(ac));
+    ac.ev.type = EV_KEY;
+    ac.ev.code = code;
+    ac.done = done;
+    return ac;
+}
+
+TEST_CASE("Packets sent together are received together", "[socket]") {
+    int fds[2];
+    REQUIRE( socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0 );
+    UNIXSocket<KBDAction> a(fds[0]), b(fds[1]);
+
+    a.send(vector<KBDAction>{key(30), key(31), key(0, 1)});
+    KBDAction buf[8];
+    REQUIRE( b.recvMany(buf, 8) == 3 );
+    REQUIRE( buf[0].ev.code == 30 );
+    REQUIRE( buf[1].ev.code == 31 );
+    REQUIRE( buf[2].done );
+
+    // Packets beyond the buffer are left for the next call.
+    a.send(vector<KBDAction>{key(1), key(2), key(3)});
+    REQUIRE( b.recvMany(buf, 2) == 2 );
+    REQUIRE( b.recvMany(buf, 2) == 1 );
+    REQUIRE( buf[0].ev.code == 3 );
+}
+
+TEST_CASE("Packets cut off by the sender are completed", "[socket]") {
+    int fds[2];
+    REQUIRE( socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0 );
+    UNIXSocket<KBDAction> b(fds[1]);
+
+    KBDAction acs[2] = {key(30), key(31)};
+    const char *p = (const char *) acs;
+    size_t half = sizeof(acs[0]) + sizeof(acs[0]) / 2;
+    REQUIRE( write(fds[0], p, half) == (ssize_t) half );
+    thread rest([&]() {
+        this_thread::sleep_for(chrono::milliseconds(20));
+        write(fds[0], p + half, sizeof(acs) - half);
+    });
+
+    KBDAction buf[8];
+    REQUIRE( b.recvMany(buf, 8) == 2 );
+    REQUIRE( buf[1].ev.code == 31 );
+    rest.join();
+    close(fds[0]);
+}
+
+TEST_CASE("Packets that are never completed time out", "[socket]") {
+    int fds[2];
+    REQUIRE( socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0 );
+    UNIXSocket<KBDAction> a(fds[0]), b(fds[1]);
+
+    KBDAction ac = key(30);
+    REQUIRE( write(fds[0], &ac, sizeof(ac) / 2) == (ssize_t) sizeof(ac) / 2 );
+    KBDAction buf[8];
+    REQUIRE_THROWS_AS( b.recvMany(buf, 8, chrono::milliseconds(10)), SocketTimeout );
+}
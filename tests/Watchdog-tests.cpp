@@ -0,0 +1,36 @@
+#include <catch2/catch.hpp>
+#include <atomic>
+#include <string>
+#include "Watchdog.hpp"
+
+using namespace std;
+using namespace std::chrono;
+
+TEST_CASE("Watchdog reports stalls once", "[watchdog]") {
+    SimClock clock;
+    atomic<int> stalls = 0;
+    atomic<const char *> stage = nullptr;
+    Watchdog wd(milliseconds(50), [&](const char *s) {
+        stage = s;
+        stalls++;
+    }, clock);
+    wd.start();
+
+    for (int i = 0; i < 20; i++) {
+        REQUIRE( !wd.beat("poll") );
+        clock.run(milliseconds(10), milliseconds(10), 1);
+    }
+    REQUIRE( stalls == 0 );
+
+    wd.stage("flush");
+    clock.run(milliseconds(100), milliseconds(10), 1);
+    REQUIRE( stalls == 1 );
+    REQUIRE( string(stage) == "flush" );
+
+    // The next beat reports the recovery, and only that one.
+    REQUIRE( wd.beat("poll") );
+    REQUIRE( !wd.beat("poll") );
+
+    clock.release();
+    wd.stop();
+}
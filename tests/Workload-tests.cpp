@@ -0,0 +1,49 @@
+#include <catch2/catch.hpp>
+#include <map>
+#include "Workload.hpp"
+
+using namespace std;
+
+/** Check that every key alternates between press and release, with
+ *  repeats only while it is held, as a real keyboard would. */
+static void requireRealistic(const vector<struct input_event> &evs) {
+    map<int, int> last;
+    int64_t prev_us = 0;
+    for (const auto &ev : evs) {
+        int64_t t_us = ev.time.tv_sec * 1000000 + ev.time.tv_usec;
+        REQUIRE( t_us >= prev_us );
+        prev_us = t_us;
+        if (ev.type != EV_KEY)
+            continue;
+        int prev = last.count(ev.code) ? last[ev.code] : 0;
+        INFO( "key " << ev.code << " at " << t_us << "us" );
+        if (ev.value == 1)
+            REQUIRE( prev == 0 );
+        else
+            REQUIRE( prev != 0 );
+        last[ev.code] = ev.value;
+    }
+    for (const auto &[code, value] : last)
+        REQUIRE( value == 0 );
+}
+
+TEST_CASE("Generated keys are never pressed while they are held", "[workload]") {
+    Workload w;
+    w.duration_s = 300;
+    for (uint64_t seed = 1; seed <= 5; seed++) {
+        w.seed = seed;
+        Generator gen(w, "The quick brown Fox, the LAZY dog? 42!\n");
+        requireRealistic(gen.run());
+    }
+}
+
+TEST_CASE("Generated repeats, chords and bursts are realistic", "[workload]") {
+    Workload w;
+    w.duration_s = 300;
+    w.rate_kpm = 900;
+    w.repeat_prob = 0.1;
+    w.chord_prob = 0.2;
+    w.hammer_prob = 0.02;
+    Generator gen(w, "Shifted Text And CAPS, ctrl+S and the odd ?!\n");
+    requireRealistic(gen.run());
+}
@@ -0,0 +1,60 @@
+#include <catch2/catch.hpp>
+#include "XTestUDevice.hpp"
+
+extern "C" {
+    #include <unistd.h>
+    #include <stdlib.h>
+    #include <X11/Xlib.h>
+}
+
+using namespace std;
+
+/** Wait for an event of the given type on `win`. */
+static bool waitForEvent(Display *dpy, Window win, int type, XEvent *ev) {
+    const int MAX_SLEEPS = 200;
+    for (int i = 0; i < MAX_SLEEPS; i++) {
+        while (XPending(dpy)) {
+            XNextEvent(dpy, ev);
+            if (ev->type == type && ev->xany.window == win)
+                return true;
+        }
+        usleep(10000);
+    }
+    return false;
+}
+
+/**
+ * Run with a display, e.g `xvfb-run ./hawck-tests`.
+ */
+TEST_CASE("XTest key events", "[XTestUDevice]") {
+    if (!getenv("DISPLAY")) {
+        WARN("No DISPLAY, skipping XTest tests");
+        return;
+    }
+
+    Display *dpy = XOpenDisplay(nullptr);
+    REQUIRE(dpy != nullptr);
+    Window win = XCreateSimpleWindow(dpy, DefaultRootWindow(dpy),
+                                     0, 0, 10, 10, 0, 0, 0);
+    XSelectInput(dpy, win, KeyPressMask | KeyReleaseMask | StructureNotifyMask);
+    XMapWindow(dpy, win);
+    XEvent ev;
+    REQUIRE(waitForEvent(dpy, win, MapNotify, &ev));
+    XSetInputFocus(dpy, win, RevertToParent, CurrentTime);
+    XSync(dpy, False);
+
+    XTestUDevice udev;
+    udev.emit(EV_KEY, KEY_A, 1);
+    udev.emit(EV_SYN, SYN_REPORT, 0);
+    udev.emit(EV_KEY, KEY_A, 0);
+    udev.emit(EV_SYN, SYN_REPORT, 0);
+    udev.done();
+
+    REQUIRE(waitForEvent(dpy, win, KeyPress, &ev));
+    REQUIRE(ev.xkey.keycode == KEY_A + 8);
+    REQUIRE(waitForEvent(dpy, win, KeyRelease, &ev));
+    REQUIRE(ev.xkey.keycode == KEY_A + 8);
+
+    XDestroyWindow(dpy, win);
+    XCloseDisplay(dpy);
+}